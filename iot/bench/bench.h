@@ -0,0 +1,87 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Lille in-tree benchmark harness til [env:native_bench].
+//
+// Et benchmark er en funktion der gør sin setup, og derefter kører den målte operation i
+// `while (state.run())`. Harnessen kalder funktionen med stigende antal iterationer, indtil
+// målingen har kørt længe nok, og rapporterer pr. operation:
+//   ns/op, cycles/op (TSC på x86), allocs/op og bytes/op (heap allokeringer via operator new)
+// samt MB/s når benchmarket melder processerede bytes.
+namespace Bench {
+    class State {
+      public:
+        explicit State(uint64_t iterations) : _iterations(iterations), _remaining(iterations) {}
+
+        bool run() {
+            if (!_started) {
+                _started = true;
+                start();
+            }
+            if (_remaining == 0) {
+                stop();
+                return false;
+            }
+            _remaining--;
+            return true;
+        }
+
+        uint64_t iterations() const { return _iterations; }
+
+        // Bytes behandlet af én operation, bruges til MB/s
+        void setBytesPerOp(uint64_t bytes) { _bytesPerOp = bytes; }
+
+        uint64_t elapsedNanos() const { return _elapsedNanos; }
+        uint64_t elapsedCycles() const { return _elapsedCycles; }
+        uint64_t allocations() const { return _allocations; }
+        uint64_t allocatedBytes() const { return _allocatedBytes; }
+        uint64_t bytesPerOp() const { return _bytesPerOp; }
+
+      private:
+        uint64_t _iterations;
+        uint64_t _remaining;
+        bool _started = false;
+        uint64_t _bytesPerOp = 0;
+
+        uint64_t _startNanos = 0;
+        uint64_t _startCycles = 0;
+        uint64_t _startAllocations = 0;
+        uint64_t _startAllocatedBytes = 0;
+
+        uint64_t _elapsedNanos = 0;
+        uint64_t _elapsedCycles = 0;
+        uint64_t _allocations = 0;
+        uint64_t _allocatedBytes = 0;
+
+        void start();
+        void stop();
+    };
+
+    using Function = std::function<void(State&)>;
+
+    struct Registration {
+        Registration(const char* name, Function function);
+    };
+
+    // Forhindrer at compileren fjerner beregninger hvis resultat ikke bruges
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline void clobberMemory() {
+        asm volatile("" : : : "memory");
+    }
+}
+
+#define BENCH(name)                                                          \
+    static void name(Bench::State& state);                                   \
+    static Bench::Registration name##_registration(#name, name);             \
+    static void name(Bench::State& state)
+
+#endif
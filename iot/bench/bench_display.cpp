@@ -0,0 +1,149 @@
+#include <Arduino.h>
+
+#include "app/epaper_monitor.h"
+#include "bench.h"
+#include "config/constants.h"
+#include "hardware/epaper_display.h"
+
+namespace {
+    constexpr int HISTORY_POINTS = 512;
+
+    // Fuld historik med 10 minutters interval, som efter flere døgns drift
+    void fillHistory(EpaperMonitor& monitor, SourdoughData& data) {
+        data = {};
+        for (int i = 0; i < HISTORY_POINTS; i++) {
+            monitor.addDataPoint(data, 100 + (i * 37) % 150, 1700000000UL + i * 600UL);
+        }
+    }
+}
+
+BENCH(EpaperMonitor_addDataPoint) {
+    static EpaperDisplay display;
+    EpaperMonitor monitor(display);
+    static SourdoughData data;
+    fillHistory(monitor, data);
+
+    unsigned long timestamp = 1700000000UL + HISTORY_POINTS * 600UL;
+    int growth = 100;
+    while (state.run()) {
+        monitor.addDataPoint(data, growth, timestamp);
+        growth = growth >= 250 ? 100 : growth + 3;
+        timestamp += 600;
+    }
+    Bench::doNotOptimize(data.peakGrowth);
+}
+
+BENCH(EpaperMonitor_updatePeakInfo) {
+    static EpaperDisplay display;
+    EpaperMonitor monitor(display);
+    static SourdoughData data;
+    fillHistory(monitor, data);
+
+    while (state.run()) {
+        monitor.updatePeakInfo(data);
+        Bench::doNotOptimize(data.peakHoursAgo);
+    }
+}
+
+BENCH(GrowthLog_append) {
+    static GrowthLog log;
+    log.clear();
+    unsigned long timestamp = 1700000000UL;
+    int growth = 100;
+    while (state.run()) {
+        log.append(timestamp, growth);
+        timestamp += 300 + (growth & 1);
+        growth = growth >= 250 ? 100 : growth + 3;
+    }
+    Bench::doNotOptimize(log.size());
+}
+
+// Hele loggen afkodet, som drawGraph gør det
+BENCH(GrowthLog_decode) {
+    static EpaperDisplay display;
+    EpaperMonitor monitor(display);
+    static SourdoughData data;
+    fillHistory(monitor, data);
+
+    while (state.run()) {
+        GrowthLog::Reader reader(data.history);
+        GrowthSample sample;
+        long sum = 0;
+        while (reader.next(sample)) {
+            sum += sample.growth;
+        }
+        Bench::doNotOptimize(sum);
+    }
+}
+
+BENCH(EpaperMonitor_drawGraph) {
+    static EpaperDisplay display;
+    EpaperMonitor monitor(display);
+    static SourdoughData data;
+    data = monitor.generateMockData();
+
+    while (state.run()) {
+        monitor.drawBackground();
+        monitor.drawGraph(data);
+    }
+}
+
+// Baggrunden tegnet forfra, som før den blev cachet
+BENCH(EpaperMonitor_drawBackground_uncached) {
+    static EpaperDisplay display;
+    EpaperMonitor monitor(display);
+
+    while (state.run()) {
+        monitor.invalidateBackground();
+        monitor.drawBackground();
+    }
+}
+
+// Header baggrund og gitter: brede rektangler og lange linjer
+BENCH(EpaperDisplay_fillRect) {
+    static EpaperDisplay display;
+
+    while (state.run()) {
+        display.clearBuffers();
+        display.fillRect(3, 5, 290, 30, DisplayConstants::COLOR_RED);
+        for (int x = 40; x < 290; x += 25) {
+            display.drawFastVLine(x, 45, 75, DisplayConstants::COLOR_BLACK);
+        }
+        display.drawFastHLine(2, 35, 292, DisplayConstants::COLOR_BLACK);
+    }
+}
+
+// Frame upload inkl. SPI shim og BUSY polling med virtuel klokke. En pixel skifter pr. iteration,
+// så det er partial stien der måles
+BENCH(EpaperDisplay_updateDisplay) {
+    static EpaperDisplay display;
+    static bool initialized = false;
+    if (!initialized) {
+        display.begin();
+        initialized = true;
+    }
+
+    uint16_t color = DisplayConstants::COLOR_BLACK;
+    state.setBytesPerOp(2 * DisplayConstants::EPD_BUFFER_SIZE);
+    while (state.run()) {
+        display.drawPixel(100, 50, color);
+        display.updateDisplay();
+        color = color == DisplayConstants::COLOR_BLACK ? DisplayConstants::COLOR_WHITE : DisplayConstants::COLOR_BLACK;
+    }
+}
+
+// Uændret frame: kun sammenligningen med den viste frame
+BENCH(EpaperDisplay_updateDisplay_unchanged) {
+    static EpaperDisplay display;
+    static bool initialized = false;
+    if (!initialized) {
+        display.begin();
+        display.updateDisplay();
+        initialized = true;
+    }
+
+    state.setBytesPerOp(2 * DisplayConstants::EPD_BUFFER_SIZE);
+    while (state.run()) {
+        display.updateDisplay();
+    }
+}
@@ -0,0 +1,22 @@
+#include <Arduino.h>
+
+#include "bench.h"
+#include "logging/logger.h"
+
+static const char* TAG = "Bench";
+
+// Linje der faktisk skrives; Serial kasseres i native_bench, så det er formatering + Print der måles
+BENCH(Logger_info) {
+    int cycle = 0;
+    while (state.run()) {
+        LOG_I(TAG, "Sensor read OK - Temp: %.2f°C, Humidity: %.1f%%, Rise: %d%%", 22.37f, 64.8f, cycle++);
+    }
+}
+
+// LOG_D med runtime level INFO: kaldet sker men filtreres i Logger::log
+BENCH(Logger_debugFiltered) {
+    int cycle = 0;
+    while (state.run()) {
+        LOG_D(TAG, "Processing OTA chunk %d/%d", cycle++, 272);
+    }
+}
@@ -0,0 +1,224 @@
+// Entry point for [env:native_bench]. Kør med:
+//   pio run -e native_bench -t exec
+// Argumenter (via program_args eller direkte på den byggede binær):
+//   --filter=<tekst>   kør kun benchmarks hvis navn indeholder teksten
+//   --min-time=<ms>    minimum måletid pr. benchmark (default 200 ms)
+//   --csv=<fil>        skriv også resultaterne som CSV, så de kan sammenlignes mellem commits
+#include "bench.h"
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include "logging/logger.h"
+#include "native_hal.h"
+
+namespace {
+    std::atomic<uint64_t> totalAllocations{0};
+    std::atomic<uint64_t> totalAllocatedBytes{0};
+
+    struct Entry {
+        const char* name;
+        Bench::Function function;
+    };
+
+    std::vector<Entry>& registry() {
+        static std::vector<Entry> entries;
+        return entries;
+    }
+
+    uint64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Cycle counter: TSC på x86, virtuel counter på aarch64, ellers nanosekunder
+    uint64_t nowCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#else
+        return nowNanos();
+#endif
+    }
+
+    void* countedAlloc(size_t size) {
+        totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        totalAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        void* ptr = malloc(size == 0 ? 1 : size);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+
+    struct Result {
+        const char* name;
+        uint64_t iterations;
+        double nanosPerOp;
+        double cyclesPerOp;
+        double allocsPerOp;
+        double bytesPerOp;
+        double megabytesPerSecond;
+    };
+
+    Result runBenchmark(const Entry& entry, uint64_t minTimeNanos) {
+        uint64_t iterations = 1;
+
+        while (true) {
+            Bench::State state(iterations);
+            entry.function(state);
+
+            uint64_t elapsed = std::max<uint64_t>(state.elapsedNanos(), 1);
+            if (elapsed >= minTimeNanos || iterations >= 1000000000ULL) {
+                double ops = static_cast<double>(iterations);
+                Result result = {};
+                result.name = entry.name;
+                result.iterations = iterations;
+                result.nanosPerOp = state.elapsedNanos() / ops;
+                result.cyclesPerOp = state.elapsedCycles() / ops;
+                result.allocsPerOp = state.allocations() / ops;
+                result.bytesPerOp = state.allocatedBytes() / ops;
+                if (state.bytesPerOp() > 0) {
+                    result.megabytesPerSecond = state.bytesPerOp() * ops / (elapsed / 1e9) / (1024.0 * 1024.0);
+                }
+                return result;
+            }
+
+            // Ram målet med lidt margin, men gang højst med 10 pr. runde
+            double predicted = static_cast<double>(iterations) * minTimeNanos * 1.4 / elapsed;
+            iterations = static_cast<uint64_t>(std::min(predicted, static_cast<double>(iterations) * 10.0));
+            iterations = std::max<uint64_t>(iterations, state.iterations() + 1);
+        }
+    }
+
+    const char* argValue(const char* arg, const char* name) {
+        size_t length = strlen(name);
+        return strncmp(arg, name, length) == 0 ? arg + length : nullptr;
+    }
+}
+
+void* operator new(size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace Bench {
+    void State::start() {
+        clobberMemory();
+        _startAllocations = totalAllocations.load(std::memory_order_relaxed);
+        _startAllocatedBytes = totalAllocatedBytes.load(std::memory_order_relaxed);
+        _startNanos = nowNanos();
+        _startCycles = nowCycles();
+    }
+
+    void State::stop() {
+        uint64_t cycles = nowCycles();
+        uint64_t nanos = nowNanos();
+        clobberMemory();
+        _elapsedCycles = cycles - _startCycles;
+        _elapsedNanos = nanos - _startNanos;
+        _allocations = totalAllocations.load(std::memory_order_relaxed) - _startAllocations;
+        _allocatedBytes = totalAllocatedBytes.load(std::memory_order_relaxed) - _startAllocatedBytes;
+    }
+
+    Registration::Registration(const char* name, Function function) {
+        registry().push_back({name, std::move(function)});
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    const char* csvPath = nullptr;
+    uint64_t minTimeMs = 200;
+
+    for (int i = 1; i < argc; i++) {
+        if (const char* value = argValue(argv[i], "--filter=")) {
+            filter = value;
+        } else if (const char* value = argValue(argv[i], "--min-time=")) {
+            minTimeMs = strtoull(value, nullptr, 10);
+        } else if (const char* value = argValue(argv[i], "--csv=")) {
+            csvPath = value;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // Virtuel klokke så delay() i koden under test ikke sover, og Serial output kasseres
+    // så Logger stadig formaterer men ikke skriver til terminalen
+    NativeHal::useVirtualClock(true);
+    NativeHal::setSerialEnabled(false);
+    Logger::begin(LOG_INFO, false, false);
+
+    std::vector<Entry>& entries = registry();
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return strcmp(a.name, b.name) < 0; });
+
+    std::vector<Result> results;
+    printf("%-40s %12s %12s %12s %10s %10s %10s\n", "benchmark", "iterations", "ns/op", "cycles/op", "allocs/op",
+           "bytes/op", "MB/s");
+    for (const Entry& entry : entries) {
+        if (filter && !strstr(entry.name, filter)) {
+            continue;
+        }
+
+        Result r = runBenchmark(entry, minTimeMs * 1000000ULL);
+        results.push_back(r);
+        printf("%-40s %12llu %12.1f %12.1f %10.2f %10.1f", r.name, static_cast<unsigned long long>(r.iterations),
+               r.nanosPerOp, r.cyclesPerOp, r.allocsPerOp, r.bytesPerOp);
+        if (r.megabytesPerSecond > 0) {
+            printf(" %10.1f", r.megabytesPerSecond);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (csvPath) {
+        FILE* csv = fopen(csvPath, "w");
+        if (!csv) {
+            fprintf(stderr, "Could not open %s: %s\n", csvPath, strerror(errno));
+            return 1;
+        }
+        fprintf(csv, "benchmark,iterations,ns_per_op,cycles_per_op,allocs_per_op,bytes_per_op,mb_per_s\n");
+        for (const Result& r : results) {
+            fprintf(csv, "%s,%llu,%.2f,%.2f,%.3f,%.1f,%.1f\n", r.name, static_cast<unsigned long long>(r.iterations),
+                    r.nanosPerOp, r.cyclesPerOp, r.allocsPerOp, r.bytesPerOp, r.megabytesPerSecond);
+        }
+        fclose(csv);
+    }
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "network/crc32.h"
+#include "network/ed25519.h"
+#include "network/mqtt_manager.h"
+#include "network/mqtt_protocol.h"
+#include "network/mqtt_topics.h"
+#include "network/sha256.h"
+
+namespace {
+    // Minimal broker på loopback: svarer CONNACK på første pakke og kasserer resten, så
+    // MqttManager::publish kan måles med den rigtige PubSubClient socket sti.
+    class SinkBroker {
+      public:
+        SinkBroker() {
+            _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            socklen_t length = sizeof(addr);
+            if (bind(_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(_listenFd, 1) != 0 ||
+                getsockname(_listenFd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+                return;
+            }
+            _port = ntohs(addr.sin_port);
+            _worker = std::thread([this]() { serve(); });
+        }
+
+        ~SinkBroker() {
+            shutdown(_listenFd, SHUT_RDWR);
+            if (_clientFd >= 0) shutdown(_clientFd, SHUT_RDWR);
+            if (_worker.joinable()) _worker.join();
+            close(_listenFd);
+        }
+
+        uint16_t port() const { return _port; }
+
+      private:
+        int _listenFd = -1;
+        int _clientFd = -1;
+        uint16_t _port = 0;
+        std::thread _worker;
+
+        void serve() {
+            _clientFd = accept(_listenFd, nullptr, nullptr);
+            if (_clientFd < 0) return;
+
+            std::vector<uint8_t> buffer(64 * 1024);
+            bool connackSent = false;
+            while (recv(_clientFd, buffer.data(), buffer.size(), 0) > 0) {
+                if (!connackSent) {
+                    const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+                    send(_clientFd, connack, sizeof(connack), 0);
+                    connackSent = true;
+                }
+            }
+            close(_clientFd);
+        }
+    };
+
+    void fillTelemetry(JsonDocument& doc) {
+        doc[MqttProtocol::TelemetryFields::EPOCH_TIME] = 1735689600UL;
+        doc[MqttProtocol::TelemetryFields::TIMESTAMP] = "2025-01-01T00:00:00Z";
+        doc[MqttProtocol::TelemetryFields::LOCAL_TIME] = "2025-01-01T01:00:00+01:00";
+        doc[MqttProtocol::TelemetryFields::TEMPERATURE] = 22.4f;
+        doc[MqttProtocol::TelemetryFields::HUMIDITY] = 64.8f;
+        doc[MqttProtocol::TelemetryFields::RISE] = 137.5f;
+        doc[MqttProtocol::TelemetryFields::FEEDING_NUMBER] = 3;
+    }
+
+    // Én OTA chunk som serveren sender den
+    std::vector<uint8_t> makeOtaChunk() {
+        std::vector<uint8_t> chunk(4096);
+        for (size_t i = 0; i < chunk.size(); i++) {
+            chunk[i] = static_cast<uint8_t>((i * 31) ^ (i >> 7));
+        }
+        return chunk;
+    }
+
+    void runCrc32(Bench::State& state, uint32_t (*update)(uint32_t, const uint8_t*, size_t)) {
+        std::vector<uint8_t> chunk = makeOtaChunk();
+        uint32_t crc = 0;
+        state.setBytesPerOp(chunk.size());
+        while (state.run()) {
+            crc = update(crc, chunk.data(), chunk.size());
+        }
+        Bench::doNotOptimize(crc);
+    }
+}
+
+// Den backend OtaManager bruger
+BENCH(Crc32_update_4k) {
+    runCrc32(state, Crc32::update);
+}
+
+BENCH(Crc32_sliceBy8_4k) {
+    runCrc32(state, Crc32::updateSliceBy8);
+}
+
+// Den oprindelige bit-for-bit implementering, som reference
+BENCH(Crc32_bitwise_4k) {
+    runCrc32(state, Crc32::updateBitwise);
+}
+
+// Hashes sammen med CRC'en for hver chunk writeren skriver
+BENCH(Sha256_update_4k) {
+    std::vector<uint8_t> chunk = makeOtaChunk();
+    Sha256 sha;
+    state.setBytesPerOp(chunk.size());
+    while (state.run()) {
+        sha.update(chunk.data(), chunk.size());
+    }
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    sha.finish(digest);
+    Bench::doNotOptimize(digest[0]);
+}
+
+// Én gang pr. opdatering, over imagets digest
+BENCH(Ed25519_verify_digest) {
+    uint8_t seed[Ed25519::SEED_SIZE] = {42};
+    uint8_t digest[Sha256::DIGEST_SIZE] = {1, 2, 3};
+    uint8_t publicKey[Ed25519::PUBLIC_KEY_SIZE];
+    uint8_t signature[Ed25519::SIGNATURE_SIZE];
+    Ed25519::derivePublicKey(seed, publicKey);
+    Ed25519::sign(seed, digest, sizeof(digest), signature);
+
+    bool valid = true;
+    while (state.run()) {
+        valid &= Ed25519::verify(signature, digest, sizeof(digest), publicKey);
+    }
+    Bench::doNotOptimize(valid);
+}
+
+BENCH(MqttTopics_getTelemetryTopic) {
+    MqttTopics topics("8c1f64a2b3c4");
+    while (state.run()) {
+        String topic = topics.getTelemetryTopic();
+        Bench::doNotOptimize(topic);
+    }
+}
+
+// Alle topics main.cpp slår op ved opstart og pr. cyklus
+BENCH(MqttTopics_allGetters) {
+    MqttTopics topics("8c1f64a2b3c4");
+    while (state.run()) {
+        Bench::doNotOptimize(topics.getTelemetryTopic());
+        Bench::doNotOptimize(topics.getDiagnosticsRequestTopic());
+        Bench::doNotOptimize(topics.getDiagnosticsResponseTopic());
+        Bench::doNotOptimize(topics.getOtaStartTopic());
+        Bench::doNotOptimize(topics.getOtaChunkTopic());
+        Bench::doNotOptimize(topics.getOtaStatusTopic());
+        Bench::doNotOptimize(topics.getOtaCheckTopic());
+    }
+}
+
+BENCH(Telemetry_serializeJson) {
+    DynamicJsonDocument doc(512);
+    fillTelemetry(doc);
+    while (state.run()) {
+        String json;
+        serializeJson(doc, json);
+        Bench::doNotOptimize(json);
+    }
+}
+
+// Serialisering + socket write mod loopback broker
+BENCH(MqttManager_publishJson) {
+    static SinkBroker broker;
+    static MqttManager mqttManager;
+    static bool connected = broker.port() != 0 &&
+                            mqttManager.begin("127.0.0.1", broker.port(), "", "", "bench-analyzer");
+    if (!connected) {
+        fprintf(stderr, "MqttManager_publishJson: could not connect to loopback broker\n");
+        while (state.run()) {
+        }
+        return;
+    }
+
+    MqttTopics topics("8c1f64a2b3c4");
+    String telemetryTopic = topics.getTelemetryTopic();
+    DynamicJsonDocument doc(512);
+    fillTelemetry(doc);
+
+    while (state.run()) {
+        Bench::doNotOptimize(mqttManager.publish(telemetryTopic.c_str(), doc));
+    }
+}
@@ -0,0 +1,131 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "config/constants.h"
+#include "heatshrink_encoder.h"
+#include "native_hal.h"
+#include "network/crc32.h"
+#include "network/heatshrink_decoder.h"
+#include "network/mqtt_protocol.h"
+#include "network/ota_manager.h"
+
+namespace {
+    constexpr uint32_t IMAGE_SIZE = 128 * 1024;
+    constexpr uint32_t CHUNK_SIZE = OtaConstants::MAX_CHUNK_SIZE;
+
+    // Ca. sektor erase + program på ESP32 flash, og afstand mellem chunks fra brokeren
+    constexpr uint32_t SLOW_FLASH_US_PER_KB = 1200;
+    constexpr uint32_t NETWORK_GAP_US = 5000;
+
+    constexpr uint8_t WINDOW_BITS = 11;
+    constexpr uint8_t LOOKAHEAD_BITS = 4;
+
+    // Firmware-lignende indhold: korte gentagne sekvenser (instruktioner, tabeller) blandet med støj
+    std::vector<uint8_t> makeImage() {
+        std::vector<uint8_t> image(IMAGE_SIZE);
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < image.size(); i++) {
+            seed = seed * 1103515245 + 12345;
+            image[i] = (seed >> 16) % 3 == 0 ? static_cast<uint8_t>(seed >> 24) : static_cast<uint8_t>(i % 64);
+        }
+        return image;
+    }
+
+    // Hele OTA forløbet gennem handleOtaMessage som det sker fra MQTT callback'en.
+    // Flash og netværk simuleres med rigtig tid, så overlap mellem modtagelse og flash skrivning ses i ns/op.
+    void runTransfer(Bench::State& state, uint32_t flashUsPerKb, uint32_t networkGapUs, bool compressed = false) {
+        std::vector<uint8_t> image = makeImage();
+        std::vector<uint8_t> stream =
+            compressed ? HeatshrinkEncoder::encode(image.data(), image.size(), WINDOW_BITS, LOOKAHEAD_BITS) : image;
+
+        const String startTopic = "analyzer/bench/ota/start";
+        const String chunkTopic = "analyzer/bench/ota/chunk";
+
+        DynamicJsonDocument startDoc(256);
+        startDoc[MqttProtocol::OtaFields::VERSION] = "bench";
+        startDoc[MqttProtocol::OtaFields::SIZE] = stream.size();
+        startDoc[MqttProtocol::OtaFields::CRC32] = Crc32::update(0, image.data(), image.size());
+        if (compressed) {
+            startDoc[MqttProtocol::OtaFields::COMPRESSION] = MqttProtocol::OtaFields::CompressionValues::HEATSHRINK;
+            startDoc[MqttProtocol::OtaFields::IMAGE_SIZE] = image.size();
+            startDoc[MqttProtocol::OtaFields::WINDOW_BITS] = WINDOW_BITS;
+            startDoc[MqttProtocol::OtaFields::LOOKAHEAD_BITS] = LOOKAHEAD_BITS;
+        }
+        String startPayload;
+        serializeJson(startDoc, startPayload);
+
+        std::vector<uint8_t> chunk(OtaConstants::CHUNK_HEADER_SIZE + CHUNK_SIZE);
+        OtaManager otaManager;
+        bool restarted = false;
+        NativeHal::setRestartHandler([&restarted]() { restarted = true; });
+        NativeHal::setFlashWriteDelay(flashUsPerKb);
+
+        state.setBytesPerOp(IMAGE_SIZE);
+        while (state.run()) {
+            restarted = false;
+            otaManager.handleOtaMessage(startTopic, reinterpret_cast<const uint8_t*>(startPayload.c_str()),
+                                        startPayload.length(), startTopic, chunkTopic);
+
+            for (uint32_t offset = 0, index = 0; offset < stream.size(); offset += CHUNK_SIZE, index++) {
+                uint32_t size = std::min<uint32_t>(CHUNK_SIZE, stream.size() - offset);
+                memcpy(chunk.data(), &index, 4);
+                memcpy(chunk.data() + 4, &size, 4);
+                memcpy(chunk.data() + OtaConstants::CHUNK_HEADER_SIZE, stream.data() + offset, size);
+                if (networkGapUs > 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(networkGapUs));
+                }
+                otaManager.handleOtaMessage(chunkTopic, chunk.data(), OtaConstants::CHUNK_HEADER_SIZE + size,
+                                            startTopic, chunkTopic);
+            }
+
+            if (!restarted) {
+                fprintf(stderr, "OTA transfer did not complete (status %d)\n",
+                        static_cast<int>(otaManager.getStatus()));
+            }
+        }
+
+        NativeHal::setFlashWriteDelay(0);
+        NativeHal::setRestartHandler(nullptr);
+    }
+}
+
+// Uden simuleret latens: overhead fra kopiering, køer og CRC
+BENCH(OtaManager_transfer_128k) {
+    runTransfer(state, 0, 0);
+}
+
+// Langsom flash og netværk: med pipelinen overlapper de i stedet for at lægges sammen
+BENCH(OtaManager_transfer_128k_slowFlash) {
+    runTransfer(state, SLOW_FLASH_US_PER_KB, NETWORK_GAP_US);
+}
+
+// Færre chunks over netværket; udpakningen sker i writer tasken parallelt med modtagelsen
+BENCH(OtaManager_transfer_128k_compressed_slowFlash) {
+    runTransfer(state, SLOW_FLASH_US_PER_KB, NETWORK_GAP_US, true);
+}
+
+BENCH(HeatshrinkDecoder_decode_128k) {
+    std::vector<uint8_t> image = makeImage();
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(image.data(), image.size(), WINDOW_BITS, LOOKAHEAD_BITS);
+    HeatshrinkDecoder decoder;
+    uint32_t checksum = 0;
+    auto sink = [&checksum](const uint8_t* data, size_t length) {
+        checksum += data[length - 1];
+        return true;
+    };
+
+    state.setBytesPerOp(image.size());
+    while (state.run()) {
+        decoder.begin(WINDOW_BITS, LOOKAHEAD_BITS);
+        for (size_t offset = 0; offset < packed.size(); offset += CHUNK_SIZE) {
+            decoder.decode(packed.data() + offset, std::min<size_t>(CHUNK_SIZE, packed.size() - offset), sink);
+        }
+        decoder.finish(sink);
+    }
+    Bench::doNotOptimize(checksum);
+}
@@ -0,0 +1,98 @@
+#include <Arduino.h>
+
+#include "bench.h"
+#include "config/constants.h"
+#include "util/ring_buffer.h"
+
+namespace {
+    constexpr int CAPACITY = 128;
+    // Den tidligere historik: 144 pladser og modulo ved hver adgang. Løkken læser lige så mange elementer som
+    // RingBuffer varianterne
+    constexpr int MODULO_CAPACITY = 144;
+
+    // Fuld og wrappet, som historikken efter lang tids drift
+    template <typename Buffer>
+    void fill(Buffer& buffer) {
+        buffer.clear();
+        for (int i = 0; i < CAPACITY + CAPACITY / 3; i++) {
+            buffer.pushBack(i * 7);
+        }
+    }
+
+    struct ModuloHistory {
+        int values[MODULO_CAPACITY];
+        int count;
+        int oldest;
+    };
+
+    void fill(ModuloHistory& history) {
+        history.count = CAPACITY;
+        history.oldest = MODULO_CAPACITY / 3;
+        for (int i = 0; i < MODULO_CAPACITY; i++) {
+            history.values[i] = i * 7;
+        }
+    }
+}
+
+BENCH(RingBuffer_pushBack) {
+    static RingBuffer<int, CAPACITY> buffer;
+    fill(buffer);
+    int value = 0;
+    while (state.run()) {
+        buffer.pushBack(value++);
+    }
+    Bench::doNotOptimize(buffer.back());
+}
+
+BENCH(RingBuffer_sumIndexed) {
+    static RingBuffer<int, CAPACITY> buffer;
+    fill(buffer);
+    while (state.run()) {
+        int sum = 0;
+        for (size_t i = 0; i < buffer.size(); i++) {
+            sum += buffer[i];
+        }
+        Bench::doNotOptimize(sum);
+    }
+}
+
+BENCH(RingBuffer_sumIterator) {
+    static RingBuffer<int, CAPACITY> buffer;
+    fill(buffer);
+    while (state.run()) {
+        int sum = 0;
+        for (int value : buffer) {
+            sum += value;
+        }
+        Bench::doNotOptimize(sum);
+    }
+}
+
+BENCH(RingBuffer_sumSegments) {
+    static RingBuffer<int, CAPACITY> buffer;
+    fill(buffer);
+    while (state.run()) {
+        int sum = 0;
+        for (int value : buffer.firstSegment()) {
+            sum += value;
+        }
+        for (int value : buffer.secondSegment()) {
+            sum += value;
+        }
+        Bench::doNotOptimize(sum);
+    }
+}
+
+// Til sammenligning: samme løkke som den håndskrevne historik i SourdoughData havde
+BENCH(RingBuffer_sumModuloBaseline) {
+    static ModuloHistory history;
+    fill(history);
+    while (state.run()) {
+        int sum = 0;
+        for (int i = 0; i < history.count; i++) {
+            sum += history.values[(history.oldest + i) % MODULO_CAPACITY];
+        }
+        Bench::doNotOptimize(sum);
+        Bench::clobberMemory();
+    }
+}
@@ -0,0 +1,49 @@
+#include <Arduino.h>
+
+#include "bench.h"
+#include "config/constants.h"
+#include "hardware/sensor_manager.h"
+
+namespace {
+    // Et sæt samples som collectMultipleSamples() ser dem, inkl. én outlier
+    const float TEMP_SAMPLES[Sensors::MAX_SAMPLES] = {22.1f, 22.3f, 21.9f, 22.0f, 35.7f,
+                                                      22.2f, 22.4f, 21.8f, 22.1f, 22.0f};
+    const int DISTANCE_SAMPLES[Sensors::MAX_SAMPLES] = {412, 409, 415, 411, 250, 410, 413, 408, 414, 411};
+}
+
+// Kopien af samples er med i målingen, da funktionerne sorterer/filtrerer in-place
+BENCH(SensorManager_calculateMedian) {
+    float samples[Sensors::MAX_SAMPLES];
+    while (state.run()) {
+        memcpy(samples, TEMP_SAMPLES, sizeof(samples));
+        Bench::doNotOptimize(SensorManager::calculateMedian(samples, Sensors::MAX_SAMPLES));
+    }
+}
+
+BENCH(SensorManager_calculateMedianInt) {
+    int samples[Sensors::MAX_SAMPLES];
+    while (state.run()) {
+        memcpy(samples, DISTANCE_SAMPLES, sizeof(samples));
+        Bench::doNotOptimize(SensorManager::calculateMedianInt(samples, Sensors::MAX_SAMPLES));
+    }
+}
+
+BENCH(SensorManager_removeOutliers) {
+    float samples[Sensors::MAX_SAMPLES];
+    while (state.run()) {
+        memcpy(samples, TEMP_SAMPLES, sizeof(samples));
+        int size = Sensors::MAX_SAMPLES;
+        SensorManager::removeOutliers(samples, size, Sensors::TEMP_MIN, Sensors::TEMP_MAX);
+        Bench::doNotOptimize(size);
+    }
+}
+
+BENCH(SensorManager_removeOutliersInt) {
+    int samples[Sensors::MAX_SAMPLES];
+    while (state.run()) {
+        memcpy(samples, DISTANCE_SAMPLES, sizeof(samples));
+        int size = Sensors::MAX_SAMPLES;
+        SensorManager::removeOutliersInt(samples, size, Sensors::TOF_DISTANCE_MIN, Sensors::TOF_DISTANCE_MAX);
+        Bench::doNotOptimize(size);
+    }
+}
@@ -113,6 +113,18 @@ def generate_settings_file(*args, **kwargs):
     
     print(f"*** Generated settings.json from template ***\n")
 
+def add_ota_signing_key():
+    # Public key til OTA signaturer (se tools/ota_pack); kompileres ind i firmwaren
+    key = read_env_file().get("OTA_SIGNING_PUBLIC_KEY") or os.getenv("OTA_SIGNING_PUBLIC_KEY")
+    if not key:
+        print("*** WARNING: OTA_SIGNING_PUBLIC_KEY not set, OTA images will not be signature checked")
+        return
+    if not re.fullmatch(r'[0-9a-fA-F]{64}', key):
+        print(f"*** ERROR: OTA_SIGNING_PUBLIC_KEY must be 64 hex characters")
+        sys.exit(1)
+    env.Append(CPPDEFINES=[("OTA_SIGNING_PUBLIC_KEY", env.StringifyMacro(key))])
+    print(f"*** OTA signing key: {key}")
+
 if not hasattr(env, '_settings_actions_added'):
     env.AddPreAction("buildfs", generate_settings_file)
     env.AddPreAction("uploadfs", generate_settings_file)
@@ -121,5 +133,7 @@ if not hasattr(env, '_settings_actions_added'):
 else:
     print("*** Pre-actions already added, skipping")
 
+add_ota_signing_key()
+
 print("*** Running generate_settings_file immediately ***")
 generate_settings_file()
\ No newline at end of file
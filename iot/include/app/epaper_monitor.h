@@ -3,7 +3,9 @@
 
 #include <Arduino.h>
 
+#include "app/growth_log.h"
 #include "config/constants.h"
+#include "config/time_utils.h"
 #include "hardware/epaper_display.h"
 
 struct SourdoughData {
@@ -19,26 +21,68 @@ struct SourdoughData {
     int peakGrowth;
     float peakHoursAgo;
 
-    int growthValues[MonitoringConstants::MAX_DATA_POINTS];
-    unsigned long timestamps[MonitoringConstants::MAX_DATA_POINTS]; 
-    int dataCount;
-    int oldestIndex;
-    bool bufferFull;
+    // Kodet historik i fuld opløsning; dækker dage i samme hukommelse som de tidligere 144 punkter
+    GrowthLog history;
 };
 
 class EpaperMonitor {
   public:
     EpaperMonitor(EpaperDisplay& display);
+    static void clearHistory(SourdoughData& data);
     void addDataPoint(SourdoughData& data, int growthPercentage, unsigned long timestamp);
+    // Kurven fra ældst til nyest; punkter før since springes over
+    template <typename Visitor>
+    static void forEachCurvePoint(const SourdoughData& data, unsigned long since, Visitor visit);
     void updateDisplay(const SourdoughData& data);
     SourdoughData generateMockData();
     void updatePeakInfo(SourdoughData& data);
 
+    // Statisk baggrund (header linje, graframme, gitter og etiketter). Tegnes første gang og kopieres
+    // derefter ind fra displayets cache
+    void drawBackground();
+    void invalidateBackground();
+    // Kurven og peak markeringen oven på baggrunden
+    void drawGraph(const SourdoughData& data);
+
   private:
+    struct GraphLayout {
+        int graphX;
+        int graphY;
+        int graphWidth;
+        int graphHeight;
+        int xLabelStartX;
+        unsigned long windowMinutes;
+        int gridInterval;
+        int numGridLines;
+        int gridWidth;
+    };
+
     EpaperDisplay& _display;
+    bool _backgroundCached;
+
+    GraphLayout graphLayout() const;
+    static bool findPeak(const SourdoughData& data, GrowthSample& peak);
+    void drawGraphFrame();
     void drawHeader(const SourdoughData& data);
     void drawBattery(int level);
-    void drawGraph(const SourdoughData& data);
 };
 
-#endif
\ No newline at end of file
+template <typename Visitor>
+void EpaperMonitor::forEachCurvePoint(const SourdoughData& data, unsigned long since, Visitor visit) {
+    if (data.history.empty()) {
+        return;
+    }
+
+    // Sammenlignet som afstand fra since, så tidsstempler der er wrappet (mockdata kort efter boot) virker
+    unsigned long span = data.history.newest().timestamp - since;
+
+    GrowthLog::Reader reader(data.history);
+    GrowthSample sample;
+    while (reader.next(sample)) {
+        if (sample.timestamp - since <= span) {
+            visit(sample);
+        }
+    }
+}
+
+#endif
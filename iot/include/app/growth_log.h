@@ -0,0 +1,120 @@
+#ifndef GROWTH_LOG_H
+#define GROWTH_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "config/constants.h"
+#include "util/ring_buffer.h"
+
+struct GrowthSample {
+    unsigned long timestamp;
+    int growth;
+
+    bool operator==(const GrowthSample& other) const {
+        return timestamp == other.timestamp && growth == other.growth;
+    }
+};
+
+// Blok med et absolut startpunkt efterfulgt af delta kodede punkter. Blokke afkodes uafhængigt af hinanden,
+// så den ældste kan smides væk uden at de andre skal kodes om. 64 bytes på target.
+struct GrowthBlock {
+    unsigned long baseTimestamp;
+    unsigned long peakTimestamp; // Første forekomst af peakGrowth i blokken
+    int32_t baseGrowth;
+    int32_t peakGrowth;
+    uint8_t count;  // Punkter inklusive startpunktet
+    uint8_t length; // Brugte bytes i data
+    uint8_t data[MonitoringConstants::HISTORY_BLOCK_BYTES];
+};
+
+// Vækstmålinger i fuld opløsning, komprimeret. Målinger kommer med næsten fast interval og vækst der ændrer
+// sig få procent ad gangen, så hvert punkt gemmes som ændringen i tidsintervallet (delta of delta) og
+// ændringen i vækst, begge zig-zag kodet:
+//   0ddd gggg   ét byte når tidsintervallet ændres med -4..3 s og væksten med -8..7
+//   1000 0000   efterfulgt af begge som varints
+// Typisk ét byte pr. punkt mod 8 for GrowthSample. Når loggen er fuld, fjernes den ældste blok.
+//
+// Ingen konstruktør, som RingBuffer: værdiinitialiser ({}) eller kald clear() før brug.
+class GrowthLog {
+public:
+    // Afkoder punkterne fra ældst til nyest uden at pakke hele loggen ud
+    class Reader {
+    public:
+        // Starter ved blok firstBlock (0 er den ældste)
+        explicit Reader(const GrowthLog& log, size_t firstBlock = 0);
+        bool next(GrowthSample& sample);
+
+    private:
+        const GrowthLog& _log;
+        size_t _block;
+        uint8_t _offset;
+        uint8_t _index;
+        GrowthSample _previous;
+        int32_t _interval;
+    };
+
+    void clear();
+    // Returnerer antal ældre punkter der blev fjernet for at gøre plads
+    size_t append(unsigned long timestamp, int growth);
+
+    bool empty() const { return _blocks.empty(); }
+    size_t size() const { return _size; }
+    // Kræver at loggen ikke er tom
+    GrowthSample oldest() const;
+    GrowthSample newest() const { return _newest; }
+    // Højeste vækst fra since til nyeste punkt (ældste ved lighed); false hvis der ingen punkter er. Blokke
+    // helt inden for vinduet klares med peak fra headeren, kun blokken der krydser since afkodes
+    bool peak(GrowthSample& sample, unsigned long since) const;
+    // Hele loggen nedsamplet til højst buckets punkter fra ældst til nyest: højeste vækst i hvert lige langt
+    // tidsinterval, så en peak ikke forsvinder. Tomme intervaller springes over. Returnerer intervallets længde
+    template <typename Visitor>
+    unsigned long forEachBucketPeak(size_t buckets, Visitor visit) const;
+
+    size_t blockCount() const { return _blocks.size(); }
+    const GrowthBlock& block(size_t index) const { return _blocks[index]; }
+    size_t encodedBytes() const;
+
+private:
+    RingBuffer<GrowthBlock, MonitoringConstants::HISTORY_BLOCKS> _blocks;
+    GrowthSample _newest;
+    int32_t _interval; // Tidsintervallet til forrige punkt i nyeste blok
+    uint32_t _size;
+
+    bool appendToBlock(GrowthBlock& block, unsigned long timestamp, int growth);
+};
+
+template <typename Visitor>
+unsigned long GrowthLog::forEachBucketPeak(size_t buckets, Visitor visit) const {
+    if (empty() || buckets == 0) {
+        return 0;
+    }
+
+    // +1 så det nyeste punkt havner i sidste interval og ikke ét ud over
+    unsigned long start = oldest().timestamp;
+    unsigned long bucketSeconds = (_newest.timestamp - start) / buckets + 1;
+
+    Reader reader(*this);
+    GrowthSample sample;
+    GrowthSample bucketPeak = {};
+    unsigned long bucket = 0;
+    bool open = false;
+    while (reader.next(sample)) {
+        unsigned long index = (sample.timestamp - start) / bucketSeconds;
+        if (open && index != bucket) {
+            visit(bucketPeak);
+            open = false;
+        }
+        if (!open || sample.growth > bucketPeak.growth) {
+            bucketPeak = sample;
+            bucket = index;
+            open = true;
+        }
+    }
+    if (open) {
+        visit(bucketPeak);
+    }
+    return bucketSeconds;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <cstddef>
+
+#include "app/epaper_monitor.h"
+
+// Holder vækst historikken i live på tværs af genstarter. To lag:
+//   - En kopi i RTC_NOINIT hukommelse med checksum. Overlever deep sleep, ESP.restart(), watchdog og
+//     brownout resets, men ikke strømtab eller en firmware med et andet layout.
+//   - En append-only journal i LittleFS med de rå punkter. Punkterne samles i RTC og skrives
+//     HISTORY_JOURNAL_BATCH ad gangen for at spare flash skrivninger, så et strømtab koster højst et batch.
+// Arbejdskopien i SourdoughData ligger fortsat i DRAM, som er hurtigere at tegne grafen fra.
+class HistoryStore {
+public:
+    // Fylder data fra RTC kopien hvis den er intakt, ellers ved at afspille journalen gennem monitor.
+    // LittleFS skal være mounted. Returnerer false hvis der ikke var noget at gendanne.
+    bool restore(EpaperMonitor& monitor, SourdoughData& data);
+
+    // Kaldes efter EpaperMonitor::addDataPoint med samme punkt
+    void record(const SourdoughData& data, unsigned long timestamp, int growth);
+
+    // Skriver ventende punkter til journalen, f.eks. før en genstart til ny firmware
+    bool flush();
+
+    size_t pendingCount() const;
+
+    // Som efter strømtab: RTC kopien afvises ved næste restore
+    static void invalidateSnapshot();
+
+    static const char* JOURNAL_FILE;
+
+private:
+    static const char* COMPACT_FILE;
+
+    bool replayJournal(EpaperMonitor& monitor, SourdoughData& data);
+    bool compactJournal(size_t records);
+    void capture(const SourdoughData& data);
+};
+
+#endif
@@ -15,6 +15,17 @@ enum AppState {
     STATE_ERROR
 };
 
+// Hvad der er gjort med den seneste måling
+struct CycleProgress {
+    bool sampled;
+    bool displayed;
+    bool published;
+};
+
+// Næste tilstand i en målecyklus. Er MQTT allerede forbundet, publiceres før skærmen, så den kan opdateres med
+// light sleep bagefter; ellers opdateres skærmen mens WiFi kommer op, og MQTT forbindes derefter
+AppState nextCycleState(const CycleProgress& cycle, bool wifiReady, bool mqttConnected);
+
 class StateMachine {
   private:
     AppState _currentState;
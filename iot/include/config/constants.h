@@ -67,6 +67,9 @@ namespace WiFiConstants {
     constexpr const char* PREF_KEY_SSID = "ssid";
     constexpr const char* PREF_KEY_PASSWORD = "password";
 
+    // Hurtig genforbindelse; efter så mange genbrug hentes en ny lease via DHCP, så routeren ikke giver IP'en væk
+    constexpr uint32_t LEASE_MAX_REUSES = 96;
+
     // Task konfiguration
     constexpr const char* BLINK_TASK_NAME = "BlinkTask";
     constexpr uint32_t BLINK_TASK_STACK_SIZE = 1000;
@@ -93,8 +96,6 @@ namespace NetworkConstants {
     constexpr const char* AP_NAME = "BrodBuddy_setup";
     constexpr const char* AP_PASSWORD = "12345678";
     constexpr const char* HOSTNAME = "sourdough_monitor";
-    constexpr int WIFI_CONNECT_ATTEMPTS = 30;
-    
     constexpr size_t MQTT_BUFFER_SIZE = 8192;
 } 
 
@@ -104,6 +105,26 @@ namespace OtaConstants {
     constexpr uint32_t CHUNK_LOG_INTERVAL = 10;
     constexpr uint32_t CHUNK_HEADER_SIZE = 8;
     constexpr uint32_t ESTIMATED_TOTAL_CHUNKS = 272;
+
+    // Flash writer pipeline
+    constexpr uint32_t MAX_CHUNK_SIZE = 4096;       // Serverens chunk størrelse
+    constexpr uint8_t WRITE_BUFFER_COUNT = 4;       // Chunks der kan vente på flash writeren
+    constexpr uint32_t WRITER_TASK_STACK_SIZE = 4096;
+    constexpr uint32_t WRITER_TASK_PRIORITY = 2;
+    constexpr int WRITER_TASK_CORE = 0;             // Arduino loop kører på core 1
+
+    // Genoptagelse af afbrudte opdateringer
+    constexpr const char* PREFERENCES_NAMESPACE = "ota";
+    constexpr const char* PREF_KEY_CHECKPOINT = "checkpoint";
+    constexpr uint32_t CHECKPOINT_INTERVAL_CHUNKS = 16;  // 64 KB mellem NVS skrivninger
+    constexpr uint32_t FLASH_SECTOR_SIZE = 4096;
+
+    // Komprimerede images: vinduet allokeres under opdateringen, så størrelsen begrænses
+    constexpr uint8_t HEATSHRINK_MAX_WINDOW_BITS = 13;  // 8 KB
+
+    // Modtagevindue: chunks der kommer før tid gemmes, til hullet foran dem er lukket
+    constexpr uint32_t RECEIVE_WINDOW_CHUNKS = 8;   // Højst 32, da SACK bitmap'et er et uint32_t
+    constexpr uint32_t SACK_INTERVAL_CHUNKS = 4;    // Kvittering for hver 4. chunk i rækkefølge
 }
 
 namespace UIConstants {
@@ -111,7 +132,14 @@ namespace UIConstants {
 } 
 
 namespace MonitoringConstants {
-    constexpr int MAX_DATA_POINTS = 144; // Maks 12 timer ved 5-minutter intervaller
+    // Antal blokke skal være en potens af 2 (RingBuffer)
+    constexpr int HISTORY_BLOCKS = 16;         // 1 KB; typisk 47 punkter pr. blok, ca. 62 timer ved 5 minutter
+    constexpr int HISTORY_BLOCK_BYTES = 46;    // Kodede punkter pr. blok; giver 64 bytes blokke på target
+    constexpr int HISTORY_CURVE_POINTS = 96;   // Nedsamplet kurve over MQTT; ca. 40 minutter pr. punkt ved 62 timer
+
+    // Journalen i LittleFS som historikken genskabes fra, når RTC kopien er væk (strømtab, ny firmware)
+    constexpr int HISTORY_JOURNAL_BATCH = 8;           // Punkter der samles i RTC før de skrives samlet
+    constexpr int HISTORY_JOURNAL_MAX_RECORDS = 2048;  // 16 KB; derover beholdes kun den nyeste halvdel
 }
 
 namespace Battery {
@@ -138,6 +166,7 @@ namespace Battery {
 namespace DisplayConstants {
     constexpr int EPD_WIDTH = 128;
     constexpr int EPD_HEIGHT = 296;
+    constexpr int EPD_BUFFER_SIZE = EPD_WIDTH * EPD_HEIGHT / 8;  // Bytes per farveplan
 
     constexpr uint16_t COLOR_BLACK = 0;
     constexpr uint16_t COLOR_WHITE = 1;
@@ -151,11 +180,23 @@ namespace DisplayConstants {
     constexpr uint8_t CMD_WRITE_RAM_RED = 0x26;     // Kommando for at skrive til rød buffer
     constexpr uint8_t CMD_DISPLAY_UPDATE = 0x22;    // Kommando for at starte display opdatering
     constexpr uint8_t CMD_MASTER_ACTIVATION = 0x20; // Aktiverer kommandoen for opdatering
+    constexpr uint8_t CMD_DATA_ENTRY_MODE = 0x11;   // Retning RAM adressen tæller i
+    constexpr uint8_t CMD_RAM_X_RANGE = 0x44;       // RAM vindue i x (i bytes)
+    constexpr uint8_t CMD_RAM_Y_RANGE = 0x45;       // RAM vindue i y (rækker)
+    constexpr uint8_t CMD_RAM_X_COUNTER = 0x4E;     // Start adresse i x
+    constexpr uint8_t CMD_RAM_Y_COUNTER = 0x4F;     // Start adresse i y
 
     // Command parametre
     constexpr uint8_t PARAM_NORMAL_BORDER = 0x05; // Normal kantbølgeform - forhindrer rød kant
     constexpr uint8_t PARAM_UPDATE_FULL = 0xF7;   // Fuld opdatering med LUT (Look-Up Table)
+    constexpr uint8_t PARAM_UPDATE_PARTIAL = 0xFF; // Display mode 2: OTP'ens hurtige LUT til partial opdatering
+    constexpr uint8_t PARAM_DATA_ENTRY_INC = 0x03; // X og Y tæller op, så RAM layout svarer til bufferne
     constexpr uint8_t PARAM_DRIVER_CONFIG = 0x00; // GD=0 (Gate driver normal), SM=0 (Scan mod), TB=0 (Scan retning)
+
+    // Partial refresh
+    constexpr int FULL_REFRESH_INTERVAL = 10; // Partial refreshes mellem hver fuld refresh der fjerner ghosting
+    constexpr int MAX_DIRTY_RECTS = 4;        // Flere ændrede områder lægges sammen med det sidste
+    constexpr int DIRTY_MERGE_ROWS = 8;       // Områder tættere end dette slås sammen til ét vindue
 } 
 
 #endif
\ No newline at end of file
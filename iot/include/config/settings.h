@@ -6,6 +6,22 @@
 #include <LittleFS.h>
 
 class Settings {
+  public:
+    // Værdierne en vågen cyklus bruger, i RTC hukommelse gennem deep sleep. Faste buffere, så strukturen
+    // ikke skal konstrueres
+    struct RetainedState {
+        char analyzerId[32];
+        char mqttServer[64];
+        char mqttUser[32];
+        char mqttPassword[64];
+        int32_t mqttPort;
+        int32_t sensorIntervalSeconds;
+        float tempOffset;
+        float humOffset;
+        int32_t feedingNumber;
+        bool lowPowerMode;
+    };
+
   private:
     static const char* SETTINGS_FILE;
     DynamicJsonDocument _doc;
@@ -18,6 +34,10 @@ class Settings {
     Settings();
 
     bool begin();
+    // Som begin(), men med værdierne fra retain() i stedet for at læse og parse filen
+    bool resume(const RetainedState& state);
+    // false hvis en værdi ikke kan være i bufferne; så skal næste opstart læse filen
+    bool retain(RetainedState& state) const;
     bool save();
     bool load();
     void setDefaults();
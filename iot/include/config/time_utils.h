@@ -40,11 +40,11 @@ namespace TimeConstants {
 
     // WiFI
     constexpr auto WIFI_CONNECTION_TIMEOUT = 10s;
-    constexpr auto WIFI_RETRY_DELAY = 1s;
+    constexpr auto WIFI_PORTAL_CONNECT_TIMEOUT = 30s;
     constexpr auto WIFI_AP_MODE_TIMEOUT = 5min;
     constexpr auto WIFI_STABILIZATION_DELAY = 1s;
     constexpr auto WIFI_RESTART_DELAY = 500ms;
-    constexpr auto WIFI_CHECK_INTERVAL = 10s;
+    constexpr auto WIFI_FAST_CONNECT_TIMEOUT = 3s;
 
     constexpr auto MQTT_RETRY_DELAY = 5s;
     constexpr auto ERROR_STATE_DELAY = 5s;
@@ -95,8 +95,12 @@ namespace TimeConstants {
     constexpr auto OTA_PROGRESS_STALL_TIMEOUT = 60s;
     constexpr auto OTA_INITIAL_TIMEOUT = 30s;
     constexpr auto OTA_RESUME_REQUEST_INTERVAL = 15s;
+    constexpr auto OTA_RESUME_REQUEST_MIN_GAP = 1s;
+    constexpr auto OTA_SACK_INTERVAL = 1s;
     constexpr auto OTA_MQTT_LOOP_INTERVAL = 10ms;
     constexpr auto OTA_REBOOT_DELAY = 3s;
+    constexpr auto OTA_WRITER_BACKPRESSURE_TIMEOUT = 10s;
+    constexpr auto OTA_WRITER_STOP_TIMEOUT = 5s;
 
     // Notifikation over Nfty
     constexpr auto NOTIFICATION_COOLDOWN = 1h;
@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 
+#include "util/ring_buffer.h"
+
 class BatteryManager {
 public:
     BatteryManager();
@@ -18,9 +20,9 @@ private:
     int readADC();
     void updateChargingState();
     
+    // Trenden regnes over de seneste 5 målinger; RingBuffer kræver en potens af 2, så den har plads til 8
     static const int VOLTAGE_HISTORY_SIZE = 5;
-    int voltageHistory[VOLTAGE_HISTORY_SIZE];
-    int historyIndex;
+    RingBuffer<int, 8> voltageHistory;
     unsigned long lastVoltageUpdate;
     bool chargingState;
 };
@@ -10,34 +10,117 @@
 class EpaperDisplay : public Adafruit_GFX {
   public:
     EpaperDisplay();
+    ~EpaperDisplay();
+    EpaperDisplay(const EpaperDisplay&) = delete;
+    EpaperDisplay& operator=(const EpaperDisplay&) = delete;
+
+    // Det der skal til for at fortsætte efter deep sleep. Planerne er for store til RTC hukommelsen, så den viste
+    // frame huskes som en hash
+    struct RetainedState {
+        uint32_t frameHash;
+        uint32_t refreshes;
+        uint32_t skippedRefreshes;
+        int32_t partialRefreshes;
+        bool frameShown;
+    };
 
     void begin();
+    // Efter deep sleep: controlleren har haft strøm hele tiden og har stadig sin RAM og opsætning, så reset og
+    // init springes over. En frame med samme hash som den viste sendes ikke igen
+    void resume(const RetainedState& state);
+    // Gemmer tilstanden og holder RESET og CS høje under deep sleep
+    void retain(RetainedState& state);
 
     // Nulstil buffer; gør display hvid
     void clearBuffers();
 
-    // Send buffer til display og refresh
+    // Gem bufferne som baggrund og kopiér dem ind igen senere i stedet for at tegne forfra.
+    // saveBackground fejler kun hvis cachen ikke kan allokeres
+    bool saveBackground();
+    bool restoreBackground();
+
+    // Send buffer til display og refresh. En uændret frame springes over. Ændringer i forhold til sidst viste frame sendes som
+    // RAM vinduer med partial refresh; første gang og hver FULL_REFRESH_INTERVAL gang bruges fuld refresh
     void updateDisplay();
 
-    // GFX implementation
+    // GFX implementation. Linjer og rektangler skriver hele bytes i stedet for at gå gennem drawPixel
     void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
 
     void drawTestPattern();
 
+    // Tid for at sende begge planer til controlleren ved sidste updateDisplay
+    unsigned long getLastUploadMicros() const { return lastUploadMicros; }
+    bool lastRefreshWasPartial() const { return lastPartial; }
+    uint32_t getRefreshCount() const { return refreshes; }
+    uint32_t getSkippedRefreshCount() const { return skippedRefreshes; }
+    // Hvor længe controlleren var BUSY under sidste refresh
+    unsigned long getLastRefreshMillis() const { return lastRefreshMillis; }
+
+    // Light sleep i stedet for polling mens controlleren er BUSY; CPU'en vækkes af BUSY pin'en
+    void setLightSleepWhileBusy(bool enabled) { lightSleepWhileBusy = enabled; }
+
+    // Kaldes mellem hver polling af BUSY, så andet arbejde kan fortsætte under en refresh. Ikke under light sleep
+    typedef void (*BusyCallback)();
+    void setBusyCallback(BusyCallback callback) { busyCallback = callback; }
+
   private:
+    // Område i controllerens koordinater, x i bytes og begge grænser inklusive
+    struct DirtyRect {
+        uint8_t xStart;
+        uint8_t xEnd;
+        uint16_t yStart;
+        uint16_t yEnd;
+    };
+
     // Display buffers
-    uint8_t blackBuffer[DisplayConstants::EPD_WIDTH * DisplayConstants::EPD_HEIGHT / 8];
-    uint8_t redBuffer[DisplayConstants::EPD_WIDTH * DisplayConstants::EPD_HEIGHT / 8];
+    uint8_t blackBuffer[DisplayConstants::EPD_BUFFER_SIZE];
+    uint8_t redBuffer[DisplayConstants::EPD_BUFFER_SIZE];
+
+    // Det controlleren viser nu, til at finde ændrede områder
+    uint8_t shownBlackBuffer[DisplayConstants::EPD_BUFFER_SIZE];
+    uint8_t shownRedBuffer[DisplayConstants::EPD_BUFFER_SIZE];
+    bool frameShown;
+    // Hash af det controlleren viser; shown planerne er kun gyldige når shownPlanesValid er sat (ikke efter resume)
+    uint32_t shownHash;
+    bool shownPlanesValid;
+    int partialRefreshes;
+    bool lastPartial;
+    uint32_t refreshes;
+    uint32_t skippedRefreshes;
+    unsigned long lastUploadMicros;
+    unsigned long lastRefreshMillis;
+    bool lightSleepWhileBusy;
+    BusyCallback busyCallback;
+
+    // Begge planer efter hinanden; allokeres først når der gemmes en baggrund
+    uint8_t* backgroundBuffer;
 
     // Hardware control funktioner
+    void setupInterface();
+    void setupDrawing();
+    uint32_t frameHash() const;
     void sendCommand(uint8_t command);
     void sendData(uint8_t data);
+    void sendData(const uint8_t* data, size_t length);
+    void uploadFrame();
+    void uploadDirtyRects(const DirtyRect* rects, int count);
+    int findDirtyRects(DirtyRect* rects) const;
+    void writeWindow(uint8_t command, const uint8_t* plane, const DirtyRect& rect);
+    void setRamWindow(uint8_t xStart, uint8_t xEnd, uint16_t yStart, uint16_t yEnd);
+    void writePlane(uint8_t command, const uint8_t* plane);
     void waitUntilIdle();
-    void fullRefresh();
+    bool pollUntilIdle();
+    bool sleepUntilIdle();
+    void refresh(uint8_t updateMode);
     void hardwareReset();
     void softwareReset();
     void initDisplay();
     void setPixel(int16_t x, int16_t y, uint16_t color);
+    void fillArea(int x, int y, int w, int h, uint16_t color);
 };
 
 #endif
\ No newline at end of file
@@ -20,6 +20,18 @@ struct SensorHealth {
 class SensorManager {
   public:
     typedef void (*LoopCallback)();
+
+    // Filtre, baseline og hvilke sensorer der blev fundet, i RTC hukommelse gennem deep sleep
+    struct RetainedState {
+        float filteredTemp;
+        float filteredHum;
+        int32_t baselineDistance;
+        float peakRisePercent;
+        uint8_t bme280Address;
+        bool bme280Connected;
+        bool tofConnected;
+        bool firstReading;
+    };
     
   private:
     Adafruit_BME280 _bme;
@@ -29,6 +41,8 @@ class SensorManager {
 
     unsigned long _lastReadTime;
     unsigned long _readInterval;
+    bool _readRequested; // millis() starter forfra efter deep sleep, så intervallet kan ikke bruges
+    uint8_t _bme280Address;
 
     float _tempOffset;
     float _humOffset;
@@ -46,15 +60,21 @@ class SensorManager {
     int _simDistance;
 #endif
 
-    float calculateMedian(float arr[], int size);
-    int calculateMedianInt(int arr[], int size);
-    void removeOutliers(float arr[], int& size, float minVal, float maxVal);
-    void removeOutliersInt(int arr[], int& size, int minVal, int maxVal);
-
   public:
     SensorManager();
 
+    // Filtrering af målinger. Statiske så de kan benchmarkes og testes uden sensorer
+    static float calculateMedian(float arr[], int size);
+    static int calculateMedianInt(int arr[], int size);
+    static void removeOutliers(float arr[], int& size, float minVal, float maxVal);
+    static void removeOutliersInt(int arr[], int& size, int minVal, int maxVal);
+
     bool begin();
+    // Efter deep sleep: initialiserer de sensorer retain() fandt, uden I2C scan, adresseforsøg og
+    // stabiliseringspauser, og gendanner filtrene. Næste shouldRead() er sand med det samme
+    bool resume(const RetainedState& state);
+    // Gemmer tilstanden og sætter sensorerne i dvale før deep sleep
+    void retain(RetainedState& state);
     bool readAllSensors();
     bool collectMultipleSamples();
 
@@ -38,6 +38,13 @@ class CaptivePortalManager {
     unsigned long apModeStartTime;
     bool apModeTimeoutEnabled;
 
+    // Forbindelse startet fra /connect; følges i loop() så web serveren kan svare på /status imens
+    String pendingSsid;
+    bool connectPending;
+    unsigned long connectStartTime;
+    bool stopPending;
+    unsigned long connectedTime;
+
     std::function<void(const String&, const String&)> saveCredentialsCallback;
     std::function<void(int)> statusCallback;
     std::function<void()> blinkTaskCallback;
@@ -48,4 +55,7 @@ class CaptivePortalManager {
     void handleConnect();
     void handleNotFound();
     void handleConnectionStatus();
+    void checkPendingConnection();
+    void onConnectSucceeded();
+    void onConnectFailed();
 };
\ No newline at end of file
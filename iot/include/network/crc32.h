@@ -0,0 +1,36 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, samme som zlib og serverens firmware CRC) til validering af OTA images.
+// Alle funktioner kan kædes: update(update(0, a), b) == update(0, a + b).
+//
+// Backend vælges ved compile time: ESP32 ROM'ens crc32_le på target, slice-by-8 tabel på host.
+// Definér CRC32_FORCE_SOFTWARE for at bruge tabellen på target også.
+#if defined(ESP_PLATFORM) && !defined(CRC32_FORCE_SOFTWARE)
+    #define CRC32_ROM_BACKEND 1
+#else
+    #define CRC32_ROM_BACKEND 0
+#endif
+
+namespace Crc32 {
+    constexpr uint32_t POLYNOMIAL = 0xEDB88320; // Reflekteret 0x04C11DB7
+
+    // Den valgte backend
+    uint32_t update(uint32_t crc, const uint8_t* data, size_t length);
+    const char* backendName();
+
+    // Slice-by-8 med compile-time genererede tabeller (8 x 256 x 4 bytes)
+    uint32_t updateSliceBy8(uint32_t crc, const uint8_t* data, size_t length);
+
+    // Bit-for-bit reference, bruges kun til validering
+    uint32_t updateBitwise(uint32_t crc, const uint8_t* data, size_t length);
+
+#if CRC32_ROM_BACKEND
+    uint32_t updateRom(uint32_t crc, const uint8_t* data, size_t length);
+#endif
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef DELTA_PATCHER_H
+#define DELTA_PATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "esp_partition.h"
+
+// Streaming anvendelse af bsdiff-lignende patches mod den kørende firmware, så en delta OTA kan skrives direkte
+// til update partitionen. Patches laves af tools/ota_pack (--base=<gammel firmware.bin>).
+//
+// Format (little endian):
+//   header:  "BDP1", newSize u32, baseSize u32, baseCrc32 u32
+//   records: diffLength u32, extraLength u32, seek i32,
+//            diffLength bytes der lægges til base[pos..] (mod 256), extraLength bytes der kopieres direkte,
+//            hvorefter pos flyttes seek bytes
+//
+// Diff bytes er for det meste nul, så patchen sendes normalt heatshrink komprimeret ovenpå.
+class DeltaPatcher {
+public:
+    static constexpr size_t OUTPUT_BLOCK_SIZE = 4096;
+    static constexpr size_t BASE_CACHE_SIZE = 4096;
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr size_t RECORD_SIZE = 12;
+
+    using Sink = std::function<bool(const uint8_t* data, size_t length)>;
+
+    DeltaPatcher();
+    ~DeltaPatcher();
+
+    DeltaPatcher(const DeltaPatcher&) = delete;
+    DeltaPatcher& operator=(const DeltaPatcher&) = delete;
+
+    // Patchens header skal angive samme base
+    bool begin(const esp_partition_t* base, uint32_t baseSize, uint32_t baseCrc32);
+    void end();
+
+    bool write(const uint8_t* data, size_t length, const Sink& sink);
+    bool finish(const Sink& sink);
+
+    uint32_t getOutputBytes() const { return outputBytes; }
+    bool isActive() const { return output != nullptr; }
+
+    // CRC32 over de første size bytes af en partition
+    static bool partitionCrc32(const esp_partition_t* partition, uint32_t size, uint32_t& crc);
+
+private:
+    enum class State : uint8_t {
+        HEADER,
+        RECORD,
+        DIFF,
+        EXTRA,
+        FAILED
+    };
+
+    State state;
+    const esp_partition_t* base;
+    uint32_t baseSize;
+    uint32_t baseCrc32;
+
+    // Header og record samles her, da de kan være delt over to chunks
+    uint8_t field[HEADER_SIZE];
+    size_t fieldLength;
+
+    int64_t basePosition;
+    uint32_t diffRemaining;
+    uint32_t extraRemaining;
+    int32_t seek;
+
+    uint8_t* baseCache;
+    uint32_t baseCacheOffset;
+    uint32_t baseCacheLength;
+
+    uint8_t* output;
+    size_t outputLength;
+    uint32_t outputBytes;
+
+    bool parseHeader();
+    void parseRecord();
+    bool baseByte(int64_t position, uint8_t& value);
+    bool emit(uint8_t value, const Sink& sink);
+};
+
+#endif
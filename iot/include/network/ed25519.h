@@ -0,0 +1,25 @@
+#ifndef ED25519_H
+#define ED25519_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Ed25519 signaturer (RFC 8032) til OTA images. Portabel implementation efter TweetNaCl, så samme kode
+// verificerer på target og signerer i ota_pack værktøjet. mbedtls i ESP-IDF har ingen Ed25519.
+//
+// OTA images signeres over deres SHA-256 digest, så signaturen kan kontrolleres uden at læse imaget igen.
+namespace Ed25519 {
+    constexpr size_t SEED_SIZE = 32;          // Den private nøgle
+    constexpr size_t PUBLIC_KEY_SIZE = 32;
+    constexpr size_t SIGNATURE_SIZE = 64;
+
+    bool verify(const uint8_t signature[SIGNATURE_SIZE], const uint8_t* message, size_t length,
+                const uint8_t publicKey[PUBLIC_KEY_SIZE]);
+
+    // Kun brugt af værktøjer og tests; nøglen findes aldrig på enheden
+    void derivePublicKey(const uint8_t seed[SEED_SIZE], uint8_t publicKey[PUBLIC_KEY_SIZE]);
+    void sign(const uint8_t seed[SEED_SIZE], const uint8_t* message, size_t length,
+              uint8_t signature[SIGNATURE_SIZE]);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef HEATSHRINK_DECODER_H
+#define HEATSHRINK_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Streaming dekoder til heatshrink (LZSS) komprimerede OTA images, samme format som
+// `heatshrink -e -w <window> -l <lookahead>` og tools/ota_pack.
+//
+// Input kan komme i vilkårligt store stykker; bit tilstanden gemmes mellem kald. Udpakkede bytes samles i en
+// buffer og afleveres til sink'en i hele blokke, så flash skrives i samme størrelse som ved rå images.
+// Hukommelse: 2^window bytes vindue + OUTPUT_BLOCK_SIZE, allokeret i begin().
+class HeatshrinkDecoder {
+public:
+    static constexpr size_t OUTPUT_BLOCK_SIZE = 4096;
+
+    // Returnerer false hvis data ikke kunne afleveres; dekodningen stopper så
+    using Sink = std::function<bool(const uint8_t* data, size_t length)>;
+
+    HeatshrinkDecoder();
+    ~HeatshrinkDecoder();
+
+    HeatshrinkDecoder(const HeatshrinkDecoder&) = delete;
+    HeatshrinkDecoder& operator=(const HeatshrinkDecoder&) = delete;
+
+    bool begin(uint8_t windowBits, uint8_t lookaheadBits);
+    void end();
+
+    bool decode(const uint8_t* data, size_t length, const Sink& sink);
+    // Afleverer den sidste, ufuldstændige blok
+    bool finish(const Sink& sink);
+
+    uint32_t getOutputBytes() const { return outputBytes; }
+    bool isActive() const { return window != nullptr; }
+
+    static bool validParameters(uint8_t windowBits, uint8_t lookaheadBits);
+
+private:
+    enum class State : uint8_t {
+        TAG_BIT,
+        LITERAL,
+        BACKREF_INDEX,
+        BACKREF_COUNT,
+        BACKREF_COPY
+    };
+
+    State state;
+    uint8_t windowBits;
+    uint8_t lookaheadBits;
+
+    uint8_t* window;
+    uint32_t windowMask;
+    uint32_t head;
+
+    uint8_t* output;
+    size_t outputLength;
+    uint32_t outputBytes;
+
+    // Bits læst fra input men ikke brugt endnu, MSB først
+    uint32_t bitBuffer;
+    uint8_t bitCount;
+    const uint8_t* input;
+    size_t inputLength;
+
+    uint32_t backrefOffset;
+    uint32_t backrefCount;
+
+    bool getBits(uint8_t count, uint32_t& value);
+    bool emit(uint8_t value, const Sink& sink);
+};
+
+#endif
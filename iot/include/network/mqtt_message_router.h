@@ -12,6 +12,7 @@ public:
     
     void setTopics(MqttTopics* topics) { mqttTopics = topics; }
     void setDiagnosticsHandler(MessageHandler handler) { diagnosticsHandler = handler; }
+    void setHistoryHandler(MessageHandler handler) { historyHandler = handler; }
     void setOtaHandler(MessageHandler handler) { otaHandler = handler; }
     
     void routeMessage(char* topic, byte* payload, unsigned int length);
@@ -21,6 +22,7 @@ private:
     
     MqttTopics* mqttTopics;
     MessageHandler diagnosticsHandler;
+    MessageHandler historyHandler;
     MessageHandler otaHandler;
     
     unsigned long messageCount;
@@ -32,6 +32,18 @@ namespace MqttProtocol {
         constexpr const char* BATTERY_PERCENTAGE = "percentage";
         constexpr const char* BATTERY_CHARGING = "charging";
         constexpr const char* BATTERY_VOLTAGE = "voltage";
+        constexpr const char* DISPLAY = "display";
+        constexpr const char* DISPLAY_REFRESHES = "refreshes";
+        constexpr const char* DISPLAY_SKIPPED_REFRESHES = "skippedRefreshes";
+        constexpr const char* DISPLAY_LAST_REFRESH_MS = "lastRefreshMs";
+    }
+    
+    namespace HistoryFields {
+        constexpr const char* ANALYZER_ID = "analyzerId";
+        constexpr const char* EPOCH_TIME = "epochTime";
+        constexpr const char* BUCKET_SECONDS = "bucketSeconds"; // Længden af intervallet hvert punkt dækker
+        constexpr const char* TIMESTAMPS = "timestamps";         // Tidspunkt for højeste vækst i intervallet
+        constexpr const char* RISE = "rise";
     }
     
     namespace OtaFields {
@@ -41,6 +53,34 @@ namespace MqttProtocol {
         constexpr const char* STATUS = "status";
         constexpr const char* PROGRESS = "progress";
         constexpr const char* MESSAGE = "message";
+        constexpr const char* BACKPRESSURE = "backpressure"; // true mens flash writeren er bagud
+        constexpr const char* QUEUED = "queued";             // Chunks der venter på flash
+        constexpr const char* RESUME = "resume";             // ota/check: fortsæt en afbrudt overførsel
+        constexpr const char* NEXT_CHUNK = "nextChunk";
+        constexpr const char* OFFSET = "offset";
+        constexpr const char* ACK = "ack";                   // Næste manglende chunk; alt før er modtaget
+        constexpr const char* SACK = "sack";                 // Bit i = chunk ack + 1 + i er modtaget
+        constexpr const char* RECEIVE_WINDOW = "rxWindow";   // Chunks afsenderen må have udestående
+        constexpr const char* COMPRESSION = "compression";  // Udeladt for rå images
+        constexpr const char* IMAGE_SIZE = "imageSize";      // Udpakket størrelse; size er de overførte bytes
+        constexpr const char* WINDOW_BITS = "window";
+        constexpr const char* LOOKAHEAD_BITS = "lookahead";
+        
+        constexpr const char* PATCH = "patch";              // Udeladt for fulde images
+        constexpr const char* BASE_VERSION = "baseVersion";
+        constexpr const char* BASE_SIZE = "baseSize";
+        constexpr const char* BASE_CRC32 = "baseCrc32";
+        constexpr const char* SIGNATURE = "signature";      // Ed25519 over imagets SHA-256, hex
+        
+        namespace CompressionValues {
+            constexpr const char* NONE = "none";
+            constexpr const char* HEATSHRINK = "heatshrink";
+        }
+        
+        namespace PatchValues {
+            constexpr const char* NONE = "none";
+            constexpr const char* BSDIFF = "bsdiff";
+        }
         
         namespace StatusValues {
             constexpr const char* STARTED = "started";
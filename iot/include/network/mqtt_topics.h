@@ -23,6 +23,14 @@ public:
         return String(BASE_TOPIC) + "/" + _analyzerId + "/diagnostics/response";
     }
     
+    String getHistoryRequestTopic() const {
+        return String(BASE_TOPIC) + "/" + _analyzerId + "/history/request";
+    }
+    
+    String getHistoryResponseTopic() const {
+        return String(BASE_TOPIC) + "/" + _analyzerId + "/history/response";
+    }
+    
     String getOtaStartTopic() const {
         return String(BASE_TOPIC) + "/" + _analyzerId + "/ota/start";
     }
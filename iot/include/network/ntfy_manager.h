@@ -5,6 +5,16 @@
 #include <HTTPClient.h>
 
 class NtfyManager {
+public:
+    // Fald-detektionen i RTC hukommelse gennem deep sleep. Cooldown gemmes som resterende tid, da millis()
+    // starter forfra ved opvågning
+    struct RetainedState {
+        float lastRiseValue;
+        int32_t consecutiveDecreases;
+        uint32_t cooldownRemainingMs;
+        bool decreaseNotificationSent;
+    };
+
 private:
     String _topic;
     bool _decreaseNotificationSent;
@@ -22,6 +32,10 @@ public:
     void reset();
     bool isInCooldown() const;
 
+    void resume(const RetainedState& state);
+    // sleepMs trækkes fra cooldown, så den fortsætter efter søvnen
+    void retain(RetainedState& state, unsigned long sleepMs) const;
+
 };
 
 #endif
\ No newline at end of file
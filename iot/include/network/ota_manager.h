@@ -1,10 +1,21 @@
 #pragma once
 
 #include <Arduino.h>
+#include <Preferences.h>
 #include <Update.h>
 #include "esp_ota_ops.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "logging/logger.h"
+#include "config/constants.h"
 #include "config/time_utils.h"
+#include "network/delta_patcher.h"
+#include "network/ed25519.h"
+#include "network/heatshrink_decoder.h"
+#include "network/sha256.h"
+#include <atomic>
 #include <functional>
 
 class OtaManager {
@@ -20,22 +31,45 @@ public:
 
     struct OtaInfo {
         String version;
-        uint32_t size;
-        uint32_t crc32;
+        uint32_t size;              // Bytes der overføres
+        uint32_t crc32;             // Over det udpakkede image
+        uint32_t imageSize;         // Udpakket størrelse; lig med size for rå images
+        bool compressed;
+        uint8_t windowBits;
+        uint8_t lookaheadBits;
+        bool delta;                 // Patch mod den kørende firmware
+        String baseVersion;
+        uint32_t baseSize;
+        uint32_t baseCrc32;
+        String signature;           // Hex; påkrævet når der er sat en signeringsnøgle
     };
 
     using BatteryCheckCallback = std::function<bool()>;
     using StatusCallback = std::function<void(const String& status, uint8_t progress)>;
+    // Kaldes når flash writeren ikke kan følge med (active = true) og når den har indhentet igen
+    using BackpressureCallback = std::function<void(bool active, uint8_t queuedChunks)>;
+    // Beder afsenderen om at fortsætte fra nextChunk (publiceres på ota/check)
+    using ResumeRequestCallback = std::function<void(const String& version, uint32_t nextChunk, uint32_t offset)>;
+    // Selektiv kvittering: alt før nextChunk er modtaget, bit i i receivedMask er chunk nextChunk + 1 + i
+    using AckCallback = std::function<void(uint32_t nextChunk, uint32_t receivedMask, uint32_t window)>;
 
     OtaManager();
     
     bool begin();
     bool startUpdate(const OtaInfo& info);
     bool processChunk(const uint8_t* data, size_t length, uint32_t chunkIndex, uint32_t chunkSize);
-    void abort(const String& reason);
+    // keepCheckpoint bevarer det skrevne, så samme version kan genoptages senere
+    void abort(const String& reason, bool keepCheckpoint = false);
+    void loop();
+    bool requestResume();
+    // Public key som hex; derefter afvises images uden gyldig signatur
+    bool setSigningKey(const char* publicKeyHex);
     
     void setBatteryCheckCallback(BatteryCheckCallback callback) { batteryCheck = callback; }
     void setStatusCallback(StatusCallback callback) { statusCallback = callback; }
+    void setBackpressureCallback(BackpressureCallback callback) { backpressureCallback = callback; }
+    void setResumeRequestCallback(ResumeRequestCallback callback) { resumeRequestCallback = callback; }
+    void setAckCallback(AckCallback callback) { ackCallback = callback; }
     
     bool handleOtaMessage(const String& topic, const uint8_t* payload, unsigned int length, 
                          const String& otaStartTopic, const String& otaChunkTopic);
@@ -44,11 +78,31 @@ public:
     uint8_t getProgress() const;
     bool isInProgress() const { return inProgress; }
     uint32_t getReceivedBytes() const { return receivedBytes; }
+    uint32_t getWrittenBytes() const { return writtenBytes; }
+    uint8_t getQueuedChunks() const;
     uint32_t getTotalBytes() const { return totalBytes; }
+    uint32_t getImageSize() const { return imageSize; }
+    bool hasCheckpoint() const { return checkpointValid; }
+    uint32_t getNextChunkIndex() const { return receivedBytes / OtaConstants::MAX_CHUNK_SIZE; }
+    uint32_t getReceivedMask() const;
+    uint8_t getBufferedChunks() const;
+    uint32_t getDuplicateChunks() const { return duplicateChunks; }
     std::chrono::steady_clock::time_point getLastChunkTime() const { return lastChunkTime; }
     
 private:
     static const char* TAG;
+    static constexpr uint8_t STOP_SLOT = 0xFF;
+
+    // Gemmes som én NVS blob, så et checkpoint altid er helt eller slet ikke skrevet
+    struct Checkpoint {
+        char version[32];
+        char partition[17];
+        uint32_t size;
+        uint32_t expectedCrc32;
+        uint32_t crc32;             // CRC over de bytes der er skrevet til flash
+        uint32_t bytesWritten;
+        uint32_t lastChunkIndex;
+    };
     
     OtaStatus status;
     bool inProgress;
@@ -57,13 +111,77 @@ private:
     
     uint32_t totalBytes;
     uint32_t receivedBytes;
+    uint32_t imageSize;
     uint32_t expectedCrc32;
     uint32_t calculatedCrc32;
+    String version;
     std::chrono::steady_clock::time_point lastChunkTime;
+    std::chrono::steady_clock::time_point lastResumeRequest;
+
+    Preferences preferences;
+    Checkpoint checkpoint;
+    bool checkpointValid;
+    bool offsetWrites;              // Genoptaget efter genstart: flash skrives fra chunkens offset
+    uint32_t chunksSinceCheckpoint;
+
+    // Flash writer pipeline: MQTT callback kopierer chunks ind i en fast pulje af buffere, som
+    // writer tasken (på den anden core) CRC'er og skriver til flash
+    uint8_t* chunkPool;
+    uint32_t slotLength[OtaConstants::WRITE_BUFFER_COUNT];
+    uint32_t slotOffset[OtaConstants::WRITE_BUFFER_COUNT];
+    uint32_t slotChunkIndex[OtaConstants::WRITE_BUFFER_COUNT];
+    QueueHandle_t freeSlots;
+    QueueHandle_t filledSlots;
+    SemaphoreHandle_t writerDone;
+    TaskHandle_t writerTask;
+    std::atomic<esp_err_t> writerError;
+    std::atomic<uint32_t> writtenBytes;
+    // Opdateres sammen med CRC'en, så signaturen kan tjekkes uden at læse partitionen igen
+    Sha256 imageHash;
+    uint8_t signature[Ed25519::SIGNATURE_SIZE];
+    bool signaturePresent;
+    uint8_t signingKey[Ed25519::PUBLIC_KEY_SIZE];
+    bool signingKeySet;
+    // Aktive for komprimerede images og delta patches; bruges kun af writer tasken indtil den er stoppet
+    HeatshrinkDecoder decoder;
+    DeltaPatcher patcher;
+
+    // Modtagevindue: chunks foran den næste forventede venter her, så writeren altid får dem i rækkefølge.
+    // Plads = chunkIndex % vinduet; ejes af MQTT callbacken
+    uint8_t* reorderPool;
+    uint32_t reorderIndex[OtaConstants::RECEIVE_WINDOW_CHUNKS];
+    uint32_t reorderLength[OtaConstants::RECEIVE_WINDOW_CHUNKS];
+    uint32_t reorderSlots;          // Bitmap over optagne pladser
+    uint32_t duplicateChunks;
+    uint32_t chunksSinceAck;
+    std::chrono::steady_clock::time_point lastAck;
     
     BatteryCheckCallback batteryCheck;
     StatusCallback statusCallback;
+    BackpressureCallback backpressureCallback;
+    ResumeRequestCallback resumeRequestCallback;
+    AckCallback ackCallback;
     
     void completeUpdate();
-    uint32_t updateCrc32(uint32_t crc, const uint8_t* data, size_t length);
+    bool matchesCheckpoint(const OtaInfo& info, const esp_partition_t* partition) const;
+    bool verifyCheckpoint(const esp_partition_t* partition);
+    void loadCheckpoint();
+    void saveCheckpoint(uint32_t chunkIndex);
+    void clearCheckpoint();
+    bool startWriter();
+    bool stopWriter();
+    bool waitForSlot(uint8_t& slot);
+    bool queueChunk(const uint8_t* data, uint32_t length, uint32_t chunkIndex);
+    uint32_t expectedChunkLength(uint32_t chunkIndex) const;
+    bool isBuffered(uint32_t chunkIndex) const;
+    void bufferChunk(const uint8_t* data, uint32_t length, uint32_t chunkIndex);
+    bool drainBuffered();
+    void sendAck();
+    static void writerTaskEntry(void* param);
+    void writerLoop();
+    bool writeImage(const uint8_t* data, size_t length, uint32_t offset);
+    bool writeUnpacked(const uint8_t* data, size_t length);
+    bool prepareDelta(const OtaInfo& info);
+    bool finishImage();
+    bool verifySignature();
 };
\ No newline at end of file
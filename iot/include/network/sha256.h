@@ -0,0 +1,51 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Inkrementel SHA-256 til OTA images, så hashen kan beregnes mens chunks skrives i stedet for at
+// læse hele partitionen igen bagefter.
+//
+// Backend vælges ved compile time som for Crc32: mbedtls på target (ESP-IDF's port bruger SHA
+// acceleratoren), en portabel implementation på host. Definér SHA256_FORCE_SOFTWARE for at bruge
+// den portable på target også.
+#if defined(ESP_PLATFORM) && !defined(SHA256_FORCE_SOFTWARE)
+    #define SHA256_MBEDTLS_BACKEND 1
+    #include <mbedtls/sha256.h>
+#else
+    #define SHA256_MBEDTLS_BACKEND 0
+#endif
+
+class Sha256 {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    Sha256();
+    ~Sha256();
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void begin();
+    void update(const uint8_t* data, size_t length);
+    // Starter forfra bagefter, så instansen kan genbruges
+    void finish(uint8_t digest[DIGEST_SIZE]);
+
+    static void hash(const uint8_t* data, size_t length, uint8_t digest[DIGEST_SIZE]);
+    static const char* backendName();
+
+private:
+#if SHA256_MBEDTLS_BACKEND
+    mbedtls_sha256_context context;
+#else
+    uint32_t state[8];
+    uint64_t totalLength;
+    uint8_t buffer[BLOCK_SIZE];
+    size_t bufferLength;
+
+    void compress(const uint8_t* block);
+#endif
+};
+
+#endif
@@ -6,12 +6,19 @@
 #include "logging/logger.h"
 
 class TimeManager {
+public:
+    // Systemuret fortsætter på RTC timeren gennem deep sleep; kun synkroniseringens bogføring skal gemmes
+    struct RetainedState {
+        time_t lastSyncEpoch;
+        bool initialized;
+    };
+
 private:
     bool _timeInitialized;
     String _timeZone;
     const char* _ntpServer;
-    unsigned long _lastSyncMillis;
-    unsigned long _syncInterval;
+    time_t _lastSyncEpoch; // Epoch frem for millis(), som starter forfra efter deep sleep
+    unsigned long _syncInterval; // Sekunder
     unsigned long _lastRetryAttempt;
     
     static const char* TAG;
@@ -36,6 +43,9 @@ public:
     bool isTimeValid() const;
     
     void adjustAfterSleep(unsigned long sleepTimeMs);
+
+    void resume(const RetainedState& state);
+    void retain(RetainedState& state) const;
     
     bool trySync();
     bool shouldRetrySync() const;
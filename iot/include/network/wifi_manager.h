@@ -3,11 +3,15 @@
 #include <WiFi.h>
 #include <Preferences.h>
 
+#include <atomic>
+
 #include "app/data_types.h"
 #include "config/constants.h"
 #include "logging/logger.h"
 #include "network/captive_portal_manager.h"
 
+// Forbinder uden at blokere: begin() starter forbindelsen og returnerer med det samme, hvorefter loop() driver
+// forløbet videre ud fra WiFi events. Først cachet access point, så fuld scanning og til sidst captive portal.
 class WifiManager {
   public:
     WifiManager();
@@ -19,12 +23,22 @@ class WifiManager {
     void startCaptivePortal();
 
   private:
+    enum ConnectPhase { PHASE_IDLE, PHASE_FAST, PHASE_FULL, PHASE_PORTAL };
+
     Preferences preferences;
     WiFiStatus currentStatus;
+    ConnectPhase phase;
     unsigned long connectStartTime;
     unsigned long previousMillis;
     bool ledState;
-    unsigned long lastWiFiCheck;
+    String ssid;
+    String password;
+
+    // Sættes fra WiFi event tasken og læses i loop()
+    std::atomic<bool> gotIpEvent;
+    std::atomic<bool> disconnectedEvent;
+    std::atomic<uint8_t> disconnectReason;
+    bool eventsRegistered;
 
     CaptivePortalManager captivePortalManager;
 
@@ -33,9 +47,16 @@ class WifiManager {
     bool apModeTimeoutOccurred;
 
     void createBlinkTask();
-    void checkWiFiStatus();
+    void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
+    void handleEvents();
+    void handleTimeouts();
+    bool startFastConnect();
+    void startFullConnect();
+    void startPortal();
+    void onConnected();
+    void storeLease();
     void saveWiFiCredentials(const String& ssid, const String& password);
 
     void enableAPModeTimeout();
     void disableAPModeTimeout();
-};
\ No newline at end of file
+};
@@ -0,0 +1,43 @@
+#ifndef RETAINED_H
+#define RETAINED_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "network/crc32.h"
+
+// Værdi i RTC hukommelse der skal overleve deep sleep eller et reset. Indhold efter strømtab, et reset midt i
+// en skrivning eller fra en firmware med andet layout afvises via magic, størrelse og CRC32.
+//
+// Ingen konstruktør, da den ville køre ved boot og overskrive indholdet: placeres med RTC_NOINIT_ATTR eller
+// RTC_DATA_ATTR, og valid() tjekkes før value bruges. seal() efter hver ændring af value.
+template <typename T, uint32_t Magic>
+struct Retained {
+    static_assert(std::is_trivial<T>::value, "Retained values must not need construction");
+
+    uint32_t magic;
+    uint32_t size;
+    T value;
+    uint32_t crc;
+
+    bool valid() const {
+        return magic == Magic && size == sizeof(Retained) && crc == checksum();
+    }
+
+    void seal() {
+        magic = Magic;
+        size = sizeof(Retained);
+        crc = checksum();
+    }
+
+    void invalidate() {
+        magic = 0;
+    }
+
+    uint32_t checksum() const {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(this);
+        return Crc32::update(0, begin, reinterpret_cast<const uint8_t*>(&crc) - begin);
+    }
+};
+
+#endif
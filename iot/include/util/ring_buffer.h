@@ -0,0 +1,121 @@
+#ifndef UTIL_RING_BUFFER_H
+#define UTIL_RING_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+// Ringbuffer med fast kapacitet til historik (vækstmålinger, batterispænding). Indeks 0 er det ældste
+// element, og pushBack på en fuld buffer overskriver det.
+//
+// N skal være en potens af 2, så en position afbildes til et slot med en maske i stedet for division.
+// Start og slut tæller frit og må wrappe ved uint32_t grænsen; forskellen er stadig antallet af elementer.
+//
+// Der er bevidst ingen konstruktør, så bufferen kan ligge i hukommelse der skal overleve genstart.
+// Værdiinitialiser den ({}) eller kald clear() før brug.
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two");
+    static_assert(N <= (size_t(1) << 31), "RingBuffer capacity must fit the position counters");
+
+public:
+    // Sammenhængende udsnit af lageret, som std::span
+    template <typename U>
+    struct Segment {
+        U* data;
+        size_t size;
+
+        U* begin() const { return data; }
+        U* end() const { return data + size; }
+    };
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<Const, const T*, T*>::type;
+        using reference = typename std::conditional<Const, const T&, T&>::type;
+        using Buffer = typename std::conditional<Const, const RingBuffer, RingBuffer>::type;
+
+        Iterator(Buffer* buffer, uint32_t position) : _buffer(buffer), _position(position) {}
+
+        reference operator*() const { return _buffer->_items[_position & MASK]; }
+        pointer operator->() const { return &**this; }
+
+        Iterator& operator++() { _position++; return *this; }
+        Iterator operator++(int) { Iterator copy = *this; _position++; return copy; }
+        Iterator& operator--() { _position--; return *this; }
+        Iterator operator--(int) { Iterator copy = *this; _position--; return copy; }
+
+        bool operator==(const Iterator& other) const { return _position == other._position; }
+        bool operator!=(const Iterator& other) const { return _position != other._position; }
+
+    private:
+        Buffer* _buffer;
+        uint32_t _position;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    static constexpr size_t capacity() { return N; }
+
+    size_t size() const { return _end - _start; }
+    bool empty() const { return _end == _start; }
+    bool full() const { return size() == N; }
+
+    void clear() {
+        _start = 0;
+        _end = 0;
+    }
+
+    // Overskriver det ældste element hvis bufferen er fuld
+    void pushBack(const T& value) {
+        if (full()) {
+            _start++;
+        }
+        _items[_end++ & MASK] = value;
+    }
+
+    // Kræver at bufferen ikke er tom
+    void popFront() { _start++; }
+    void popBack() { _end--; }
+
+    T& front() { return _items[_start & MASK]; }
+    const T& front() const { return _items[_start & MASK]; }
+    T& back() { return _items[(_end - 1) & MASK]; }
+    const T& back() const { return _items[(_end - 1) & MASK]; }
+
+    // 0 er det ældste element
+    T& operator[](size_t index) { return _items[(_start + index) & MASK]; }
+    const T& operator[](size_t index) const { return _items[(_start + index) & MASK]; }
+
+    iterator begin() { return iterator(this, _start); }
+    iterator end() { return iterator(this, _end); }
+    const_iterator begin() const { return const_iterator(this, _start); }
+    const_iterator end() const { return const_iterator(this, _end); }
+
+    // Indholdet i rækkefølge som højst to sammenhængende udsnit: fra det ældste element til lagerets ende,
+    // og den del der er wrappet rundt til starten. Det andet er tomt når indholdet ikke wrapper.
+    Segment<const T> firstSegment() const {
+        size_t offset = _start & MASK;
+        size_t length = size() < N - offset ? size() : N - offset;
+        return {_items + offset, length};
+    }
+
+    Segment<const T> secondSegment() const {
+        return {_items, size() - firstSegment().size};
+    }
+
+private:
+    static constexpr uint32_t MASK = N - 1;
+
+    T _items[N];
+    uint32_t _start;
+    uint32_t _end;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef NATIVE_ADAFRUIT_BME280_H
+#define NATIVE_ADAFRUIT_BME280_H
+
+#include "Adafruit_Sensor.h"
+#include "Wire.h"
+
+// Simuleret BME280: returnerer NativeHal::setEnvironment() værdierne med lidt målestøj
+class Adafruit_BME280 {
+  public:
+    enum sensor_sampling { SAMPLING_NONE, SAMPLING_X1, SAMPLING_X2, SAMPLING_X4, SAMPLING_X8, SAMPLING_X16 };
+    enum sensor_mode { MODE_SLEEP, MODE_FORCED, MODE_NORMAL = 3 };
+    enum sensor_filter { FILTER_OFF, FILTER_X2, FILTER_X4, FILTER_X8, FILTER_X16 };
+    enum standby_duration {
+        STANDBY_MS_0_5,
+        STANDBY_MS_62_5,
+        STANDBY_MS_125,
+        STANDBY_MS_250,
+        STANDBY_MS_500,
+        STANDBY_MS_1000,
+        STANDBY_MS_10,
+        STANDBY_MS_20
+    };
+
+    bool begin(uint8_t address = 0x77, TwoWire* wire = &Wire);
+    void setSampling(sensor_mode mode = MODE_NORMAL, sensor_sampling tempSampling = SAMPLING_X16,
+                     sensor_sampling pressSampling = SAMPLING_X16, sensor_sampling humSampling = SAMPLING_X16,
+                     sensor_filter filter = FILTER_OFF, standby_duration duration = STANDBY_MS_0_5) {}
+    bool takeForcedMeasurement() { return true; }
+
+    float readTemperature();
+    float readHumidity();
+    float readPressure() { return 101325.0f; }
+};
+
+#endif
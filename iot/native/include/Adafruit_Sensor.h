@@ -0,0 +1,7 @@
+#ifndef NATIVE_ADAFRUIT_SENSOR_H
+#define NATIVE_ADAFRUIT_SENSOR_H
+
+// Adafruit_BME280.h inkluderer denne; der er intet Unified Sensor API i brug på host
+#include "Arduino.h"
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+#include <memory>
+#include <string>
+
+#include "Arduino.h"
+
+namespace fs {
+    class FileImpl;
+
+    enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+    // Filhåndtag som i Arduino-ESP32: kan kopieres, lukkes når sidste kopi forsvinder
+    class File : public Stream {
+      public:
+        File() = default;
+        explicit File(std::shared_ptr<FileImpl> impl) : _impl(std::move(impl)) {}
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        using Print::write;
+        void flush() override;
+
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t read(uint8_t* buffer, size_t size);
+        size_t readBytes(char* buffer, size_t length) override { return read(reinterpret_cast<uint8_t*>(buffer), length); }
+
+        bool seek(uint32_t pos, SeekMode mode = SeekSet);
+        size_t position() const;
+        size_t size() const;
+        void close();
+        const char* name() const;
+        const char* path() const;
+
+        operator bool() const { return static_cast<bool>(_impl); }
+
+      private:
+        std::shared_ptr<FileImpl> _impl;
+    };
+
+    class FS {
+      public:
+        explicit FS(const std::string& subdirectory) : _subdirectory(subdirectory) {}
+
+        File open(const char* path, const char* mode = "r", bool create = false);
+        File open(const String& path, const char* mode = "r", bool create = false) {
+            return open(path.c_str(), mode, create);
+        }
+        bool exists(const char* path);
+        bool exists(const String& path) { return exists(path.c_str()); }
+        bool remove(const char* path);
+        bool remove(const String& path) { return remove(path.c_str()); }
+        bool rename(const char* pathFrom, const char* pathTo);
+        bool mkdir(const char* path);
+        bool rmdir(const char* path);
+
+      protected:
+        std::string resolve(const char* path) const;
+        std::string _subdirectory;
+    };
+}
+
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekSet;
+
+#endif
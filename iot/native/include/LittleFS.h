@@ -0,0 +1,22 @@
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+#include "FS.h"
+
+namespace fs {
+    // LittleFS partitionen som en mappe under NativeHal::storageRoot()
+    class LittleFSFS : public FS {
+      public:
+        LittleFSFS();
+        bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+                   const char* partitionLabel = "spiffs");
+        bool format();
+        size_t totalBytes();
+        size_t usedBytes();
+        void end() {}
+    };
+}
+
+extern fs::LittleFSFS LittleFS;
+
+#endif
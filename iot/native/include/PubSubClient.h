@@ -0,0 +1,81 @@
+#ifndef NATIVE_PUBSUBCLIENT_H
+#define NATIVE_PUBSUBCLIENT_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Client.h"
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_BAD_PROTOCOL 1
+#define MQTT_CONNECT_BAD_CLIENT_ID 2
+#define MQTT_CONNECT_UNAVAILABLE 3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED 5
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+// MQTT 3.1.1 klient (QoS 0 udgående, QoS 0/1 indgående) med samme API som knolleary/PubSubClient
+class PubSubClient : public Print {
+  public:
+    PubSubClient() = default;
+    explicit PubSubClient(Client& client) : _client(&client) {}
+
+    PubSubClient& setServer(const char* domain, uint16_t port);
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+    PubSubClient& setClient(Client& client);
+    PubSubClient& setKeepAlive(uint16_t keepAlive);
+    PubSubClient& setSocketTimeout(uint16_t timeout);
+    bool setBufferSize(uint16_t size);
+    uint16_t getBufferSize() const { return static_cast<uint16_t>(_buffer.size()); }
+
+    bool connect(const char* id);
+    bool connect(const char* id, const char* user, const char* pass);
+    void disconnect();
+
+    bool publish(const char* topic, const char* payload);
+    bool publish(const char* topic, const char* payload, bool retained);
+    bool publish(const char* topic, const uint8_t* payload, unsigned int plength, bool retained = false);
+
+    bool beginPublish(const char* topic, unsigned int plength, bool retained);
+    int endPublish();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    bool subscribe(const char* topic, uint8_t qos = 0);
+    bool unsubscribe(const char* topic);
+    bool loop();
+    bool connected();
+    int state() const { return _state; }
+
+  private:
+    bool sendPacket(uint8_t header, const std::vector<uint8_t>& body);
+    bool readPacket(uint8_t& header, size_t& length);
+    bool readByte(uint8_t& value);
+    bool waitForPacket(uint8_t expectedType, size_t& length);
+    void handlePacket(uint8_t header, size_t length);
+    static void appendString(std::vector<uint8_t>& body, const char* value);
+    static void appendLength(std::vector<uint8_t>& packet, size_t length);
+
+    Client* _client = nullptr;
+    std::string _domain;
+    uint16_t _port = 1883;
+    MQTT_CALLBACK_SIGNATURE;
+    // Delt af indgående beskeder og publish, som i biblioteket
+    std::vector<uint8_t> _buffer = std::vector<uint8_t>(256);
+    uint16_t _keepAlive = 15;
+    uint16_t _socketTimeout = 15;
+    uint16_t _nextMessageId = 1;
+    unsigned long _lastOutActivity = 0;
+    unsigned long _lastInActivity = 0;
+    bool _pingOutstanding = false;
+    int _state = MQTT_DISCONNECTED;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+#define SPI_HAS_TRANSACTION 1
+
+enum BitOrder { LSBFIRST = 0, MSBFIRST = 1 };
+
+class SPISettings {
+  public:
+    SPISettings() : _clock(1000000), _bitOrder(MSBFIRST), _dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clock, BitOrder bitOrder, uint8_t dataMode)
+        : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+
+    uint32_t _clock;
+    BitOrder _bitOrder;
+    uint8_t _dataMode;
+};
+
+// SPI master uden slave; alle bytes tælles så upload-tider kan måles på host
+class SPIClass {
+  public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+    void end() {}
+
+    void beginTransaction(SPISettings settings);
+    void endTransaction() {}
+
+    void setFrequency(uint32_t freq) { _settings._clock = freq; }
+    void setBitOrder(BitOrder bitOrder) { _settings._bitOrder = bitOrder; }
+    void setDataMode(uint8_t dataMode) { _settings._dataMode = dataMode; }
+    void setHwCs(bool use) {}
+
+    uint8_t transfer(uint8_t data);
+    uint16_t transfer16(uint16_t data);
+    uint32_t transfer32(uint32_t data);
+    void transfer(void* data, uint32_t size);
+    void transferBytes(const uint8_t* data, uint8_t* out, uint32_t size);
+    void write(uint8_t data);
+    void write16(uint16_t data);
+    void write32(uint32_t data);
+    void writeBytes(const uint8_t* data, uint32_t size);
+
+  private:
+    SPISettings _settings;
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef NATIVE_UPDATE_H
+#define NATIVE_UPDATE_H
+
+// OtaManager bruger esp_ota_* direkte; headeren findes kun så include-listen er den samme som på target
+#include "esp_ota_ops.h"
+
+#endif
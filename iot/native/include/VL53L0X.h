@@ -0,0 +1,26 @@
+#ifndef NATIVE_VL53L0X_H
+#define NATIVE_VL53L0X_H
+
+#include "Arduino.h"
+
+// Simuleret VL53L0X: returnerer NativeHal::setDistance() med lidt målestøj
+class VL53L0X {
+  public:
+    bool init(bool io2v8 = true) { return true; }
+    void setAddress(uint8_t newAddress) { _address = newAddress; }
+    uint8_t getAddress() const { return _address; }
+    void setTimeout(uint16_t timeout) { _timeout = timeout; }
+    uint16_t getTimeout() const { return _timeout; }
+    bool setMeasurementTimingBudget(uint32_t budgetUs) { return true; }
+    void startContinuous(uint32_t periodMs = 0) {}
+    void stopContinuous() {}
+    uint16_t readRangeContinuousMillimeters();
+    uint16_t readRangeSingleMillimeters() { return readRangeContinuousMillimeters(); }
+    bool timeoutOccurred() { return false; }
+
+  private:
+    uint8_t _address = 0x29;
+    uint16_t _timeout = 0;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Flash strenge findes ikke på host, og F() giver en almindelig const char*. Typen skal dog være erklæret, da
+// Adafruit_GFX.h har en getTextBounds overload der tager den
+class __FlashStringHelper;
+
+// Minimal Arduino String oven på std::string - kun det API firmwaren og ArduinoJson bruger
+class String {
+  public:
+    String() = default;
+    String(const char* cstr) : _str(cstr ? cstr : "") {}
+    String(const std::string& str) : _str(str) {}
+    String(const String& other) = default;
+    String(String&& other) noexcept = default;
+    explicit String(char c) : _str(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+
+    String& operator=(const String& other) = default;
+    String& operator=(String&& other) noexcept = default;
+    String& operator=(const char* cstr) {
+        _str = cstr ? cstr : "";
+        return *this;
+    }
+
+    const char* c_str() const { return _str.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(_str.length()); }
+    bool isEmpty() const { return _str.empty(); }
+    bool reserve(unsigned int size) {
+        _str.reserve(size);
+        return true;
+    }
+
+    bool concat(const String& other) {
+        _str += other._str;
+        return true;
+    }
+    bool concat(const char* cstr) {
+        if (cstr) _str += cstr;
+        return true;
+    }
+    bool concat(const char* cstr, unsigned int length) {
+        if (cstr) _str.append(cstr, length);
+        return true;
+    }
+    bool concat(char c) {
+        _str += c;
+        return true;
+    }
+
+    String& operator+=(const String& other) {
+        concat(other);
+        return *this;
+    }
+    String& operator+=(const char* cstr) {
+        concat(cstr);
+        return *this;
+    }
+    String& operator+=(char c) {
+        concat(c);
+        return *this;
+    }
+
+    bool operator==(const String& other) const { return _str == other._str; }
+    bool operator==(const char* cstr) const { return _str == (cstr ? cstr : ""); }
+    bool operator!=(const String& other) const { return !(*this == other); }
+    bool operator!=(const char* cstr) const { return !(*this == cstr); }
+    bool operator<(const String& other) const { return _str < other._str; }
+
+    char operator[](unsigned int index) const { return index < _str.length() ? _str[index] : 0; }
+    char& operator[](unsigned int index) { return _str[index]; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    bool equals(const String& other) const { return *this == other; }
+    bool startsWith(const String& prefix) const { return _str.rfind(prefix._str, 0) == 0; }
+    bool endsWith(const String& suffix) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& str, unsigned int from = 0) const;
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+    const std::string& str() const { return _str; }
+
+  private:
+    std::string _str;
+};
+
+inline String operator+(const String& lhs, const String& rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+inline String operator+(const String& lhs, const char* rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+inline String operator+(const char* lhs, const String& rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+inline String operator+(const String& lhs, char rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+inline bool operator==(const char* lhs, const String& rhs) {
+    return rhs == lhs;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef NATIVE_WIFI_CLIENT_H
+#define NATIVE_WIFI_CLIENT_H
+
+#include "Client.h"
+
+// TCP klient oven på en POSIX socket, så MQTT kan køre mod en lokal broker
+class WiFiClient : public Client {
+  public:
+    WiFiClient() = default;
+    ~WiFiClient() override;
+    WiFiClient(const WiFiClient&) = delete;
+    WiFiClient& operator=(const WiFiClient&) = delete;
+
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return _socket >= 0; }
+
+    void setTimeout(uint32_t seconds) { _timeoutSeconds = seconds; }
+
+  private:
+    int _socket = -1;
+    uint32_t _timeoutSeconds = 5;
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef NATIVE_WIFI_CLIENT_SECURE_H
+#define NATIVE_WIFI_CLIENT_SECURE_H
+
+#include "WiFiClient.h"
+
+// Ingen TLS på host; firmwaren kalder kun setInsecure()
+class WiFiClientSecure : public WiFiClient {
+  public:
+    void setInsecure() {}
+    void setCACert(const char* rootCA) {}
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include "Arduino.h"
+
+// I2C bus uden enheder; sensorerne simuleres direkte i deres driver-shims
+class TwoWire : public Stream {
+  public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    bool end() { return true; }
+    bool setClock(uint32_t frequency);
+    uint32_t getClock() const { return _clock; }
+
+    void beginTransmission(uint16_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint16_t address, uint8_t size, bool sendStop = true);
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t size) override;
+    using Print::write;
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+  private:
+    uint32_t _clock = 100000;
+    uint16_t _txAddress = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef NATIVE_DRIVER_GPIO_H
+#define NATIVE_DRIVER_GPIO_H
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+typedef enum {
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_LOW_LEVEL = 4,
+    GPIO_INTR_HIGH_LEVEL = 5,
+} gpio_int_type_t;
+
+// Light sleep vågner når en armeret pin når sit niveau (se NativeHal::schedulePinLevel)
+esp_err_t gpio_wakeup_enable(gpio_num_t gpioNum, gpio_int_type_t intrType);
+esp_err_t gpio_wakeup_disable(gpio_num_t gpioNum);
+
+// Fastholder en pins niveau, også gennem deep sleep med gpio_deep_sleep_hold_en. Uden virkning i shimmen
+esp_err_t gpio_hold_en(gpio_num_t gpioNum);
+esp_err_t gpio_hold_dis(gpio_num_t gpioNum);
+void gpio_deep_sleep_hold_en();
+
+#endif
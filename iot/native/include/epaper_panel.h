@@ -0,0 +1,62 @@
+#ifndef NATIVE_EPAPER_PANEL_H
+#define NATIVE_EPAPER_PANEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config/constants.h"
+
+// Model af e-paper controlleren bag SPI shimmen. Afkoder kommandostrømmen fra EpaperDisplay (RAM vinduer,
+// adressetællere, sort og rød RAM), holder BUSY LOW under refresh og husker hvad panelet viser efter hver
+// master activation, så frames kan gemmes som billeder og sammenlignes i tests. Findes kun i native builds.
+namespace NativeHal {
+    class EpaperPanel {
+      public:
+        // Billeder er i GFX orientering som EpaperMonitor tegner dem (landscape)
+        static constexpr int IMAGE_WIDTH = DisplayConstants::EPD_HEIGHT;
+        static constexpr int IMAGE_HEIGHT = DisplayConstants::EPD_WIDTH;
+
+        EpaperPanel();
+
+        // Overtager SPI sinken; detach frigiver den igen
+        void attach();
+        void detach();
+
+        // 0 giver ingen BUSY periode
+        void setRefreshTimes(uint64_t fullUs, uint64_t partialUs);
+
+        uint32_t refreshCount() const { return refreshes; }
+        // DisplayConstants::COLOR_* for det panelet viser
+        uint16_t pixel(int x, int y) const;
+
+        // Det viste billede: PBM med én plan (1 = farvet pixel) eller PNG med alle tre farver
+        std::vector<uint8_t> toPbm(uint16_t color) const;
+        std::vector<uint8_t> toPng() const;
+        bool writeFile(const std::string& path, const std::vector<uint8_t>& data) const;
+
+      private:
+        std::vector<uint8_t> blackRam;
+        std::vector<uint8_t> redRam;
+        std::vector<uint8_t> shownBlack;
+        std::vector<uint8_t> shownRed;
+
+        uint8_t command;
+        size_t parameterIndex;
+        uint8_t parameters[4];
+        uint8_t updateMode;
+        int xStart, xEnd, yStart, yEnd;
+        int xCounter, yCounter;
+        uint64_t fullRefreshUs;
+        uint64_t partialRefreshUs;
+        uint32_t refreshes;
+
+        void onSpi(const uint8_t* data, size_t length, bool dataMode);
+        void onCommand(uint8_t command);
+        void onData(uint8_t value);
+        void resetWindow();
+    };
+}
+
+#endif
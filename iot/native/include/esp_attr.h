@@ -0,0 +1,9 @@
+#ifndef NATIVE_ESP_ATTR_H
+#define NATIVE_ESP_ATTR_H
+
+// Sektionsattributter fra ESP-IDF. På host er der ingen RTC hukommelse; variablerne bliver almindelige
+// nulstillede globale, som efter et strømtab
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Styring af host-shimmen fra host_main, tests og benchmarks. Findes kun i native builds.
+namespace NativeHal {
+    // Klokke: med virtuel tid flytter delay() og light sleep blot klokken frem i stedet for at sove
+    void useVirtualClock(bool enabled);
+    bool isVirtualClock();
+    void advanceMicros(uint64_t us);
+
+    // Serial: når den er slået fra formateres output stadig, men kasseres i stedet for at gå til stdout
+    void setSerialEnabled(bool enabled);
+
+    // GPIO: input pins læser HIGH indtil andet er sat (pull-ups, e-paper BUSY idle)
+    void setPinLevel(uint8_t pin, int level);
+    int getPinLevel(uint8_t pin);
+    // Pin skifter til level når klokken er gået afterUs frem, f.eks. e-paper BUSY efter en refresh
+    void schedulePinLevel(uint8_t pin, int level, uint64_t afterUs);
+
+    // Samlet tid brugt i esp_light_sleep_start
+    uint64_t lightSleepMicros();
+    void setAnalogValue(uint8_t pin, uint16_t value);
+
+    struct BusStats {
+        uint64_t spiBytes;
+        uint64_t spiCalls;
+        uint64_t spiBusTimeUs; // Beregnet ud fra SPI clock, 8 bit pr. byte
+        uint64_t gpioWrites;
+    };
+    const BusStats& busStats();
+    void resetBusStats();
+
+    // Kaldes med hver byte-blok der skrives på SPI bussen (kommandoer og data). Med virtuel tid
+    // flytter hvert kald klokken frem med den modellerede overførselstid
+    using SpiSink = std::function<void(const uint8_t* data, size_t length, bool dataMode)>;
+    void setSpiSink(SpiSink sink);
+    void notifySpi(const uint8_t* data, size_t length, uint32_t clockHz);
+
+    // Simulerede sensorværdier som BME280 og VL53L0X shims returnerer
+    void setEnvironment(float temperatureCelsius, float humidityPercentage);
+    void setDistance(uint16_t millimeters);
+    float environmentTemperature();
+    float environmentHumidity();
+    uint16_t distance();
+
+    // Rodmappe for LittleFS, Preferences og OTA partitioner. Sættes via BRODBUDDY_STORAGE_ROOT
+    // eller oprettes som en midlertidig mappe ved første brug.
+    const std::string& storageRoot();
+    void setStorageRoot(const std::string& path);
+    std::string storagePath(const std::string& relative);
+
+    // Simuleret flash skrivetid for esp_ota_write (rigtig tid, ikke virtuel). 0 = ingen forsinkelse
+    void setFlashWriteDelay(uint32_t microsPerKilobyte);
+
+    // ESP.restart() kalder denne handler; uden handler afsluttes processen
+    void setRestartHandler(std::function<void()> handler);
+}
+
+#endif
@@ -0,0 +1,356 @@
+#include <Arduino.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <random>
+#include <thread>
+
+#include <driver/gpio.h>
+
+#include "config/constants.h"
+#include "native_hal.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point bootTime = Clock::now();
+    // Atomiske, da FreeRTOS tasks i shimmen er rigtige tråde
+    std::atomic<bool> virtualClock{false};
+    std::atomic<uint64_t> virtualMicros{0};
+    uint64_t sleepTimerUs = 0;
+
+    // Cirka hvad Arduino SPI driveren bruger pr. kald på ESP32 før første bit er ude
+    constexpr uint64_t SPI_CALL_OVERHEAD_US = 2;
+
+    std::map<uint8_t, int> pinLevels;
+    // Planlagte skift: pin -> (tidspunkt, niveau)
+    std::map<uint8_t, std::pair<uint64_t, int>> scheduledLevels;
+    std::map<uint8_t, int> wakeLevels;
+    bool timerWakeup = false;
+    bool gpioWakeup = false;
+    esp_sleep_wakeup_cause_t wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    uint64_t lightSleepUs = 0;
+    std::map<uint8_t, uint16_t> analogValues;
+    NativeHal::BusStats stats = {};
+    NativeHal::SpiSink spiSink;
+
+    std::mt19937 rng(42);
+    std::function<void()> restartHandler;
+    bool serialEnabled = true;
+
+    uint64_t nowMicros() {
+        if (virtualClock) {
+            return virtualMicros;
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - bootTime).count();
+    }
+}
+
+namespace NativeHal {
+    void useVirtualClock(bool enabled) {
+        if (enabled && !virtualClock) {
+            virtualMicros = nowMicros();
+        }
+        virtualClock = enabled;
+    }
+
+    bool isVirtualClock() {
+        return virtualClock;
+    }
+
+    void advanceMicros(uint64_t us) {
+        if (virtualClock) {
+            virtualMicros += us;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(us));
+        }
+    }
+
+    void setSerialEnabled(bool enabled) {
+        serialEnabled = enabled;
+    }
+
+    void setPinLevel(uint8_t pin, int level) {
+        pinLevels[pin] = level;
+        scheduledLevels.erase(pin);
+    }
+
+    int getPinLevel(uint8_t pin) {
+        auto scheduled = scheduledLevels.find(pin);
+        if (scheduled != scheduledLevels.end() && nowMicros() >= scheduled->second.first) {
+            pinLevels[pin] = scheduled->second.second;
+            scheduledLevels.erase(scheduled);
+        }
+        auto it = pinLevels.find(pin);
+        return it == pinLevels.end() ? HIGH : it->second;
+    }
+
+    void schedulePinLevel(uint8_t pin, int level, uint64_t afterUs) {
+        scheduledLevels[pin] = {nowMicros() + afterUs, level};
+    }
+
+    uint64_t lightSleepMicros() {
+        return lightSleepUs;
+    }
+
+    void setAnalogValue(uint8_t pin, uint16_t value) {
+        analogValues[pin] = value;
+    }
+
+    const BusStats& busStats() {
+        return stats;
+    }
+
+    void resetBusStats() {
+        stats = {};
+    }
+
+    void setSpiSink(SpiSink sink) {
+        spiSink = std::move(sink);
+    }
+
+    void notifySpi(const uint8_t* data, size_t length, uint32_t clockHz) {
+        stats.spiBytes += length;
+        stats.spiCalls++;
+        uint64_t busTimeUs = clockHz > 0 ? (static_cast<uint64_t>(length) * 8 * 1000000) / clockHz : 0;
+        stats.spiBusTimeUs += busTimeUs;
+        if (virtualClock) {
+            // Overførslen blokerer, så den virtuelle klokke går frem med bustid plus opsætning af transaktionen
+            virtualMicros += busTimeUs + SPI_CALL_OVERHEAD_US;
+        }
+        if (spiSink) {
+            // DC niveauet afgør om det er kommando eller data
+            spiSink(data, length, getPinLevel(Pins::EINK_DC) == HIGH);
+        }
+    }
+
+    void setRestartHandler(std::function<void()> handler) {
+        restartHandler = std::move(handler);
+    }
+}
+
+unsigned long millis() {
+    return static_cast<unsigned long>(nowMicros() / 1000);
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(nowMicros());
+}
+
+void delay(uint32_t ms) {
+    NativeHal::advanceMicros(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    NativeHal::advanceMicros(us);
+}
+
+void yield() {
+    if (!virtualClock) {
+        std::this_thread::yield();
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (mode == INPUT_PULLDOWN) {
+        pinLevels.emplace(pin, LOW);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    pinLevels[pin] = val ? HIGH : LOW;
+    stats.gpioWrites++;
+}
+
+int digitalRead(uint8_t pin) {
+    return NativeHal::getPinLevel(pin);
+}
+
+uint16_t analogRead(uint8_t pin) {
+    auto it = analogValues.find(pin);
+    return it == analogValues.end() ? 0 : it->second;
+}
+
+void analogReadResolution(uint8_t bits) {}
+
+long random(long max) {
+    return max <= 0 ? 0 : random(0, max);
+}
+
+long random(long min, long max) {
+    if (min >= max) {
+        return min;
+    }
+    std::uniform_int_distribution<long> dist(min, max - 1);
+    return dist(rng);
+}
+
+void randomSeed(unsigned long seed) {
+    rng.seed(seed);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    if (inMax == inMin) {
+        return outMin;
+    }
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (!serialEnabled) return 1;
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (!serialEnabled) return size;
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+void EspClass::restart() {
+    fflush(stdout);
+    if (restartHandler) {
+        restartHandler();
+        return;
+    }
+    fprintf(stderr, "ESP.restart() called - exiting host process\n");
+    std::exit(0);
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return 320 * 1024;
+}
+
+uint32_t EspClass::getHeapSize() {
+    return 320 * 1024;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return 320 * 1024;
+}
+
+uint32_t EspClass::getCycleCount() {
+    return static_cast<uint32_t>(nowMicros() * getCpuFreqMHz());
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_OTA_PARTITION_CONFLICT:
+            return "ESP_ERR_OTA_PARTITION_CONFLICT";
+        case ESP_ERR_OTA_SELECT_INFO_INVALID:
+            return "ESP_ERR_OTA_SELECT_INFO_INVALID";
+        case ESP_ERR_OTA_VALIDATE_FAILED:
+            return "ESP_ERR_OTA_VALIDATE_FAILED";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeInUs) {
+    sleepTimerUs = timeInUs;
+    timerWakeup = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    gpioWakeup = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source) {
+    if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL) {
+        timerWakeup = false;
+    }
+    if (source == ESP_SLEEP_WAKEUP_GPIO || source == ESP_SLEEP_WAKEUP_ALL) {
+        gpioWakeup = false;
+    }
+    return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return wakeupCause;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpioNum, gpio_int_type_t intrType) {
+    if (intrType != GPIO_INTR_LOW_LEVEL && intrType != GPIO_INTR_HIGH_LEVEL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    wakeLevels[gpioNum] = intrType == GPIO_INTR_HIGH_LEVEL ? HIGH : LOW;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpioNum) {
+    wakeLevels.erase(gpioNum);
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_en(gpio_num_t gpioNum) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_dis(gpio_num_t gpioNum) {
+    return ESP_OK;
+}
+
+void gpio_deep_sleep_hold_en() {}
+
+esp_err_t esp_light_sleep_start() {
+    // Uden timer sover shimmen ellers bare den sidst armerede tid
+    bool gpioFirst = false;
+    uint64_t sleepUs = sleepTimerUs;
+
+    if (gpioWakeup) {
+        uint64_t now = nowMicros();
+        for (const auto& wake : wakeLevels) {
+            if (NativeHal::getPinLevel(wake.first) == wake.second) {
+                gpioFirst = true;
+                sleepUs = 0;
+                break;
+            }
+            // Et planlagt skift til wake niveauet vækker, hvis det kommer før alt andet
+            auto scheduled = scheduledLevels.find(wake.first);
+            if (scheduled == scheduledLevels.end() || scheduled->second.second != wake.second) {
+                continue;
+            }
+            uint64_t untilWake = scheduled->second.first - now;
+            if ((!timerWakeup && !gpioFirst) || untilWake < sleepUs) {
+                gpioFirst = true;
+                sleepUs = untilWake;
+            }
+        }
+    }
+
+    wakeupCause = gpioFirst ? ESP_SLEEP_WAKEUP_GPIO : ESP_SLEEP_WAKEUP_TIMER;
+    lightSleepUs += sleepUs;
+    NativeHal::advanceMicros(sleepUs);
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+    NativeHal::advanceMicros(sleepTimerUs);
+    wakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+    ESP.restart();
+}
@@ -0,0 +1,94 @@
+#include <SPI.h>
+#include <Wire.h>
+
+#include "config/constants.h"
+#include "native_hal.h"
+
+TwoWire Wire;
+SPIClass SPI;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    if (frequency > 0) {
+        _clock = frequency;
+    }
+    return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+    _clock = frequency;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+    _txAddress = address;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    // Kun de simulerede sensorer ACK'er deres adresse (2 = NACK), så scanI2C finder dem
+    bool present = _txAddress == Sensors::BME280_ADDR_PRIMARY || _txAddress == Sensors::VL53L0X_ADDR_DEFAULT;
+    return present ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint16_t address, uint8_t size, bool sendStop) {
+    return 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size) {
+    return size;
+}
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+    _settings = settings;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+    NativeHal::notifySpi(&data, 1, _settings._clock);
+    return 0xFF;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data) {
+    uint8_t bytes[2] = {static_cast<uint8_t>(data >> 8), static_cast<uint8_t>(data)};
+    NativeHal::notifySpi(bytes, sizeof(bytes), _settings._clock);
+    return 0xFFFF;
+}
+
+uint32_t SPIClass::transfer32(uint32_t data) {
+    uint8_t bytes[4] = {static_cast<uint8_t>(data >> 24), static_cast<uint8_t>(data >> 16),
+                        static_cast<uint8_t>(data >> 8), static_cast<uint8_t>(data)};
+    NativeHal::notifySpi(bytes, sizeof(bytes), _settings._clock);
+    return 0xFFFFFFFF;
+}
+
+void SPIClass::transfer(void* data, uint32_t size) {
+    NativeHal::notifySpi(static_cast<const uint8_t*>(data), size, _settings._clock);
+    memset(data, 0xFF, size);
+}
+
+void SPIClass::transferBytes(const uint8_t* data, uint8_t* out, uint32_t size) {
+    NativeHal::notifySpi(data, size, _settings._clock);
+    if (out) {
+        memset(out, 0xFF, size);
+    }
+}
+
+void SPIClass::write(uint8_t data) {
+    NativeHal::notifySpi(&data, 1, _settings._clock);
+}
+
+void SPIClass::write16(uint16_t data) {
+    transfer16(data);
+}
+
+void SPIClass::write32(uint32_t data) {
+    transfer32(data);
+}
+
+void SPIClass::writeBytes(const uint8_t* data, uint32_t size) {
+    NativeHal::notifySpi(data, size, _settings._clock);
+}
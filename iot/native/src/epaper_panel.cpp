@@ -0,0 +1,220 @@
+#include "epaper_panel.h"
+
+#include <Arduino.h>
+
+#include <cstdio>
+
+#include "native_hal.h"
+#include "network/crc32.h"
+
+namespace {
+    constexpr int ROW_BYTES = DisplayConstants::EPD_WIDTH / 8;
+
+    void appendBe32(std::vector<uint8_t>& out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void appendChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+        appendBe32(out, static_cast<uint32_t>(data.size()));
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        appendBe32(out, Crc32::update(0, out.data() + start, out.size() - start));
+    }
+
+    // zlib strøm med ukomprimerede deflate blokke; nok til små testbilleder og kræver ingen zlib
+    std::vector<uint8_t> zlibStored(const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> out = {0x78, 0x01};
+        size_t offset = 0;
+        do {
+            size_t length = std::min<size_t>(0xFFFF, data.size() - offset);
+            bool last = offset + length == data.size();
+            out.push_back(last ? 1 : 0);
+            out.push_back(static_cast<uint8_t>(length));
+            out.push_back(static_cast<uint8_t>(length >> 8));
+            out.push_back(static_cast<uint8_t>(~length));
+            out.push_back(static_cast<uint8_t>(~length >> 8));
+            out.insert(out.end(), data.begin() + offset, data.begin() + offset + length);
+            offset += length;
+        } while (offset < data.size());
+
+        uint32_t a = 1, b = 0;
+        for (uint8_t value : data) {
+            a = (a + value) % 65521;
+            b = (b + a) % 65521;
+        }
+        appendBe32(out, (b << 16) | a);
+        return out;
+    }
+}
+
+namespace NativeHal {
+    EpaperPanel::EpaperPanel()
+        : blackRam(DisplayConstants::EPD_BUFFER_SIZE, 0xFF), redRam(DisplayConstants::EPD_BUFFER_SIZE, 0x00),
+          shownBlack(blackRam), shownRed(redRam), command(0), parameterIndex(0), parameters(), updateMode(0),
+          fullRefreshUs(0), partialRefreshUs(0), refreshes(0) {
+        resetWindow();
+    }
+
+    void EpaperPanel::attach() {
+        setSpiSink([this](const uint8_t* data, size_t length, bool dataMode) { onSpi(data, length, dataMode); });
+    }
+
+    void EpaperPanel::detach() {
+        setSpiSink(nullptr);
+    }
+
+    void EpaperPanel::setRefreshTimes(uint64_t fullUs, uint64_t partialUs) {
+        fullRefreshUs = fullUs;
+        partialRefreshUs = partialUs;
+    }
+
+    uint16_t EpaperPanel::pixel(int x, int y) const {
+        // Samme afbildning som EpaperDisplay::drawPixel: GFX x er controllerens række
+        size_t index = y / 8 + x * ROW_BYTES;
+        uint8_t bit = 0x80 >> (y % 8);
+        if (shownRed[index] & bit) {
+            return DisplayConstants::COLOR_RED;
+        }
+        return (shownBlack[index] & bit) ? DisplayConstants::COLOR_WHITE : DisplayConstants::COLOR_BLACK;
+    }
+
+    std::vector<uint8_t> EpaperPanel::toPbm(uint16_t color) const {
+        char header[32];
+        int headerLength = snprintf(header, sizeof(header), "P4\n%d %d\n", IMAGE_WIDTH, IMAGE_HEIGHT);
+        std::vector<uint8_t> out(header, header + headerLength);
+
+        size_t rowBytes = (IMAGE_WIDTH + 7) / 8;
+        for (int y = 0; y < IMAGE_HEIGHT; y++) {
+            size_t row = out.size();
+            out.resize(row + rowBytes, 0);
+            for (int x = 0; x < IMAGE_WIDTH; x++) {
+                if (pixel(x, y) == color) {
+                    out[row + x / 8] |= 0x80 >> (x % 8);
+                }
+            }
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> EpaperPanel::toPng() const {
+        const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        std::vector<uint8_t> out(signature, signature + sizeof(signature));
+
+        // 8 bit palette: indeks er DisplayConstants::COLOR_*
+        std::vector<uint8_t> header;
+        appendBe32(header, IMAGE_WIDTH);
+        appendBe32(header, IMAGE_HEIGHT);
+        header.insert(header.end(), {8, 3, 0, 0, 0});
+        appendChunk(out, "IHDR", header);
+        appendChunk(out, "PLTE", {0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xD0, 0x10, 0x10});
+
+        std::vector<uint8_t> pixels;
+        pixels.reserve((IMAGE_WIDTH + 1) * IMAGE_HEIGHT);
+        for (int y = 0; y < IMAGE_HEIGHT; y++) {
+            pixels.push_back(0); // Filter: ingen
+            for (int x = 0; x < IMAGE_WIDTH; x++) {
+                pixels.push_back(static_cast<uint8_t>(pixel(x, y)));
+            }
+        }
+        appendChunk(out, "IDAT", zlibStored(pixels));
+        appendChunk(out, "IEND", {});
+        return out;
+    }
+
+    bool EpaperPanel::writeFile(const std::string& path, const std::vector<uint8_t>& data) const {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    void EpaperPanel::onSpi(const uint8_t* data, size_t length, bool dataMode) {
+        for (size_t i = 0; i < length; i++) {
+            if (dataMode) {
+                onData(data[i]);
+            } else {
+                onCommand(data[i]);
+            }
+        }
+    }
+
+    void EpaperPanel::onCommand(uint8_t value) {
+        command = value;
+        parameterIndex = 0;
+
+        if (command == DisplayConstants::CMD_SWRESET) {
+            resetWindow();
+        } else if (command == DisplayConstants::CMD_MASTER_ACTIVATION) {
+            shownBlack = blackRam;
+            shownRed = redRam;
+            refreshes++;
+
+            uint64_t busyUs = updateMode == DisplayConstants::PARAM_UPDATE_PARTIAL ? partialRefreshUs : fullRefreshUs;
+            if (busyUs > 0) {
+                setPinLevel(Pins::EINK_BUSY, LOW);
+                schedulePinLevel(Pins::EINK_BUSY, HIGH, busyUs);
+            }
+        }
+    }
+
+    void EpaperPanel::onData(uint8_t value) {
+        if (command == DisplayConstants::CMD_WRITE_RAM_BLACK || command == DisplayConstants::CMD_WRITE_RAM_RED) {
+            // Data entry mode 0x03: x tæller op til vinduets kant, derefter næste række
+            if (xCounter >= 0 && xCounter < ROW_BYTES && yCounter >= 0 && yCounter < DisplayConstants::EPD_HEIGHT) {
+                std::vector<uint8_t>& ram = command == DisplayConstants::CMD_WRITE_RAM_BLACK ? blackRam : redRam;
+                ram[yCounter * ROW_BYTES + xCounter] = value;
+            }
+            if (++xCounter > xEnd) {
+                xCounter = xStart;
+                yCounter = yCounter >= yEnd ? yStart : yCounter + 1;
+            }
+            return;
+        }
+
+        if (parameterIndex < sizeof(parameters)) {
+            parameters[parameterIndex] = value;
+        }
+        parameterIndex++;
+
+        switch (command) {
+            case DisplayConstants::CMD_DISPLAY_UPDATE:
+                updateMode = value;
+                break;
+            case DisplayConstants::CMD_RAM_X_RANGE:
+                if (parameterIndex == 2) {
+                    xStart = parameters[0];
+                    xEnd = parameters[1];
+                }
+                break;
+            case DisplayConstants::CMD_RAM_Y_RANGE:
+                if (parameterIndex == 4) {
+                    yStart = parameters[0] | (parameters[1] << 8);
+                    yEnd = parameters[2] | (parameters[3] << 8);
+                }
+                break;
+            case DisplayConstants::CMD_RAM_X_COUNTER:
+                xCounter = value;
+                break;
+            case DisplayConstants::CMD_RAM_Y_COUNTER:
+                if (parameterIndex == 2) {
+                    yCounter = parameters[0] | (parameters[1] << 8);
+                }
+                break;
+        }
+    }
+
+    void EpaperPanel::resetWindow() {
+        xStart = 0;
+        xEnd = ROW_BYTES - 1;
+        yStart = 0;
+        yEnd = DisplayConstants::EPD_HEIGHT - 1;
+        xCounter = 0;
+        yCounter = 0;
+    }
+}
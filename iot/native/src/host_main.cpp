@@ -0,0 +1,221 @@
+// Host-program for [env:native]: kører et antal måle-/visningscyklusser og en OTA opdatering
+// gennem de rigtige moduler, så hot paths kan profileres og regressionstestes uden hardware.
+// Sæt BRODBUDDY_MQTT_HOST (og evt. BRODBUDDY_MQTT_PORT) for også at forbinde til en lokal broker.
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <vector>
+
+#include "app/epaper_monitor.h"
+#include "app/history_store.h"
+#include "config/settings.h"
+#include "config/time_utils.h"
+#include "epaper_panel.h"
+#include "hardware/epaper_display.h"
+#include "hardware/sensor_manager.h"
+#include "logging/logger.h"
+#include "native_hal.h"
+#include "network/crc32.h"
+#include "network/mqtt_manager.h"
+#include "network/mqtt_message_router.h"
+#include "network/mqtt_protocol.h"
+#include "network/mqtt_topics.h"
+#include "network/ota_manager.h"
+
+static const char* TAG = "HostMain";
+
+namespace {
+    constexpr int SENSING_CYCLES = 24;
+    constexpr uint32_t OTA_IMAGE_SIZE = 64 * 1024 + 123;
+    constexpr uint32_t OTA_CHUNK_SIZE = 4096;
+    // Så længe panelet holder BUSY LOW efter master activation
+    constexpr uint64_t PANEL_FULL_REFRESH_US = 3000000;
+    constexpr uint64_t PANEL_PARTIAL_REFRESH_US = 700000;
+
+    Settings settings;
+    SensorManager sensorManager;
+    EpaperDisplay display;
+    EpaperMonitor monitor(display);
+    SourdoughData historicalData = {};
+    HistoryStore historyStore;
+    OtaManager otaManager;
+    MqttManager mqttManager;
+    MqttMessageRouter messageRouter;
+    MqttTopics* mqttTopics = nullptr;
+    bool restartRequested = false;
+    uint64_t spiBytes = 0;
+    NativeHal::EpaperPanel panel;
+
+    void runSensingCycles() {
+        unsigned long interval = TimeUtils::to_ms(std::chrono::seconds(settings.getSensorInterval()));
+
+        for (int cycle = 0; cycle < SENSING_CYCLES; cycle++) {
+            // Dejen hæver 6 mm pr. cyklus de første 2/3, derefter falder den igen
+            int rise = cycle < SENSING_CYCLES * 2 / 3 ? cycle * 6 : (SENSING_CYCLES * 4 / 3 - cycle) * 6;
+            NativeHal::setDistance(static_cast<uint16_t>(400 - rise));
+
+            if (!sensorManager.collectMultipleSamples()) {
+                LOG_E(TAG, "Sensor sampling failed in cycle %d", cycle);
+                continue;
+            }
+
+            const SensorData& sensorData = sensorManager.getCurrentData();
+            historicalData.inTemp = sensorData.inTemp;
+            historicalData.inHumidity = (int)sensorData.inHumidity;
+            historicalData.currentGrowth = (int)sensorData.currentRisePercent;
+
+            unsigned long timestamp = TimeConstants::FALLBACK_EPOCH + millis() / 1000;
+            monitor.addDataPoint(historicalData, (int)sensorData.currentRisePercent, timestamp);
+            historyStore.record(historicalData, timestamp, (int)sensorData.currentRisePercent);
+            NativeHal::resetBusStats();
+            monitor.updateDisplay(historicalData);
+            spiBytes += NativeHal::busStats().spiBytes;
+            LOG_D(TAG, "Cycle %d frame: %llu SPI calls, %llu GPIO writes, upload %lu us, refresh %lu ms", cycle,
+                  static_cast<unsigned long long>(NativeHal::busStats().spiCalls),
+                  static_cast<unsigned long long>(NativeHal::busStats().gpioWrites), display.getLastUploadMicros(),
+                  display.getLastRefreshMillis());
+
+            NativeHal::advanceMicros(static_cast<uint64_t>(interval) * 1000);
+        }
+    }
+
+    bool runOtaUpdate() {
+        std::vector<uint8_t> image(OTA_IMAGE_SIZE);
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = static_cast<uint8_t>((i * 31) ^ (i >> 7));
+        }
+
+        MqttTopics topics(settings.getAnalyzerId());
+        messageRouter.setTopics(&topics);
+        messageRouter.setOtaHandler([&topics](const String& topic, const uint8_t* payload, unsigned int length) {
+            otaManager.handleOtaMessage(topic, payload, length, topics.getOtaStartTopic(), topics.getOtaChunkTopic());
+        });
+        NativeHal::setRestartHandler([]() { restartRequested = true; });
+
+        DynamicJsonDocument startDoc(256);
+        startDoc[MqttProtocol::OtaFields::VERSION] = "host-1.0.0";
+        startDoc[MqttProtocol::OtaFields::SIZE] = OTA_IMAGE_SIZE;
+        startDoc[MqttProtocol::OtaFields::CRC32] = Crc32::updateBitwise(0, image.data(), image.size());
+        String startPayload;
+        serializeJson(startDoc, startPayload);
+
+        String startTopic = topics.getOtaStartTopic();
+        messageRouter.routeMessage(const_cast<char*>(startTopic.c_str()),
+                                   reinterpret_cast<byte*>(const_cast<char*>(startPayload.c_str())),
+                                   startPayload.length());
+
+        String chunkTopic = topics.getOtaChunkTopic();
+        std::vector<uint8_t> chunk(OtaConstants::CHUNK_HEADER_SIZE + OTA_CHUNK_SIZE);
+        for (uint32_t offset = 0, index = 0; offset < image.size(); offset += OTA_CHUNK_SIZE, index++) {
+            uint32_t size = std::min<uint32_t>(OTA_CHUNK_SIZE, image.size() - offset);
+            memcpy(chunk.data(), &index, 4);
+            memcpy(chunk.data() + 4, &size, 4);
+            memcpy(chunk.data() + OtaConstants::CHUNK_HEADER_SIZE, image.data() + offset, size);
+            messageRouter.routeMessage(const_cast<char*>(chunkTopic.c_str()), chunk.data(),
+                                       OtaConstants::CHUNK_HEADER_SIZE + size);
+        }
+
+        messageRouter.setTopics(mqttTopics);
+        NativeHal::setRestartHandler(nullptr);
+
+        const esp_partition_t* bootPartition = esp_ota_get_boot_partition();
+        LOG_I(TAG, "OTA finished - status: %d, restart requested: %s, boot partition: %s",
+              static_cast<int>(otaManager.getStatus()), restartRequested ? "yes" : "no", bootPartition->label);
+        return restartRequested && otaManager.getStatus() == OtaManager::OtaStatus::REBOOTING;
+    }
+
+    void handleDiagnosticsRequest(const String& topic, const uint8_t* payload, unsigned int length) {
+        DynamicJsonDocument responseDoc(512);
+        responseDoc[MqttProtocol::DiagnosticsFields::ANALYZER_ID] = settings.getAnalyzerId();
+        responseDoc[MqttProtocol::DiagnosticsFields::UPTIME] = millis();
+        responseDoc[MqttProtocol::DiagnosticsFields::FREE_HEAP] = ESP.getFreeHeap();
+        responseDoc[MqttProtocol::DiagnosticsFields::STATE] = "HOST";
+        mqttManager.publish(mqttTopics->getDiagnosticsResponseTopic().c_str(), responseDoc);
+    }
+
+    void runMqttSession(const char* host) {
+        const char* portValue = getenv("BRODBUDDY_MQTT_PORT");
+        int port = portValue ? atoi(portValue) : settings.getMqttPort();
+        String analyzerId = settings.getAnalyzerId();
+
+        mqttTopics = new MqttTopics(analyzerId);
+        mqttManager.setTopics(mqttTopics);
+        messageRouter.setTopics(mqttTopics);
+        messageRouter.setDiagnosticsHandler(handleDiagnosticsRequest);
+
+        if (!mqttManager.begin(host, port, "", "", analyzerId.c_str())) {
+            LOG_E(TAG, "Could not connect to MQTT broker at %s:%d", host, port);
+            return;
+        }
+
+        mqttManager.setCallback([](char* topic, byte* payload, unsigned int length) {
+            messageRouter.routeMessage(topic, payload, length);
+        });
+        mqttManager.subscribe(mqttTopics->getDiagnosticsRequestTopic().c_str());
+
+        DynamicJsonDocument doc(512);
+        const SensorData& data = sensorManager.getCurrentData();
+        doc[MqttProtocol::TelemetryFields::EPOCH_TIME] = TimeConstants::FALLBACK_EPOCH + millis() / 1000;
+        doc[MqttProtocol::TelemetryFields::TEMPERATURE] = data.inTemp;
+        doc[MqttProtocol::TelemetryFields::HUMIDITY] = data.inHumidity;
+        doc[MqttProtocol::TelemetryFields::RISE] = data.currentRisePercent;
+        doc[MqttProtocol::TelemetryFields::FEEDING_NUMBER] = settings.getFeedingNumber();
+        mqttManager.publish(mqttTopics->getTelemetryTopic().c_str(), doc);
+
+        // Besvar diagnostics requests i 10 sekunder rigtig tid
+        NativeHal::useVirtualClock(false);
+        unsigned long start = millis();
+        while (millis() - start < 10000) {
+            mqttManager.loop();
+            TimeUtils::delay_for(TimeConstants::OTA_MQTT_LOOP_INTERVAL);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    NativeHal::useVirtualClock(true);
+    Logger::begin(LOG_INFO, false, false);
+
+    LOG_I(TAG, "--- Sourdough analyzer host run, storage: %s ---", NativeHal::storageRoot().c_str());
+
+    if (!settings.begin()) {
+        LOG_E(TAG, "Failed to initialize settings");
+        return 1;
+    }
+
+    // Med en fast BRODBUDDY_STORAGE_ROOT fortsætter kurven fra journalen i forrige kørsel
+    historyStore.restore(monitor, historicalData);
+
+    panel.setRefreshTimes(PANEL_FULL_REFRESH_US, PANEL_PARTIAL_REFRESH_US);
+    panel.attach();
+    display.begin();
+    display.setLightSleepWhileBusy(true);
+    sensorManager.begin();
+    sensorManager.setCalibration(settings.getTempOffset(), settings.getHumOffset());
+
+    runSensingCycles();
+    LOG_I(TAG, "Sensing done - growth: %d%%, peak: %d%% (%.1fh ago), SPI bytes: %llu, refreshes: %u (%u skipped), "
+          "light sleep while busy: %.1f s",
+          historicalData.currentGrowth, historicalData.peakGrowth, historicalData.peakHoursAgo,
+          static_cast<unsigned long long>(spiBytes), static_cast<unsigned>(display.getRefreshCount()),
+          static_cast<unsigned>(display.getSkippedRefreshCount()), NativeHal::lightSleepMicros() / 1e6);
+
+    // Sidste frame som billede, så tegningen kan ses uden hardware
+    std::string framePath = NativeHal::storageRoot() + "/display.png";
+    if (panel.writeFile(framePath, panel.toPng())) {
+        LOG_I(TAG, "Display frame written to %s", framePath.c_str());
+    }
+
+    bool otaOk = runOtaUpdate();
+
+    const char* mqttHost = getenv("BRODBUDDY_MQTT_HOST");
+    if (mqttHost && *mqttHost) {
+        runMqttSession(mqttHost);
+    }
+
+    return otaOk ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,435 @@
+#include <PubSubClient.h>
+#include <WiFiClient.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    // Socket timeouts måles i rigtig tid, også når resten af shimmen kører på virtuel klokke
+    unsigned long wallMillis() {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    constexpr uint8_t PACKET_CONNECT = 0x10;
+    constexpr uint8_t PACKET_CONNACK = 0x20;
+    constexpr uint8_t PACKET_PUBLISH = 0x30;
+    constexpr uint8_t PACKET_PUBACK = 0x40;
+    constexpr uint8_t PACKET_SUBSCRIBE = 0x82;
+    constexpr uint8_t PACKET_UNSUBSCRIBE = 0xA2;
+    constexpr uint8_t PACKET_PINGREQ = 0xC0;
+    constexpr uint8_t PACKET_PINGRESP = 0xD0;
+    constexpr uint8_t PACKET_DISCONNECT = 0xE0;
+
+    constexpr size_t MAX_HEADER_SIZE = 5; // Fast header plus op til fire længde-bytes
+}
+
+WiFiClient::~WiFiClient() {
+    stop();
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host, service.c_str(), &hints, &result) != 0) {
+        return 0;
+    }
+
+    for (addrinfo* addr = result; addr != nullptr; addr = addr->ai_next) {
+        int fd = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (fd < 0) continue;
+
+        timeval timeout = {static_cast<time_t>(_timeoutSeconds), 0};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        if (::connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+            _socket = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(result);
+    return _socket >= 0 ? 1 : 0;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    size_t sent = 0;
+    while (_socket >= 0 && sent < size) {
+        ssize_t n = ::send(_socket, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            stop();
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return sent;
+}
+
+int WiFiClient::available() {
+    if (_socket < 0) return 0;
+    int count = 0;
+    return ioctl(_socket, FIONREAD, &count) == 0 ? count : 0;
+}
+
+int WiFiClient::read() {
+    uint8_t value;
+    return read(&value, 1) == 1 ? value : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (_socket < 0) return -1;
+    ssize_t n = ::recv(_socket, buffer, size, MSG_DONTWAIT);
+    if (n == 0) {
+        stop();
+        return -1;
+    }
+    return n < 0 ? -1 : static_cast<int>(n);
+}
+
+int WiFiClient::peek() {
+    uint8_t value;
+    if (_socket < 0) return -1;
+    return ::recv(_socket, &value, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? value : -1;
+}
+
+void WiFiClient::stop() {
+    if (_socket >= 0) {
+        ::close(_socket);
+        _socket = -1;
+    }
+}
+
+uint8_t WiFiClient::connected() {
+    if (_socket < 0) return 0;
+    uint8_t value;
+    ssize_t n = ::recv(_socket, &value, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+PubSubClient& PubSubClient::setServer(const char* domain, uint16_t port) {
+    _domain = domain ? domain : "";
+    _port = port;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
+    this->callback = std::move(callback);
+    return *this;
+}
+
+PubSubClient& PubSubClient::setClient(Client& client) {
+    _client = &client;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setKeepAlive(uint16_t keepAlive) {
+    _keepAlive = keepAlive;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setSocketTimeout(uint16_t timeout) {
+    _socketTimeout = timeout;
+    return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+    if (size == 0) return false;
+    _buffer.resize(size);
+    return true;
+}
+
+bool PubSubClient::connect(const char* id) {
+    return connect(id, nullptr, nullptr);
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass) {
+    if (!_client) return false;
+    if (connected()) return true;
+
+    if (!_client->connect(_domain.c_str(), _port)) {
+        _state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+
+    std::vector<uint8_t> body;
+    appendString(body, "MQTT");
+    body.push_back(0x04);
+    uint8_t flags = 0x02;
+    if (user && *user) flags |= 0x80;
+    if (user && *user && pass) flags |= 0x40;
+    body.push_back(flags);
+    body.push_back(static_cast<uint8_t>(_keepAlive >> 8));
+    body.push_back(static_cast<uint8_t>(_keepAlive & 0xFF));
+    appendString(body, id);
+    if (flags & 0x80) appendString(body, user);
+    if (flags & 0x40) appendString(body, pass);
+
+    size_t responseLength = 0;
+    if (!sendPacket(PACKET_CONNECT, body) || !waitForPacket(PACKET_CONNACK, responseLength) || responseLength < 2) {
+        _state = MQTT_CONNECTION_TIMEOUT;
+        _client->stop();
+        return false;
+    }
+    if (_buffer[1] != 0) {
+        _state = _buffer[1];
+        _client->stop();
+        return false;
+    }
+
+    _lastInActivity = _lastOutActivity = wallMillis();
+    _pingOutstanding = false;
+    _state = MQTT_CONNECTED;
+    return true;
+}
+
+void PubSubClient::disconnect() {
+    if (_client && _state == MQTT_CONNECTED) {
+        sendPacket(PACKET_DISCONNECT, {});
+        _client->stop();
+    }
+    _state = MQTT_DISCONNECTED;
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), payload ? strlen(payload) : 0, false);
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), payload ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength, bool retained) {
+    if (!connected()) return false;
+    size_t topicLength = strlen(topic);
+    size_t length = 2 + topicLength + plength;
+    // Samme grænse som biblioteket: hele pakken skal kunne være i bufferen
+    if (length + MAX_HEADER_SIZE > _buffer.size()) return false;
+
+    // Som i biblioteket bygges pakken i den buffer modtagne beskeder ligger i. Peger payload ind i en
+    // modtaget besked, er den overskrevet allerede mens den kopieres
+    uint8_t* out = _buffer.data() + MAX_HEADER_SIZE;
+    out[0] = static_cast<uint8_t>(topicLength >> 8);
+    out[1] = static_cast<uint8_t>(topicLength & 0xFF);
+    memcpy(out + 2, topic, topicLength);
+    for (unsigned int i = 0; i < plength; i++) {
+        out[2 + topicLength + i] = payload[i];
+    }
+
+    std::vector<uint8_t> header = {static_cast<uint8_t>(PACKET_PUBLISH | (retained ? 0x01 : 0x00))};
+    appendLength(header, length);
+    bool ok = _client->write(header.data(), header.size()) == header.size() && _client->write(out, length) == length;
+    if (ok) {
+        _lastOutActivity = wallMillis();
+    }
+    return ok;
+}
+
+bool PubSubClient::beginPublish(const char* topic, unsigned int plength, bool retained) {
+    if (!connected()) return false;
+    std::vector<uint8_t> packet = {static_cast<uint8_t>(PACKET_PUBLISH | (retained ? 0x01 : 0x00))};
+    appendLength(packet, strlen(topic) + 2 + plength);
+    appendString(packet, topic);
+    return _client->write(packet.data(), packet.size()) == packet.size();
+}
+
+int PubSubClient::endPublish() {
+    _lastOutActivity = wallMillis();
+    return connected() ? 1 : 0;
+}
+
+size_t PubSubClient::write(uint8_t c) {
+    return _client ? _client->write(c) : 0;
+}
+
+size_t PubSubClient::write(const uint8_t* buffer, size_t size) {
+    return _client ? _client->write(buffer, size) : 0;
+}
+
+bool PubSubClient::subscribe(const char* topic, uint8_t qos) {
+    if (!connected() || !topic) return false;
+    std::vector<uint8_t> body;
+    uint16_t messageId = _nextMessageId++;
+    body.push_back(static_cast<uint8_t>(messageId >> 8));
+    body.push_back(static_cast<uint8_t>(messageId & 0xFF));
+    appendString(body, topic);
+    body.push_back(qos > 1 ? 1 : qos);
+    return sendPacket(PACKET_SUBSCRIBE, body);
+}
+
+bool PubSubClient::unsubscribe(const char* topic) {
+    if (!connected() || !topic) return false;
+    std::vector<uint8_t> body;
+    uint16_t messageId = _nextMessageId++;
+    body.push_back(static_cast<uint8_t>(messageId >> 8));
+    body.push_back(static_cast<uint8_t>(messageId & 0xFF));
+    appendString(body, topic);
+    return sendPacket(PACKET_UNSUBSCRIBE, body);
+}
+
+bool PubSubClient::loop() {
+    if (!connected()) return false;
+
+    unsigned long now = wallMillis();
+    unsigned long keepAliveMs = static_cast<unsigned long>(_keepAlive) * 1000;
+    if (keepAliveMs > 0 && (now - _lastInActivity > keepAliveMs || now - _lastOutActivity > keepAliveMs)) {
+        if (_pingOutstanding) {
+            _state = MQTT_CONNECTION_TIMEOUT;
+            _client->stop();
+            return false;
+        }
+        sendPacket(PACKET_PINGREQ, {});
+        _lastInActivity = now;
+        _pingOutstanding = true;
+    }
+
+    while (_client->available() > 0) {
+        uint8_t header;
+        size_t length;
+        if (!readPacket(header, length)) {
+            break;
+        }
+        handlePacket(header, length);
+    }
+    return connected();
+}
+
+bool PubSubClient::connected() {
+    if (!_client) return false;
+    if (!_client->connected()) {
+        if (_state == MQTT_CONNECTED) {
+            _state = MQTT_CONNECTION_LOST;
+        }
+        return false;
+    }
+    return _state == MQTT_CONNECTED;
+}
+
+void PubSubClient::handlePacket(uint8_t header, size_t length) {
+    _lastInActivity = wallMillis();
+    uint8_t type = header & 0xF0;
+    uint8_t* body = _buffer.data();
+
+    if (type == PACKET_PUBLISH && length >= 2) {
+        size_t topicLength = (static_cast<size_t>(body[0]) << 8) | body[1];
+        size_t payloadStart = 2 + topicLength;
+        uint8_t qos = (header >> 1) & 0x03;
+        uint16_t messageId = 0;
+        if (qos > 0 && length >= payloadStart + 2) {
+            messageId = static_cast<uint16_t>((body[payloadStart] << 8) | body[payloadStart + 1]);
+            payloadStart += 2;
+        }
+        if (payloadStart > length) return;
+
+        // Topic nul-termineres ved at flytte den én byte frem, ligesom i biblioteket. Topic og payload peger
+        // ind i _buffer og er kun gyldige indtil næste publish
+        memmove(body, body + 2, topicLength);
+        body[topicLength] = '\0';
+        if (callback) {
+            unsigned int payloadLength = static_cast<unsigned int>(length - payloadStart);
+            callback(reinterpret_cast<char*>(body), body + payloadStart, payloadLength);
+        }
+        if (qos == 1) {
+            sendPacket(PACKET_PUBACK, {static_cast<uint8_t>(messageId >> 8), static_cast<uint8_t>(messageId & 0xFF)});
+        }
+    } else if (type == PACKET_PINGREQ) {
+        sendPacket(PACKET_PINGRESP, {});
+    } else if (type == PACKET_PINGRESP) {
+        _pingOutstanding = false;
+    }
+}
+
+bool PubSubClient::sendPacket(uint8_t header, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> packet = {header};
+    appendLength(packet, body.size());
+    packet.insert(packet.end(), body.begin(), body.end());
+    bool ok = _client->write(packet.data(), packet.size()) == packet.size();
+    if (ok) {
+        _lastOutActivity = wallMillis();
+    }
+    return ok;
+}
+
+bool PubSubClient::readByte(uint8_t& value) {
+    unsigned long start = wallMillis();
+    while (_client->available() <= 0) {
+        if (!_client->connected() || wallMillis() - start > static_cast<unsigned long>(_socketTimeout) * 1000) {
+            return false;
+        }
+        usleep(1000);
+    }
+    int c = _client->read();
+    if (c < 0) return false;
+    value = static_cast<uint8_t>(c);
+    return true;
+}
+
+bool PubSubClient::readPacket(uint8_t& header, size_t& length) {
+    if (!readByte(header)) return false;
+
+    length = 0;
+    size_t multiplier = 1;
+    uint8_t digit;
+    do {
+        if (!readByte(digit)) return false;
+        length += (digit & 0x7F) * multiplier;
+        multiplier *= 128;
+    } while ((digit & 0x80) != 0 && multiplier <= 128 * 128 * 128);
+
+    // Pakken læses ind i den fælles buffer; pakker større end bufferen droppes, som i biblioteket
+    bool fits = length + MAX_HEADER_SIZE <= _buffer.size();
+    for (size_t i = 0; i < length; i++) {
+        uint8_t value;
+        if (!readByte(value)) return false;
+        if (fits) _buffer[i] = value;
+    }
+    return fits;
+}
+
+bool PubSubClient::waitForPacket(uint8_t expectedType, size_t& length) {
+    uint8_t header;
+    while (readPacket(header, length)) {
+        if ((header & 0xF0) == expectedType) {
+            return true;
+        }
+        handlePacket(header, length);
+    }
+    return false;
+}
+
+void PubSubClient::appendString(std::vector<uint8_t>& body, const char* value) {
+    size_t length = value ? strlen(value) : 0;
+    body.push_back(static_cast<uint8_t>(length >> 8));
+    body.push_back(static_cast<uint8_t>(length & 0xFF));
+    body.insert(body.end(), value, value + length);
+}
+
+void PubSubClient::appendLength(std::vector<uint8_t>& packet, size_t length) {
+    do {
+        uint8_t digit = length % 128;
+        length /= 128;
+        if (length > 0) digit |= 0x80;
+        packet.push_back(digit);
+    } while (length > 0);
+}
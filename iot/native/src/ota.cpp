@@ -0,0 +1,252 @@
+#include <esp_ota_ops.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "native_hal.h"
+
+namespace {
+    // Samme layout som partitions.csv
+    const esp_partition_t partitions[] = {
+        {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, 0x10000, 0x140000, "factory", false},
+        {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x150000, 0x140000, "ota_0", false},
+        {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x290000, 0x140000, "ota_1", false},
+    };
+
+    struct OtaSession {
+        const esp_partition_t* partition;
+        FILE* image;
+        uint32_t written;
+    };
+
+    // OTA kan skrives fra en writer task (std::thread i shimmen)
+    std::mutex sessionsMutex;
+    std::map<esp_ota_handle_t, OtaSession> sessions;
+    esp_ota_handle_t nextHandle = 1;
+    std::atomic<uint32_t> flashWriteDelayUsPerKb{0};
+    const esp_partition_t* runningPartition = nullptr;
+
+    std::string imagePath(const esp_partition_t* partition) {
+        return NativeHal::storagePath(std::string("partitions/") + partition->label + ".bin");
+    }
+
+    std::string otadataPath() {
+        return NativeHal::storagePath("partitions/otadata");
+    }
+
+    const esp_partition_t* findPartition(const std::string& label) {
+        for (const auto& partition : partitions) {
+            if (label == partition.label) return &partition;
+        }
+        return nullptr;
+    }
+
+    struct OtaData {
+        std::string bootLabel = "factory";
+        esp_ota_img_states_t state = ESP_OTA_IMG_VALID;
+    };
+
+    OtaData readOtaData() {
+        OtaData data;
+        std::ifstream in(otadataPath());
+        int state = ESP_OTA_IMG_VALID;
+        if (in >> data.bootLabel >> state) {
+            data.state = static_cast<esp_ota_img_states_t>(state);
+        }
+        return data;
+    }
+
+    void writeOtaData(const OtaData& data) {
+        std::ofstream out(otadataPath(), std::ios::trunc);
+        out << data.bootLabel << " " << static_cast<int>(data.state) << "\n";
+    }
+
+    // Simuleret erase/program tid; rigtig tid så pipelining kan måles
+    void simulateFlashLatency(size_t size) {
+        if (flashWriteDelayUsPerKb > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(size * flashWriteDelayUsPerKb / 1024));
+        }
+    }
+
+    // Skriver direkte i partitionens fil uden for en OTA session; kaldes med sessionsMutex låst
+    esp_err_t writeFileRange(const esp_partition_t* partition, size_t offset, const void* data, size_t size) {
+        FILE* image = fopen(imagePath(partition).c_str(), "r+b");
+        if (!image) {
+            image = fopen(imagePath(partition).c_str(), "w+b");
+        }
+        if (!image) {
+            return ESP_FAIL;
+        }
+        bool ok = fseek(image, static_cast<long>(offset), SEEK_SET) == 0 && fwrite(data, 1, size, image) == size;
+        fclose(image);
+        return ok ? ESP_OK : ESP_FAIL;
+    }
+
+    esp_err_t writeLocked(OtaSession& session, const void* data, size_t size, uint32_t offset) {
+        if (offset + size > session.partition->size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (fseek(session.image, offset, SEEK_SET) != 0 || fwrite(data, 1, size, session.image) != size) {
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+}
+
+namespace NativeHal {
+    void setFlashWriteDelay(uint32_t microsPerKilobyte) {
+        flashWriteDelayUsPerKb = microsPerKilobyte;
+    }
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size) {
+    if (!partition || srcOffset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Ikke-skrevet flash læses som 0xFF ligesom på target
+    memset(dst, 0xFF, size);
+    FILE* image = fopen(imagePath(partition).c_str(), "rb");
+    if (image) {
+        if (fseek(image, static_cast<long>(srcOffset), SEEK_SET) == 0) {
+            fread(dst, 1, size, image);
+        }
+        fclose(image);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size) {
+    if (!partition || dstOffset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    return writeFileRange(partition, dstOffset, src, size);
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (!partition || offset + size > partition->size || offset % 4096 != 0 || size % 4096 != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::vector<uint8_t> erased(size, 0xFF);
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    return writeFileRange(partition, offset, erased.data(), size);
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t imageSize, esp_ota_handle_t* outHandle) {
+    if (!partition || !outHandle || partition == esp_ota_get_running_partition()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (imageSize != OTA_SIZE_UNKNOWN && imageSize != OTA_WITH_SEQUENTIAL_WRITES && imageSize > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Som på target slettes partitionen ikke ved begin; en genoptaget opdatering skriver videre i den
+    FILE* image = fopen(imagePath(partition).c_str(), "r+b");
+    if (!image) {
+        image = fopen(imagePath(partition).c_str(), "w+b");
+    }
+    if (!image) {
+        return ESP_FAIL;
+    }
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    *outHandle = nextHandle++;
+    sessions[*outHandle] = {partition, image, 0};
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+    simulateFlashLatency(size);
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto it = sessions.find(handle);
+    if (it == sessions.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = writeLocked(it->second, data, size, it->second.written);
+    if (err == ESP_OK) {
+        it->second.written += size;
+    }
+    return err;
+}
+
+esp_err_t esp_ota_write_with_offset(esp_ota_handle_t handle, const void* data, size_t size, uint32_t offset) {
+    simulateFlashLatency(size);
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto it = sessions.find(handle);
+    if (it == sessions.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return writeLocked(it->second, data, size, offset);
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto it = sessions.find(handle);
+    if (it == sessions.end()) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    fclose(it->second.image);
+    sessions.erase(it);
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    return esp_ota_end(handle);
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    if (!partition || partition->type != ESP_PARTITION_TYPE_APP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    OtaData data;
+    data.bootLabel = partition->label;
+    data.state = ESP_OTA_IMG_PENDING_VERIFY;
+    writeOtaData(data);
+    return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_boot_partition() {
+    const esp_partition_t* partition = findPartition(readOtaData().bootLabel);
+    return partition ? partition : &partitions[0];
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    // Processen "kører" fra den partition der var valgt til boot ved første kald
+    if (!runningPartition) {
+        runningPartition = esp_ota_get_boot_partition();
+    }
+    return runningPartition;
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* startFrom) {
+    const esp_partition_t* current = startFrom ? startFrom : esp_ota_get_running_partition();
+    return current == &partitions[1] ? &partitions[2] : &partitions[1];
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* outState) {
+    if (!partition || !outState) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == &partitions[0]) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    OtaData data = readOtaData();
+    if (data.bootLabel != partition->label) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *outState = data.state;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+    OtaData data = readOtaData();
+    data.state = ESP_OTA_IMG_VALID;
+    writeOtaData(data);
+    return ESP_OK;
+}
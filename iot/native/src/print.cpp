@@ -0,0 +1,78 @@
+#include <Arduino.h>
+
+#include <string>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size--) {
+        if (write(*buffer++) == 0) {
+            break;
+        }
+        written++;
+    }
+    return written;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char stackBuffer[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+    va_end(args);
+
+    if (length < 0) {
+        return 0;
+    }
+    if (static_cast<size_t>(length) < sizeof(stackBuffer)) {
+        return write(stackBuffer, length);
+    }
+
+    std::string heapBuffer(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&heapBuffer[0], heapBuffer.size(), format, args);
+    va_end(args);
+    return write(heapBuffer.data(), length);
+}
+
+size_t Print::print(long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(long long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(unsigned long long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(double value, int digits) {
+    return print(String(value, static_cast<unsigned int>(std::max(digits, 0))));
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0) {
+            break;
+        }
+        *buffer++ = static_cast<char>(c);
+        count++;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String result;
+    int c = read();
+    while (c >= 0) {
+        result += static_cast<char>(c);
+        c = read();
+    }
+    return result;
+}
@@ -0,0 +1,49 @@
+#include <Adafruit_BME280.h>
+#include <VL53L0X.h>
+
+#include "native_hal.h"
+
+namespace {
+    float temperature = 22.0f;
+    float humidity = 65.0f;
+    uint16_t distanceMm = 500;
+}
+
+namespace NativeHal {
+    void setEnvironment(float temperatureCelsius, float humidityPercentage) {
+        temperature = temperatureCelsius;
+        humidity = humidityPercentage;
+    }
+
+    void setDistance(uint16_t millimeters) {
+        distanceMm = millimeters;
+    }
+
+    float environmentTemperature() {
+        return temperature;
+    }
+
+    float environmentHumidity() {
+        return humidity;
+    }
+
+    uint16_t distance() {
+        return distanceMm;
+    }
+}
+
+bool Adafruit_BME280::begin(uint8_t address, TwoWire* wire) {
+    return address == 0x76 || address == 0x77;
+}
+
+float Adafruit_BME280::readTemperature() {
+    return temperature + random(-5, 6) / 100.0f;
+}
+
+float Adafruit_BME280::readHumidity() {
+    return humidity + random(-20, 21) / 100.0f;
+}
+
+uint16_t VL53L0X::readRangeContinuousMillimeters() {
+    return static_cast<uint16_t>(distanceMm + random(-2, 3));
+}
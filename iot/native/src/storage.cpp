@@ -0,0 +1,254 @@
+#include <FS.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "native_hal.h"
+
+fs::LittleFSFS LittleFS;
+
+namespace {
+    std::string root;
+
+    bool makeDirectories(const std::string& path) {
+        size_t pos = 0;
+        while ((pos = path.find('/', pos + 1)) != std::string::npos) {
+            ::mkdir(path.substr(0, pos).c_str(), 0755);
+        }
+        return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+    }
+
+    bool fileExists(const std::string& path) {
+        struct stat info;
+        return ::stat(path.c_str(), &info) == 0;
+    }
+}
+
+namespace NativeHal {
+    const std::string& storageRoot() {
+        if (root.empty()) {
+            const char* configured = getenv("BRODBUDDY_STORAGE_ROOT");
+            if (configured && *configured) {
+                root = configured;
+                makeDirectories(root);
+            } else {
+                char tmpl[] = "/tmp/brodbuddy-XXXXXX";
+                const char* created = mkdtemp(tmpl);
+                root = created ? created : "/tmp";
+            }
+        }
+        return root;
+    }
+
+    void setStorageRoot(const std::string& path) {
+        root = path;
+        makeDirectories(root);
+    }
+
+    std::string storagePath(const std::string& relative) {
+        std::string path = storageRoot() + "/" + relative;
+        makeDirectories(path.substr(0, path.find_last_of('/')));
+        return path;
+    }
+}
+
+namespace fs {
+    class FileImpl {
+      public:
+        FileImpl(FILE* handle, std::string path) : handle(handle), path(std::move(path)) {}
+        ~FileImpl() {
+            if (handle) fclose(handle);
+        }
+
+        FILE* handle;
+        std::string path;
+    };
+
+    size_t File::write(uint8_t c) {
+        return write(&c, 1);
+    }
+
+    size_t File::write(const uint8_t* buffer, size_t size) {
+        return _impl && _impl->handle ? fwrite(buffer, 1, size, _impl->handle) : 0;
+    }
+
+    void File::flush() {
+        if (_impl && _impl->handle) fflush(_impl->handle);
+    }
+
+    int File::available() {
+        if (!_impl || !_impl->handle) return 0;
+        return static_cast<int>(size() - position());
+    }
+
+    int File::read() {
+        return _impl && _impl->handle ? fgetc(_impl->handle) : -1;
+    }
+
+    int File::peek() {
+        if (!_impl || !_impl->handle) return -1;
+        int c = fgetc(_impl->handle);
+        if (c != EOF) ungetc(c, _impl->handle);
+        return c;
+    }
+
+    size_t File::read(uint8_t* buffer, size_t size) {
+        return _impl && _impl->handle ? fread(buffer, 1, size, _impl->handle) : 0;
+    }
+
+    bool File::seek(uint32_t pos, SeekMode mode) {
+        static const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+        return _impl && _impl->handle && fseek(_impl->handle, pos, whence[mode]) == 0;
+    }
+
+    size_t File::position() const {
+        return _impl && _impl->handle ? static_cast<size_t>(ftell(_impl->handle)) : 0;
+    }
+
+    size_t File::size() const {
+        if (!_impl) return 0;
+        if (_impl->handle) fflush(_impl->handle);
+        struct stat info;
+        return ::stat(_impl->path.c_str(), &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+    }
+
+    void File::close() {
+        _impl.reset();
+    }
+
+    const char* File::name() const {
+        if (!_impl) return "";
+        size_t slash = _impl->path.find_last_of('/');
+        return _impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    }
+
+    const char* File::path() const {
+        return _impl ? _impl->path.c_str() : "";
+    }
+
+    std::string FS::resolve(const char* path) const {
+        std::string relative = path ? path : "";
+        if (!relative.empty() && relative[0] == '/') relative.erase(0, 1);
+        return NativeHal::storagePath(_subdirectory + "/" + relative);
+    }
+
+    File FS::open(const char* path, const char* mode, bool create) {
+        std::string resolved = resolve(path);
+        std::string fopenMode = std::string(mode ? mode : "r") + "b";
+        if (fopenMode[0] == 'r' && !fileExists(resolved)) {
+            return File();
+        }
+        FILE* handle = fopen(resolved.c_str(), fopenMode.c_str());
+        if (!handle) {
+            return File();
+        }
+        return File(std::make_shared<FileImpl>(handle, resolved));
+    }
+
+    bool FS::exists(const char* path) {
+        return fileExists(resolve(path));
+    }
+
+    bool FS::remove(const char* path) {
+        return ::remove(resolve(path).c_str()) == 0;
+    }
+
+    bool FS::rename(const char* pathFrom, const char* pathTo) {
+        return ::rename(resolve(pathFrom).c_str(), resolve(pathTo).c_str()) == 0;
+    }
+
+    bool FS::mkdir(const char* path) {
+        return makeDirectories(resolve(path));
+    }
+
+    bool FS::rmdir(const char* path) {
+        return ::rmdir(resolve(path).c_str()) == 0;
+    }
+
+    LittleFSFS::LittleFSFS() : FS("littlefs") {}
+
+    bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+        return makeDirectories(NativeHal::storagePath("littlefs"));
+    }
+
+    bool LittleFSFS::format() {
+        std::string command = "rm -rf '" + NativeHal::storagePath("littlefs") + "'";
+        return system(command.c_str()) == 0 && begin();
+    }
+
+    size_t LittleFSFS::totalBytes() {
+        return 0x30000;
+    }
+
+    size_t LittleFSFS::usedBytes() {
+        return 0;
+    }
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    _namespace = name ? name : "";
+    _readOnly = readOnly;
+    _started = makeDirectories(NativeHal::storagePath("nvs/" + _namespace));
+    return _started;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+std::string Preferences::keyPath(const char* key) const {
+    return NativeHal::storagePath("nvs/" + _namespace + "/" + (key ? key : ""));
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) return false;
+    std::string command = "rm -f '" + NativeHal::storagePath("nvs/" + _namespace) + "'/*";
+    return system(command.c_str()) == 0;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_started || _readOnly) return false;
+    return ::remove(keyPath(key).c_str()) == 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return _started && fileExists(keyPath(key));
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    return putBytes(key, value, value ? strlen(value) : 0);
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!_started || _readOnly) return 0;
+    std::ofstream out(keyPath(key), std::ios::binary | std::ios::trunc);
+    out.write(static_cast<const char*>(value), static_cast<std::streamsize>(length));
+    return out ? length : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    if (!isKey(key)) return defaultValue;
+    std::ifstream in(keyPath(key), std::ios::binary);
+    return String(std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    struct stat info;
+    return _started && ::stat(keyPath(key).c_str(), &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    size_t length = getBytesLength(key);
+    if (length == 0 || length > maxLength) return 0;
+    std::ifstream in(keyPath(key), std::ios::binary);
+    in.read(static_cast<char*>(buffer), static_cast<std::streamsize>(length));
+    return in ? length : 0;
+}
@@ -0,0 +1,97 @@
+#include <WString.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    std::string formatInteger(unsigned long long value, unsigned int base, bool negative) {
+        if (base < 2 || base > 36) {
+            base = 10;
+        }
+        std::string digits;
+        do {
+            unsigned int digit = static_cast<unsigned int>(value % base);
+            digits.insert(digits.begin(), static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10));
+            value /= base;
+        } while (value > 0);
+        if (negative) {
+            digits.insert(digits.begin(), '-');
+        }
+        return digits;
+    }
+
+    std::string formatSigned(long long value, unsigned int base) {
+        if (value < 0 && base == 10) {
+            return formatInteger(static_cast<unsigned long long>(-(value + 1)) + 1, base, true);
+        }
+        return formatInteger(static_cast<unsigned long long>(value), base, false);
+    }
+
+    std::string formatFloat(double value, unsigned int digits) {
+        if (std::isnan(value)) return "nan";
+        if (std::isinf(value)) return "inf";
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", static_cast<int>(digits), value);
+        return buffer;
+    }
+}
+
+String::String(unsigned char value, unsigned char base) : _str(formatInteger(value, base, false)) {}
+String::String(int value, unsigned char base) : _str(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _str(formatInteger(value, base, false)) {}
+String::String(long value, unsigned char base) : _str(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _str(formatInteger(value, base, false)) {}
+String::String(long long value, unsigned char base) : _str(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _str(formatInteger(value, base, false)) {}
+String::String(float value, unsigned int decimalPlaces) : _str(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : _str(formatFloat(value, decimalPlaces)) {}
+
+bool String::endsWith(const String& suffix) const {
+    return _str.length() >= suffix._str.length() &&
+           _str.compare(_str.length() - suffix._str.length(), suffix._str.length(), suffix._str) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    auto pos = _str.find(c, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const String& str, unsigned int from) const {
+    auto pos = _str.find(str._str, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _str.length()) return String();
+    return String(_str.substr(from, std::min<size_t>(to, _str.length()) - from));
+}
+
+void String::trim() {
+    auto begin = _str.find_first_not_of(" \t\r\n");
+    auto end = _str.find_last_not_of(" \t\r\n");
+    _str = begin == std::string::npos ? std::string() : _str.substr(begin, end - begin + 1);
+}
+
+void String::toLowerCase() {
+    for (auto& c : _str) c = static_cast<char>(tolower(c));
+}
+
+void String::toUpperCase() {
+    for (auto& c : _str) c = static_cast<char>(toupper(c));
+}
+
+long String::toInt() const {
+    return strtol(_str.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+    return strtof(_str.c_str(), nullptr);
+}
+
+double String::toDouble() const {
+    return strtod(_str.c_str(), nullptr);
+}
@@ -6,7 +6,11 @@
 
 static const char* TAG = "EpaperMonitor";
 
-EpaperMonitor::EpaperMonitor(EpaperDisplay& display) : _display(display) {}
+EpaperMonitor::EpaperMonitor(EpaperDisplay& display) : _display(display), _backgroundCached(false) {}
+
+void EpaperMonitor::clearHistory(SourdoughData& data) {
+    data.history.clear();
+}
 
 SourdoughData EpaperMonitor::generateMockData() {
     const int mockGrowthValues[] = {100, 102, 101, 104, 108, 115, 117, 120, 123, 127, 134, 140, 138, 135, 142,
@@ -17,9 +21,6 @@ SourdoughData EpaperMonitor::generateMockData() {
     const int mockDataSize = sizeof(mockGrowthValues) / sizeof(mockGrowthValues[0]);
 
     SourdoughData data = {};
-    data.dataCount = 0;
-    data.oldestIndex = 0;
-    data.bufferFull = false;
 
     data.inTemp = 20.7;
     data.inHumidity = 100;
@@ -41,58 +42,39 @@ SourdoughData EpaperMonitor::generateMockData() {
 }
 
 void EpaperMonitor::addDataPoint(SourdoughData& data, int growthPercentage, unsigned long timestamp) {
-    int insertIndex;
-
-    if (data.bufferFull) {
-        insertIndex = data.oldestIndex;
-        data.oldestIndex = (data.oldestIndex + 1) % MonitoringConstants::MAX_DATA_POINTS;
-        LOG_D(TAG, "Buffer full, wrapping around. Oldest index now: %d", data.oldestIndex);
-    } else {
-        insertIndex = data.dataCount;
-        data.dataCount++;
-
-        if (data.dataCount >= MonitoringConstants::MAX_DATA_POINTS) {
-            data.bufferFull = true;
-            data.dataCount = MonitoringConstants::MAX_DATA_POINTS;
-            LOG_I(TAG, "Data buffer reached capacity (%d points)", MonitoringConstants::MAX_DATA_POINTS);
-        }
+    size_t dropped = data.history.append(timestamp, growthPercentage);
+    if (dropped > 0) {
+        LOG_D(TAG, "History full, dropped %u oldest points", (unsigned)dropped);
     }
 
-    data.growthValues[insertIndex] = growthPercentage;
-    data.timestamps[insertIndex] = timestamp;
-
     data.currentGrowth = growthPercentage;
 
     updatePeakInfo(data);
 }
 
+bool EpaperMonitor::findPeak(const SourdoughData& data, GrowthSample& peak) {
+    if (data.history.empty()) {
+        return false;
+    }
+
+    // Kun den del der vises i grafen, så en peak fra en tidligere fodring ikke hænger ved
+    unsigned long since = data.history.newest().timestamp - TimeUtils::to_seconds(TimeConstants::GRAPH_WINDOW);
+
+    // Negative værdier har aldrig været vist som peak
+    return data.history.peak(peak, since) && peak.growth > 0;
+}
+
 void EpaperMonitor::updatePeakInfo(SourdoughData& data) {
     int previousPeak = data.peakGrowth;
-    data.peakGrowth = 0;
-    int peakIndex = -1;
-
-    // Find peak værdi og indeks
-    for (int i = 0; i < data.dataCount; i++) {
-        int actualIndex = (data.oldestIndex + i) % MonitoringConstants::MAX_DATA_POINTS;
-        if (data.growthValues[actualIndex] > data.peakGrowth) {
-            data.peakGrowth = data.growthValues[actualIndex];
-            peakIndex = actualIndex;
-        }
-    }
+    GrowthSample peak;
+    bool found = findPeak(data, peak);
+    data.peakGrowth = found ? peak.growth : 0;
 
     // Beregn timer siden peak
-    if (peakIndex >= 0 && data.dataCount > 0) {
-        unsigned long now = 0;
-        for (int i = 0; i < data.dataCount; i++) {
-            int idx = (data.oldestIndex + i) % MonitoringConstants::MAX_DATA_POINTS;
-            if (data.timestamps[idx] > now) {
-                now = data.timestamps[idx];
-            }
-        }
-        
-        unsigned long peakTime = data.timestamps[peakIndex];
-        if (now >= peakTime) {
-            data.peakHoursAgo = (now - peakTime) / 3600.0;
+    if (found) {
+        unsigned long now = data.history.newest().timestamp;
+        if (now >= peak.timestamp) {
+            data.peakHoursAgo = (now - peak.timestamp) / 3600.0;
         } else {
             data.peakHoursAgo = 0;
         }
@@ -109,11 +91,7 @@ void EpaperMonitor::updateDisplay(const SourdoughData& data) {
     LOG_I(TAG, "Updating display - Growth: %d%%, Peak: %d%% (%.1fh ago)", data.currentGrowth, data.peakGrowth,
           data.peakHoursAgo);
 
-    _display.clearBuffers();
-
-    // Tegn linje til at adskille header fra grafområdet
-    _display.drawLine(2, 35, _display.width() - 3, 35, DisplayConstants::COLOR_BLACK);
-
+    drawBackground();
     drawHeader(data);
     drawBattery(data.batteryLevel);
     drawGraph(data);
@@ -156,41 +134,78 @@ void EpaperMonitor::drawBattery(int batteryLevel) {
     _display.fillRect(272, 23 - fillHeight, 6, fillHeight, DisplayConstants::COLOR_BLACK);
 }
 
-void EpaperMonitor::drawGraph(const SourdoughData& data) {
+EpaperMonitor::GraphLayout EpaperMonitor::graphLayout() const {
+    GraphLayout layout;
+
     // Grafområdets dimensioner
-    int graphX = 10;
-    int graphY = 45;
-    int graphWidth = _display.width() - 20;
-    int graphHeight = _display.height() - graphY - 10;
+    layout.graphX = 10;
+    layout.graphY = 45;
+    layout.graphWidth = _display.width() - 20;
+    layout.graphHeight = _display.height() - layout.graphY - 10;
 
     // Definer etiketbredde for Y-aksen
     int yLabelWidth = 30;
-    int actualGraphWidth = graphWidth - yLabelWidth;
+    int actualGraphWidth = layout.graphWidth - yLabelWidth;
 
-    // Tegn X-aksens etiketter (tid) og lodrette gitterlinjer
     // Start X-etiketter fra en position, der ikke overlapper med Y-etiketter
-    int xLabelStartX = graphX + yLabelWidth;
+    layout.xLabelStartX = layout.graphX + yLabelWidth;
+
+    layout.windowMinutes = TimeUtils::to_minutes(TimeConstants::GRAPH_WINDOW);
+
+    if (layout.windowMinutes <= 10) {
+        layout.gridInterval = 1;
+    } else if (layout.windowMinutes <= 60) {
+        layout.gridInterval = 5;
+    } else if (layout.windowMinutes <= 360) {
+        layout.gridInterval = 30;
+    } else {
+        layout.gridInterval = 60;
+    }
+
+    layout.numGridLines = layout.windowMinutes / layout.gridInterval;
+    layout.gridWidth = actualGraphWidth / layout.numGridLines;
+
+    return layout;
+}
+
+void EpaperMonitor::drawBackground() {
+    if (_backgroundCached && _display.restoreBackground()) {
+        return;
+    }
+
+    _display.clearBuffers();
+
+    // Tegn linje til at adskille header fra grafområdet
+    _display.drawLine(2, 35, _display.width() - 3, 35, DisplayConstants::COLOR_BLACK);
+
+    drawGraphFrame();
+
+    _backgroundCached = _display.saveBackground();
+    LOG_D(TAG, "Graph background rendered%s", _backgroundCached ? " and cached" : "");
+}
+
+void EpaperMonitor::invalidateBackground() {
+    _backgroundCached = false;
+}
+
+// Alt der kun afhænger af GRAPH_WINDOW og de faste Y-etiketter
+void EpaperMonitor::drawGraphFrame() {
+    GraphLayout layout = graphLayout();
+    int graphX = layout.graphX;
+    int graphY = layout.graphY;
+    int graphWidth = layout.graphWidth;
+    int graphHeight = layout.graphHeight;
+    int xLabelStartX = layout.xLabelStartX;
 
     // Tegn L-formet graframme (|_)
     _display.drawLine(xLabelStartX, graphY, xLabelStartX, graphY + graphHeight, DisplayConstants::COLOR_BLACK);
     _display.drawLine(xLabelStartX, graphY + graphHeight, graphX + graphWidth, graphY + graphHeight,
                       DisplayConstants::COLOR_BLACK);
 
-    unsigned long windowMinutes = TimeUtils::to_minutes(TimeConstants::GRAPH_WINDOW);
-    
-    int gridInterval;
-    if (windowMinutes <= 10) {
-        gridInterval = 1;  
-    } else if (windowMinutes <= 60) {
-        gridInterval = 5;  
-    } else if (windowMinutes <= 360) {
-        gridInterval = 30; 
-    } else {
-        gridInterval = 60;
-    }
-    
-    int numGridLines = windowMinutes / gridInterval;
-    int gridWidth = actualGraphWidth / numGridLines;
+    unsigned long windowMinutes = layout.windowMinutes;
+    int gridInterval = layout.gridInterval;
+    int numGridLines = layout.numGridLines;
+    int gridWidth = layout.gridWidth;
     
     for (int i = 0; i <= numGridLines; i++) {
         int x = xLabelStartX + (i * gridWidth);
@@ -256,102 +271,72 @@ void EpaperMonitor::drawGraph(const SourdoughData& data) {
         _display.print(yLabelValues[i]);
         _display.print("%");
     }
+}
+
+void EpaperMonitor::drawGraph(const SourdoughData& data) {
+    GraphLayout layout = graphLayout();
+    int graphY = layout.graphY;
+    int graphHeight = layout.graphHeight;
+    int xLabelStartX = layout.xLabelStartX;
+    int numGridLines = layout.numGridLines;
+    int gridWidth = layout.gridWidth;
 
     // Værdier for skalering
     int maxValue = 400;
     int minValue = 100;
     int valueRange = maxValue - minValue;
 
-    if (data.dataCount == 0) {
+    const GrowthLog& history = data.history;
+    if (history.empty()) {
         LOG_D(TAG, "No data points to display in graph");
         return;
     }
 
     // Beregn tidsramme (12 timer total)
-    unsigned long now = 0;
-    if (data.dataCount > 0) {
-        // Find den nyeste timestamp
-        for (int i = 0; i < data.dataCount; i++) {
-            int idx = (data.oldestIndex + i) % MonitoringConstants::MAX_DATA_POINTS;
-            if (data.timestamps[idx] > now) {
-                now = data.timestamps[idx];
-            }
-        }
-    } else {
-        now = millis() / 1000;
-    }
+    unsigned long now = history.newest().timestamp;
     
     unsigned long windowSeconds = TimeUtils::to_seconds(TimeConstants::GRAPH_WINDOW);
     unsigned long windowStartTime = now - windowSeconds;
     
     LOG_D(TAG, "Graph time window: now=%lu, start=%lu, window=%lus", now, windowStartTime, windowSeconds);
-    if (data.dataCount > 0) {
-        int firstIdx = data.oldestIndex;
-        int lastIdx = (data.oldestIndex + data.dataCount - 1) % MonitoringConstants::MAX_DATA_POINTS;
-        LOG_D(TAG, "Data timestamps: first=%lu, last=%lu, count=%d", data.timestamps[firstIdx], data.timestamps[lastIdx], data.dataCount);
-    }
+    LOG_D(TAG, "Data timestamps: first=%lu, last=%lu, count=%d", history.oldest().timestamp, now, (int)history.size());
     float timeRange = (float)windowSeconds;
 
-    // Kun tegn punkter, hvis vi har mindst 2
-    if (data.dataCount >= 2) {
-        // Tegn linjerne mellem punkter
-        for (int i = 0; i < data.dataCount - 1; i++) {
-            // Beregn de faktiske indekser med hensyn til cirkulær buffer
-            int idx1 = (data.oldestIndex + i) % MonitoringConstants::MAX_DATA_POINTS;
-            int idx2 = (data.oldestIndex + i + 1) % MonitoringConstants::MAX_DATA_POINTS;
-
-            // Beregn relative positioner på tidsaksen
-            float timePct1 = (data.timestamps[idx1] - windowStartTime) / timeRange;
-            float timePct2 = (data.timestamps[idx2] - windowStartTime) / timeRange;
-
-            // Begræns til gyldig tidsskala (0.0 til 1.0)
-            timePct1 = max(0.0f, min(1.0f, timePct1));
-            timePct2 = max(0.0f, min(1.0f, timePct2));
-            
-            if (timePct1 > 1.0f || timePct2 > 1.0f) {
-                LOG_D(TAG, "Time percentage out of range: pct1=%.2f, pct2=%.2f", timePct1, timePct2);
-            }
-
-            // Beregn x-koordinater baseret på disse tidspositioner
-            int rightmostGridX = xLabelStartX + (numGridLines * gridWidth);
-            int x1 = xLabelStartX + (int)(timePct1 * (rightmostGridX - xLabelStartX));
-            int x2 = xLabelStartX + (int)(timePct2 * (rightmostGridX - xLabelStartX));
+    int rightmostGridX = xLabelStartX + (numGridLines * gridWidth);
 
-            // Beregn y-koordinater baseret på vækstværdier
-            int y1 = graphY + graphHeight - ((data.growthValues[idx1] - minValue) * graphHeight / valueRange);
-            int y2 = graphY + graphHeight - ((data.growthValues[idx2] - minValue) * graphHeight / valueRange);
+    // Tegn linjerne mellem punkterne
+    bool first = true;
+    int previousX = 0;
+    int previousY = 0;
+    int points = 0;
+    forEachCurvePoint(data, windowStartTime, [&](const GrowthSample& point) {
+        // Relativ position på tidsaksen, begrænset til gyldig tidsskala (0.0 til 1.0)
+        float timePct = (point.timestamp - windowStartTime) / timeRange;
+        timePct = max(0.0f, min(1.0f, timePct));
 
-            if (i == 0) {
-                LOG_D(TAG, "First line: ts1=%lu, ts2=%lu, pct1=%.2f, pct2=%.2f, x1=%d, x2=%d, y1=%d, y2=%d, val1=%d, val2=%d",
-                      data.timestamps[idx1], data.timestamps[idx2], timePct1, timePct2, x1, x2, y1, y2,
-                      data.growthValues[idx1], data.growthValues[idx2]);
-            }
+        int x = xLabelStartX + (int)(timePct * (rightmostGridX - xLabelStartX));
+        int y = graphY + graphHeight - ((point.growth - minValue) * graphHeight / valueRange);
 
-            // Tegn linje mellem punkter
-            _display.drawLine(x1, y1, x2, y2, DisplayConstants::COLOR_BLACK);
+        if (!first) {
+            _display.drawLine(previousX, previousY, x, y, DisplayConstants::COLOR_BLACK);
         }
-    }
+        first = false;
+        previousX = x;
+        previousY = y;
+        points++;
+    });
+    LOG_D(TAG, "Drew curve through %d points", points);
 
     // Find peak for at markere den
-    int peakValue = 0;
-    int peakIndex = -1;
-
-    for (int i = 0; i < data.dataCount; i++) {
-        int idx = (data.oldestIndex + i) % MonitoringConstants::MAX_DATA_POINTS;
-        if (data.growthValues[idx] > peakValue) {
-            peakValue = data.growthValues[idx];
-            peakIndex = idx;
-        }
-    }
+    GrowthSample peak;
 
     // Hvis vi fandt en peak, marker den
-    if (peakIndex >= 0) {
-        float peakTimePct = (data.timestamps[peakIndex] - windowStartTime) / timeRange;
+    if (findPeak(data, peak)) {
+        float peakTimePct = (peak.timestamp - windowStartTime) / timeRange;
         peakTimePct = max(0.0f, min(1.0f, peakTimePct));
 
-        int rightmostGridX = xLabelStartX + (numGridLines * gridWidth);
         int peakX = xLabelStartX + (int)(peakTimePct * (rightmostGridX - xLabelStartX));
-        int peakY = graphY + graphHeight - ((peakValue - minValue) * graphHeight / valueRange);
+        int peakY = graphY + graphHeight - ((peak.growth - minValue) * graphHeight / valueRange);
 
         _display.fillRect(peakX - 3, peakY - 3, 6, 6, DisplayConstants::COLOR_RED);
     }
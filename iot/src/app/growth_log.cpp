@@ -0,0 +1,231 @@
+#include "app/growth_log.h"
+
+#include <cstddef>
+
+// Størrelsen loggen er dimensioneret efter (MonitoringConstants::HISTORY_BLOCK_BYTES)
+static_assert(sizeof(unsigned long) != 4 || sizeof(GrowthBlock) == 64, "GrowthBlock should be 64 bytes on target");
+
+namespace {
+    constexpr uint8_t ESCAPE = 0x80;
+    constexpr uint32_t FAST_INTERVAL_LIMIT = 8; // 3 bit zig-zag
+    constexpr uint32_t FAST_GROWTH_LIMIT = 16;  // 4 bit zig-zag
+    constexpr size_t HEADER_BYTES = offsetof(GrowthBlock, data);
+
+    uint32_t zigZag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    int32_t unZigZag(uint32_t value) {
+        return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+    }
+
+    size_t varintLength(uint32_t value) {
+        size_t length = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            length++;
+        }
+        return length;
+    }
+
+    void writeVarint(uint8_t*& out, uint32_t value) {
+        while (value >= 0x80) {
+            *out++ = static_cast<uint8_t>(value) | 0x80;
+            value >>= 7;
+        }
+        *out++ = static_cast<uint8_t>(value);
+    }
+
+    uint32_t readVarint(const uint8_t* data, uint8_t& offset) {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t byte = data[offset++];
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    // Forskellen som int32_t, hvis den kan gengives præcist ved afkodning
+    bool toInt32(int64_t value, int32_t& result) {
+        result = static_cast<int32_t>(value);
+        return result == value;
+    }
+}
+
+GrowthLog::Reader::Reader(const GrowthLog& log, size_t firstBlock)
+    : _log(log), _block(firstBlock), _offset(0), _index(0), _previous{0, 0}, _interval(0) {}
+
+bool GrowthLog::Reader::next(GrowthSample& sample) {
+    while (_block < _log._blocks.size()) {
+        const GrowthBlock& block = _log._blocks[_block];
+
+        if (_index == 0) {
+            _previous = {block.baseTimestamp, static_cast<int>(block.baseGrowth)};
+            _interval = 0;
+            _offset = 0;
+            _index = 1;
+            sample = _previous;
+            return true;
+        }
+
+        if (_index < block.count) {
+            uint32_t intervalChange;
+            uint32_t growthChange;
+            uint8_t first = block.data[_offset++];
+            if (first == ESCAPE) {
+                intervalChange = readVarint(block.data, _offset);
+                growthChange = readVarint(block.data, _offset);
+            } else {
+                intervalChange = first >> 4;
+                growthChange = first & 0x0F;
+            }
+
+            _interval += unZigZag(intervalChange);
+            _previous.timestamp += static_cast<unsigned long>(static_cast<long>(_interval));
+            _previous.growth += unZigZag(growthChange);
+            _index++;
+            sample = _previous;
+            return true;
+        }
+
+        _block++;
+        _index = 0;
+    }
+    return false;
+}
+
+void GrowthLog::clear() {
+    _blocks.clear();
+    _newest = {0, 0};
+    _interval = 0;
+    _size = 0;
+}
+
+size_t GrowthLog::append(unsigned long timestamp, int growth) {
+    if (!_blocks.empty() && appendToBlock(_blocks.back(), timestamp, growth)) {
+        _newest = {timestamp, growth};
+        _size++;
+        return 0;
+    }
+
+    // Ny blok med punktet som absolut start; en fuld log giver plads ved at fjerne den ældste
+    size_t dropped = 0;
+    if (_blocks.full()) {
+        dropped = _blocks.front().count;
+        _size -= dropped;
+    }
+
+    GrowthBlock block;
+    block.baseTimestamp = timestamp;
+    block.peakTimestamp = timestamp;
+    block.baseGrowth = growth;
+    block.peakGrowth = growth;
+    block.count = 1;
+    block.length = 0;
+    _blocks.pushBack(block);
+
+    _newest = {timestamp, growth};
+    _interval = 0;
+    _size++;
+    return dropped;
+}
+
+bool GrowthLog::appendToBlock(GrowthBlock& block, unsigned long timestamp, int growth) {
+    // Tidsforskellen skal kunne lægges til igen med samme wrap som unsigned long
+    unsigned long difference = timestamp - _newest.timestamp;
+    int32_t interval = static_cast<int32_t>(difference);
+    if (static_cast<unsigned long>(static_cast<long>(interval)) != difference) {
+        return false;
+    }
+
+    int32_t intervalChange;
+    int32_t growthChange;
+    if (!toInt32(static_cast<int64_t>(interval) - _interval, intervalChange) ||
+        !toInt32(static_cast<int64_t>(growth) - _newest.growth, growthChange)) {
+        return false;
+    }
+
+    uint32_t zigZagInterval = zigZag(intervalChange);
+    uint32_t zigZagGrowth = zigZag(growthChange);
+    uint8_t* out = block.data + block.length;
+
+    if (zigZagInterval < FAST_INTERVAL_LIMIT && zigZagGrowth < FAST_GROWTH_LIMIT) {
+        if (block.length + 1u > sizeof(block.data)) {
+            return false;
+        }
+        *out++ = static_cast<uint8_t>(zigZagInterval << 4 | zigZagGrowth);
+    } else {
+        size_t needed = 1 + varintLength(zigZagInterval) + varintLength(zigZagGrowth);
+        if (block.length + needed > sizeof(block.data)) {
+            return false;
+        }
+        *out++ = ESCAPE;
+        writeVarint(out, zigZagInterval);
+        writeVarint(out, zigZagGrowth);
+    }
+
+    block.length = static_cast<uint8_t>(out - block.data);
+    block.count++;
+    if (growth > block.peakGrowth) {
+        block.peakGrowth = growth;
+        block.peakTimestamp = timestamp;
+    }
+    _interval = interval;
+    return true;
+}
+
+GrowthSample GrowthLog::oldest() const {
+    const GrowthBlock& block = _blocks.front();
+    return {block.baseTimestamp, static_cast<int>(block.baseGrowth)};
+}
+
+bool GrowthLog::peak(GrowthSample& sample, unsigned long since) const {
+    if (_blocks.empty()) {
+        return false;
+    }
+
+    // Sammenlignet som afstand fra since, så tidsstempler der er wrappet virker
+    unsigned long span = _newest.timestamp - since;
+    bool found = false;
+    auto consider = [&](const GrowthSample& candidate) {
+        if (!found || candidate.growth > sample.growth) {
+            sample = candidate;
+            found = true;
+        }
+    };
+
+    // Blokke der starter i vinduet ligger helt i det, og deres peak står i headeren
+    size_t first = 0;
+    while (first < _blocks.size() && _blocks[first].baseTimestamp - since > span) {
+        first++;
+    }
+
+    // Blokken før kan have sine nyeste punkter i vinduet. Den er ældst, så den ses først og vinder ved lighed
+    if (first > 0) {
+        const GrowthBlock& straddling = _blocks[first - 1];
+        Reader reader(*this, first - 1);
+        GrowthSample candidate;
+        for (uint8_t i = 0; i < straddling.count && reader.next(candidate); i++) {
+            if (candidate.timestamp - since <= span) {
+                consider(candidate);
+            }
+        }
+    }
+
+    for (size_t i = first; i < _blocks.size(); i++) {
+        const GrowthBlock& block = _blocks[i];
+        consider({block.peakTimestamp, static_cast<int>(block.peakGrowth)});
+    }
+    return found;
+}
+
+size_t GrowthLog::encodedBytes() const {
+    size_t bytes = 0;
+    for (const GrowthBlock& block : _blocks) {
+        bytes += HEADER_BYTES + block.length;
+    }
+    return bytes;
+}
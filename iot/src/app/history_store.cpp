@@ -0,0 +1,265 @@
+#include "app/history_store.h"
+
+#include <LittleFS.h>
+#include <esp_attr.h>
+
+#include <cstring>
+
+#include "config/constants.h"
+#include "logging/logger.h"
+#include "util/retained.h"
+
+static const char* TAG = "HistoryStore";
+
+const char* HistoryStore::JOURNAL_FILE = "/history.bin";
+const char* HistoryStore::COMPACT_FILE = "/history.tmp";
+
+namespace {
+    using MonitoringConstants::HISTORY_JOURNAL_BATCH;
+    using MonitoringConstants::HISTORY_JOURNAL_MAX_RECORDS;
+
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x42424832; // "BBH2"; tælles op hvis felternes betydning ændres
+    constexpr uint32_t JOURNAL_MAGIC = 0x42424A31;  // "BBJ1"
+    constexpr size_t COPY_RECORDS = 32;             // Poster pr. læsning ved afspilning og komprimering
+
+    struct HistorySnapshot {
+        GrowthLog history;
+        int32_t currentGrowth;
+        uint32_t pendingCount;
+        GrowthSample pending[HISTORY_JOURNAL_BATCH]; // Endnu ikke i journalen
+    };
+
+    struct JournalHeader {
+        uint32_t magic;
+        uint32_t recordSize;
+    };
+
+    struct JournalRecord {
+        uint32_t timestamp;
+        int32_t growth;
+    };
+
+    RTC_NOINIT_ATTR Retained<HistorySnapshot, SNAPSHOT_MAGIC> snapshot;
+    HistorySnapshot& state = snapshot.value;
+
+    bool snapshotValid() {
+        return snapshot.valid() && state.pendingCount <= HISTORY_JOURNAL_BATCH;
+    }
+
+    size_t journalRecords(const File& file) {
+        size_t size = file.size();
+        return size < sizeof(JournalHeader) ? 0 : (size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+    }
+
+    bool journalAligned(const File& file) {
+        size_t size = file.size();
+        if (size == 0) {
+            return true;
+        }
+        return size >= sizeof(JournalHeader) && (size - sizeof(JournalHeader)) % sizeof(JournalRecord) == 0;
+    }
+
+    bool writeHeader(File& file) {
+        JournalHeader header = {JOURNAL_MAGIC, sizeof(JournalRecord)};
+        return file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header);
+    }
+}
+
+bool HistoryStore::restore(EpaperMonitor& monitor, SourdoughData& data) {
+    EpaperMonitor::clearHistory(data);
+
+    if (snapshotValid()) {
+        data.history = state.history;
+        data.currentGrowth = state.currentGrowth;
+        monitor.updatePeakInfo(data);
+        LOG_I(TAG, "Restored %u points from RTC memory, %u not yet in journal", (unsigned)data.history.size(),
+              (unsigned)state.pendingCount);
+        return true;
+    }
+
+    bool replayed = replayJournal(monitor, data);
+    if (!replayed) {
+        LOG_I(TAG, "No stored history, starting empty");
+    }
+
+    // Ny RTC kopi af det gendannede; alt i den står allerede i journalen
+    capture(data);
+    state.pendingCount = 0;
+    snapshot.seal();
+    return replayed;
+}
+
+void HistoryStore::record(const SourdoughData& data, unsigned long timestamp, int growth) {
+    // restore() er ikke kaldt, eller RTC hukommelsen er blevet overskrevet
+    if (!snapshotValid()) {
+        state.pendingCount = 0;
+    }
+
+    // Et fuldt batch betyder at sidste flush fejlede. Prøv igen, ellers må det ældste ventende punkt vige
+    if (state.pendingCount == HISTORY_JOURNAL_BATCH && !flush()) {
+        memmove(state.pending, state.pending + 1, sizeof(GrowthSample) * (HISTORY_JOURNAL_BATCH - 1));
+        state.pendingCount--;
+        LOG_W(TAG, "Journal unavailable, oldest pending point dropped");
+    }
+
+    capture(data);
+    state.pending[state.pendingCount++] = {timestamp, growth};
+    snapshot.seal();
+
+    if (state.pendingCount == HISTORY_JOURNAL_BATCH) {
+        flush();
+    }
+}
+
+bool HistoryStore::flush() {
+    if (state.pendingCount == 0) {
+        return true;
+    }
+
+    File file = LittleFS.open(JOURNAL_FILE, "a");
+    if (!file) {
+        LOG_E(TAG, "Failed to open journal for appending");
+        return false;
+    }
+
+    // En afbrudt skrivning efterlader en halv post; skær den fra før der tilføjes mere
+    if (!journalAligned(file)) {
+        size_t records = journalRecords(file);
+        file.close();
+        LOG_W(TAG, "Journal ends in a partial record, rewriting");
+        if (!compactJournal(records)) {
+            return false;
+        }
+        file = LittleFS.open(JOURNAL_FILE, "a");
+        if (!file) {
+            LOG_E(TAG, "Failed to reopen journal");
+            return false;
+        }
+    }
+
+    bool written = file.size() > 0 || writeHeader(file);
+
+    JournalRecord records[HISTORY_JOURNAL_BATCH];
+    for (uint32_t i = 0; i < state.pendingCount; i++) {
+        records[i] = {static_cast<uint32_t>(state.pending[i].timestamp), state.pending[i].growth};
+    }
+    size_t bytes = sizeof(JournalRecord) * state.pendingCount;
+    written = written && file.write(reinterpret_cast<const uint8_t*>(records), bytes) == bytes;
+    size_t total = journalRecords(file);
+    file.close();
+
+    if (!written) {
+        LOG_E(TAG, "Failed to write %u points to journal", (unsigned)state.pendingCount);
+        return false;
+    }
+
+    LOG_D(TAG, "Flushed %u points to journal, %u in total", (unsigned)state.pendingCount, (unsigned)total);
+    state.pendingCount = 0;
+    snapshot.seal();
+
+    if (total > static_cast<size_t>(HISTORY_JOURNAL_MAX_RECORDS)) {
+        compactJournal(HISTORY_JOURNAL_MAX_RECORDS / 2);
+    }
+    return true;
+}
+
+size_t HistoryStore::pendingCount() const {
+    return state.pendingCount;
+}
+
+void HistoryStore::invalidateSnapshot() {
+    snapshot.invalidate();
+}
+
+void HistoryStore::capture(const SourdoughData& data) {
+    state.history = data.history;
+    state.currentGrowth = data.currentGrowth;
+}
+
+bool HistoryStore::replayJournal(EpaperMonitor& monitor, SourdoughData& data) {
+    // Strømtab mellem remove og rename i compactJournal
+    if (!LittleFS.exists(JOURNAL_FILE) && LittleFS.exists(COMPACT_FILE)) {
+        LOG_W(TAG, "Completing interrupted journal compaction");
+        LittleFS.rename(COMPACT_FILE, JOURNAL_FILE);
+    }
+
+    File file = LittleFS.open(JOURNAL_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
+    JournalHeader header;
+    if (file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header) ||
+        header.magic != JOURNAL_MAGIC || header.recordSize != sizeof(JournalRecord)) {
+        file.close();
+        LOG_W(TAG, "Unknown journal format, discarding");
+        LittleFS.remove(JOURNAL_FILE);
+        return false;
+    }
+
+    size_t remaining = journalRecords(file);
+    size_t replayed = 0;
+    JournalRecord records[COPY_RECORDS];
+    while (remaining > 0) {
+        size_t count = min(remaining, COPY_RECORDS);
+        size_t bytes = count * sizeof(JournalRecord);
+        if (file.read(reinterpret_cast<uint8_t*>(records), bytes) != bytes) {
+            LOG_W(TAG, "Journal read stopped after %u points", (unsigned)replayed);
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            monitor.addDataPoint(data, records[i].growth, records[i].timestamp);
+        }
+        replayed += count;
+        remaining -= count;
+    }
+    file.close();
+
+    if (replayed > 0) {
+        LOG_I(TAG, "Replayed %u points from journal", (unsigned)replayed);
+    }
+    return replayed > 0;
+}
+
+bool HistoryStore::compactJournal(size_t keep) {
+    File source = LittleFS.open(JOURNAL_FILE, "r");
+    if (!source) {
+        return false;
+    }
+
+    size_t records = journalRecords(source);
+    size_t skip = records > keep ? records - keep : 0;
+    File target = LittleFS.open(COMPACT_FILE, "w");
+    if (!target) {
+        LOG_E(TAG, "Failed to open %s", COMPACT_FILE);
+        return false;
+    }
+
+    bool copied = writeHeader(target) && source.seek(sizeof(JournalHeader) + skip * sizeof(JournalRecord));
+    JournalRecord buffer[COPY_RECORDS];
+    for (size_t remaining = records - skip; copied && remaining > 0;) {
+        size_t count = min(remaining, COPY_RECORDS);
+        size_t bytes = count * sizeof(JournalRecord);
+        copied = source.read(reinterpret_cast<uint8_t*>(buffer), bytes) == bytes &&
+                 target.write(reinterpret_cast<const uint8_t*>(buffer), bytes) == bytes;
+        remaining -= count;
+    }
+    source.close();
+    target.close();
+
+    if (!copied) {
+        LOG_E(TAG, "Journal compaction failed");
+        LittleFS.remove(COMPACT_FILE);
+        return false;
+    }
+
+    // Et strømtab herimellem samles op af replayJournal
+    LittleFS.remove(JOURNAL_FILE);
+    if (!LittleFS.rename(COMPACT_FILE, JOURNAL_FILE)) {
+        LOG_E(TAG, "Failed to replace journal");
+        return false;
+    }
+
+    LOG_I(TAG, "Journal compacted to the newest %u of %u points", (unsigned)(records - skip), (unsigned)records);
+    return true;
+}
@@ -45,4 +45,20 @@ const char* StateMachine::getStateName(AppState state) const {
 
 bool StateMachine::shouldTransition(unsigned long timeThreshold) const {
     return timeInCurrentState() >= timeThreshold;
-}
\ No newline at end of file
+}
+
+AppState nextCycleState(const CycleProgress& cycle, bool wifiReady, bool mqttConnected) {
+    if (!cycle.sampled) {
+        return STATE_SENSING;
+    }
+    if (!cycle.published && mqttConnected) {
+        return STATE_PUBLISHING_DATA;
+    }
+    if (!cycle.displayed) {
+        return STATE_UPDATING_DISPLAY;
+    }
+    if (!cycle.published) {
+        return wifiReady ? STATE_CONNECTING_MQTT : STATE_CONNECTING_WIFI;
+    }
+    return STATE_SLEEP;
+}
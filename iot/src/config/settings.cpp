@@ -1,9 +1,22 @@
 #include "config/settings.h"
 
+#include <cstring>
+
 #include "logging/logger.h"
 
 const char* Settings::SETTINGS_FILE = "/settings.json";
 
+namespace {
+    bool copyString(char* target, size_t size, const char* value) {
+        size_t length = strlen(value);
+        if (length >= size) {
+            return false;
+        }
+        memcpy(target, value, length + 1);
+        return true;
+    }
+}
+
 Settings::Settings() : _doc(1024), _loaded(false) {}
 
 bool Settings::begin() {
@@ -21,6 +34,49 @@ bool Settings::begin() {
     return true;
 }
 
+bool Settings::resume(const RetainedState& state) {
+    // Filsystemet skal stadig bruges af save() og historikkens journal, men filen parses ikke
+    if (!LittleFS.begin(true)) {
+        LOG_E("Settings", "Failed to mount LittleFS");
+        return false;
+    }
+
+    // ArduinoJson gemmer const char* som pointer; strengene skal kopieres ud af RTC kopien, som retain()
+    // senere skriver i
+    _doc.clear();
+    _doc["analyzerId"] = String(state.analyzerId);
+    _doc["mqtt"]["server"] = String(state.mqttServer);
+    _doc["mqtt"]["port"] = state.mqttPort;
+    _doc["mqtt"]["user"] = String(state.mqttUser);
+    _doc["mqtt"]["password"] = String(state.mqttPassword);
+    _doc["sensor"]["intervalSeconds"] = state.sensorIntervalSeconds;
+    _doc["lowPowerMode"] = state.lowPowerMode;
+    _doc["calibration"]["tempOffsetCelsius"] = state.tempOffset;
+    _doc["calibration"]["humOffset"] = state.humOffset;
+    _doc["sourdough"]["feedingNumber"] = state.feedingNumber;
+    _loaded = true;
+    return true;
+}
+
+bool Settings::retain(RetainedState& state) const {
+    // Rå værdier, så en ${MQTT_PASSWORD} pladsholder forbliver en pladsholder
+    if (!copyString(state.analyzerId, sizeof(state.analyzerId), _doc["analyzerId"] | "") ||
+        !copyString(state.mqttServer, sizeof(state.mqttServer), _doc["mqtt"]["server"] | "") ||
+        !copyString(state.mqttUser, sizeof(state.mqttUser), _doc["mqtt"]["user"] | "") ||
+        !copyString(state.mqttPassword, sizeof(state.mqttPassword), _doc["mqtt"]["password"] | "")) {
+        LOG_W("Settings", "Settings too long to retain, next wake reads the file");
+        return false;
+    }
+
+    state.mqttPort = getMqttPort();
+    state.sensorIntervalSeconds = getSensorInterval();
+    state.tempOffset = getTempOffset();
+    state.humOffset = getHumOffset();
+    state.feedingNumber = getFeedingNumber();
+    state.lowPowerMode = getLowPowerMode();
+    return true;
+}
+
 bool Settings::save() {
     return saveToFile();
 }
@@ -5,10 +5,8 @@
 
 static const char* TAG = "BatteryManager";
 
-BatteryManager::BatteryManager() : historyIndex(0), lastVoltageUpdate(0), chargingState(false) {
-    for (int i = 0; i < VOLTAGE_HISTORY_SIZE; i++) {
-        voltageHistory[i] = 0;
-    }
+BatteryManager::BatteryManager() : lastVoltageUpdate(0), chargingState(false) {
+    voltageHistory.clear();
 }
 
 void BatteryManager::begin() {
@@ -77,29 +75,19 @@ void BatteryManager::updateChargingState() {
     int currentVoltage = getVoltage();
     
     // Gem voltage i historik
-    voltageHistory[historyIndex] = currentVoltage;
-    historyIndex = (historyIndex + 1) % VOLTAGE_HISTORY_SIZE;
+    voltageHistory.pushBack(currentVoltage);
+    if (voltageHistory.size() > VOLTAGE_HISTORY_SIZE) {
+        voltageHistory.popFront();
+    }
     
     // Tjek om vi har nok data
-    bool hasData = true;
-    for (int i = 0; i < VOLTAGE_HISTORY_SIZE; i++) {
-        if (voltageHistory[i] == 0) {
-            hasData = false;
-            break;
-        }
+    if (voltageHistory.size() < VOLTAGE_HISTORY_SIZE) return;
+    for (int voltage : voltageHistory) {
+        if (voltage == 0) return;
     }
     
-    if (!hasData) return;
-    
-    // Beregn gennemsnitlig ændring
-    int totalChange = 0;
-    int oldestIndex = (historyIndex + 1) % VOLTAGE_HISTORY_SIZE;
-    
-    for (int i = 1; i < VOLTAGE_HISTORY_SIZE; i++) {
-        int currentIdx = (oldestIndex + i) % VOLTAGE_HISTORY_SIZE;
-        int prevIdx = (oldestIndex + i - 1) % VOLTAGE_HISTORY_SIZE;
-        totalChange += (voltageHistory[currentIdx] - voltageHistory[prevIdx]);
-    }
+    // Summen af ændringerne mellem målingerne er ændringen fra ældste til nyeste
+    int totalChange = voltageHistory.back() - voltageHistory.front();
     
     // Hvis voltage stiger med mere end 10mV over perioden, antager vi opladning
     chargingState = (totalChange > 10);
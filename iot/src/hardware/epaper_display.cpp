@@ -3,29 +3,113 @@
 #include "config/constants.h"
 #include "config/time_utils.h"
 #include "logging/logger.h"
+#include "network/crc32.h"
+
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+
+#include <algorithm>
+#include <cstring>
 
 static const char* TAG = "EpaperDisplay";
 
-EpaperDisplay::EpaperDisplay() : Adafruit_GFX(DisplayConstants::EPD_HEIGHT, DisplayConstants::EPD_WIDTH) {}
+namespace {
+    constexpr int ROW_BYTES = DisplayConstants::EPD_WIDTH / 8;
+
+    // Byte værdier for en farve i hver plan; false for farver displayet ikke kender
+    bool planeBits(uint16_t color, uint8_t& black, uint8_t& red) {
+        switch (color) {
+            case DisplayConstants::COLOR_WHITE:
+                black = 0xFF;
+                red = 0x00;
+                return true;
+            case DisplayConstants::COLOR_BLACK:
+                black = 0x00;
+                red = 0x00;
+                return true;
+            case DisplayConstants::COLOR_RED:
+                black = 0xFF;
+                red = 0xFF;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    inline void blend(uint8_t& target, uint8_t value, uint8_t mask) {
+        target = (target & ~mask) | (value & mask);
+    }
+}
+
+EpaperDisplay::EpaperDisplay()
+    : Adafruit_GFX(DisplayConstants::EPD_HEIGHT, DisplayConstants::EPD_WIDTH), frameShown(false), shownHash(0),
+      shownPlanesValid(false), partialRefreshes(0), lastPartial(false), refreshes(0), skippedRefreshes(0), lastUploadMicros(0),
+      lastRefreshMillis(0), lightSleepWhileBusy(false), busyCallback(nullptr), backgroundBuffer(nullptr) {}
+
+EpaperDisplay::~EpaperDisplay() {
+    free(backgroundBuffer);
+}
 
 void EpaperDisplay::begin() {
     LOG_I(TAG, "Initializing E-Paper Display");
 
+    setupInterface();
+
+    // Nulstil og initialiser
+    hardwareReset();
+    softwareReset();
+    initDisplay();
+
+    setupDrawing();
+    LOG_I(TAG, "E-Paper display initialized successfully");
+}
+
+void EpaperDisplay::resume(const RetainedState& state) {
+    setupInterface();
+
+    frameShown = state.frameShown;
+    shownHash = state.frameHash;
+    shownPlanesValid = false;
+    partialRefreshes = state.partialRefreshes;
+    refreshes = state.refreshes;
+    skippedRefreshes = state.skippedRefreshes;
+
+    setupDrawing();
+    LOG_I(TAG, "E-Paper display resumed without reset (%d partial refreshes since last full)", partialRefreshes);
+}
+
+void EpaperDisplay::retain(RetainedState& state) {
+    state.frameHash = shownHash;
+    state.refreshes = refreshes;
+    state.skippedRefreshes = skippedRefreshes;
+    state.partialRefreshes = partialRefreshes;
+    state.frameShown = frameShown;
+
+    // Flydende pins under deep sleep kan nulstille controlleren eller klokke en kommando ind
+    gpio_hold_en(static_cast<gpio_num_t>(Pins::EINK_RESET));
+    gpio_hold_en(static_cast<gpio_num_t>(Pins::EINK_CS));
+    gpio_deep_sleep_hold_en();
+}
+
+void EpaperDisplay::setupInterface() {
     // Initialiser pins
     pinMode(Pins::EINK_BUSY, INPUT);
     pinMode(Pins::EINK_RESET, OUTPUT);
     pinMode(Pins::EINK_DC, OUTPUT);
     pinMode(Pins::EINK_CS, OUTPUT);
 
+    // Holdt af retain() under deep sleep. Samme niveau før de slippes, så controlleren ikke ser en reset
+    digitalWrite(Pins::EINK_RESET, HIGH);
+    digitalWrite(Pins::EINK_CS, HIGH);
+    gpio_hold_dis(static_cast<gpio_num_t>(Pins::EINK_RESET));
+    gpio_hold_dis(static_cast<gpio_num_t>(Pins::EINK_CS));
+
     // Initialiser SPI
     SPI.begin(Pins::EINK_SCLK, -1, Pins::EINK_SDI, Pins::EINK_CS);
     SPI.beginTransaction(SPISettings(2000000, MSBFIRST, SPI_MODE0));
+}
 
-    // Nulstil og initialiser
-    hardwareReset();
-    softwareReset();
-    initDisplay();
-
+void EpaperDisplay::setupDrawing() {
     // Clear buffers til start
     clearBuffers();
 
@@ -38,7 +122,6 @@ void EpaperDisplay::begin() {
     // Juster tekstindstillinger
     setTextWrap(true);
 
-    LOG_I(TAG, "E-Paper display initialized successfully");
     cp437(true); // Brug CP437 tegnsæt for specialtegn
 }
 
@@ -70,34 +153,192 @@ void EpaperDisplay::initDisplay() {
     // Konfigurerer display kant
     sendCommand(DisplayConstants::CMD_BORDER_WAVEFORM);
     sendData(DisplayConstants::PARAM_NORMAL_BORDER); // Normal kantbølgeform
+
+    // RAM adressering der matcher bufferne, så vinduer kan skrives række for række
+    sendCommand(DisplayConstants::CMD_DATA_ENTRY_MODE);
+    sendData(DisplayConstants::PARAM_DATA_ENTRY_INC);
+
+    // Controlleren er nulstillet, så næste opdatering skal være fuld
+    frameShown = false;
 }
 
 void EpaperDisplay::clearBuffers() {
-    for (int i = 0; i < DisplayConstants::EPD_WIDTH * DisplayConstants::EPD_HEIGHT / 8; i++) {
-        blackBuffer[i] = 0xFF; // Alt hvidt
-        redBuffer[i] = 0x00;   // Intet rødt
+    fillScreen(DisplayConstants::COLOR_WHITE);
+}
+
+bool EpaperDisplay::saveBackground() {
+    if (!backgroundBuffer) {
+        backgroundBuffer = static_cast<uint8_t*>(malloc(2 * DisplayConstants::EPD_BUFFER_SIZE));
+        if (!backgroundBuffer) {
+            LOG_W(TAG, "No memory for background cache, redrawing every frame");
+            return false;
+        }
     }
+    memcpy(backgroundBuffer, blackBuffer, DisplayConstants::EPD_BUFFER_SIZE);
+    memcpy(backgroundBuffer + DisplayConstants::EPD_BUFFER_SIZE, redBuffer, DisplayConstants::EPD_BUFFER_SIZE);
+    return true;
+}
+
+bool EpaperDisplay::restoreBackground() {
+    if (!backgroundBuffer) {
+        return false;
+    }
+    memcpy(blackBuffer, backgroundBuffer, DisplayConstants::EPD_BUFFER_SIZE);
+    memcpy(redBuffer, backgroundBuffer + DisplayConstants::EPD_BUFFER_SIZE, DisplayConstants::EPD_BUFFER_SIZE);
+    return true;
+}
+
+uint32_t EpaperDisplay::frameHash() const {
+    uint32_t hash = Crc32::update(0, blackBuffer, DisplayConstants::EPD_BUFFER_SIZE);
+    return Crc32::update(hash, redBuffer, DisplayConstants::EPD_BUFFER_SIZE);
 }
 
 void EpaperDisplay::updateDisplay() {
+    uint32_t hash = frameHash();
 
-    // Send sort/hvid buffer til display
-    sendCommand(DisplayConstants::CMD_WRITE_RAM_BLACK);
-    for (int i = 0; i < DisplayConstants::EPD_WIDTH * DisplayConstants::EPD_HEIGHT / 8; i++) {
-        sendData(blackBuffer[i]);
+    // Samme frame som vises nu: ingen upload og ingen refresh
+    if (frameShown && hash == shownHash) {
+        skippedRefreshes++;
+        lastUploadMicros = 0;
+        LOG_D(TAG, "Frame unchanged, skipping refresh (%lu skipped)", static_cast<unsigned long>(skippedRefreshes));
+        return;
     }
 
-    // Send rød buffer til display
-    sendCommand(DisplayConstants::CMD_WRITE_RAM_RED);
-    for (int i = 0; i < DisplayConstants::EPD_WIDTH * DisplayConstants::EPD_HEIGHT / 8; i++) {
-        sendData(redBuffer[i]);
+    // Den hurtige waveform giver ghosting og svagere rød, så der ryddes op med fuld refresh med jævne mellemrum
+    bool full = !frameShown || partialRefreshes >= DisplayConstants::FULL_REFRESH_INTERVAL;
+
+    if (full) {
+        uploadFrame();
+        refresh(DisplayConstants::PARAM_UPDATE_FULL);
+        partialRefreshes = 0;
+    } else if (!shownPlanesValid) {
+        // Efter deep sleep kendes kun hashen af det viste, så hele framen sendes, men med partial refresh
+        uploadFrame();
+        refresh(DisplayConstants::PARAM_UPDATE_PARTIAL);
+        partialRefreshes++;
+    } else {
+        DirtyRect rects[DisplayConstants::MAX_DIRTY_RECTS];
+        int count = findDirtyRects(rects);
+        uploadDirtyRects(rects, count);
+        refresh(DisplayConstants::PARAM_UPDATE_PARTIAL);
+        partialRefreshes++;
     }
+    lastPartial = !full;
+    refreshes++;
+
+    memcpy(shownBlackBuffer, blackBuffer, DisplayConstants::EPD_BUFFER_SIZE);
+    memcpy(shownRedBuffer, redBuffer, DisplayConstants::EPD_BUFFER_SIZE);
+    shownHash = hash;
+    shownPlanesValid = true;
+    frameShown = true;
+}
 
-    // Opdater displayet
-    sendCommand(DisplayConstants::CMD_DISPLAY_UPDATE);
-    sendData(DisplayConstants::PARAM_UPDATE_FULL);
-    sendCommand(DisplayConstants::CMD_MASTER_ACTIVATION);
-    waitUntilIdle();
+void EpaperDisplay::uploadFrame() {
+    unsigned long start = micros();
+
+    // Vinduet kan være sat af en partial opdatering
+    setRamWindow(0, ROW_BYTES - 1, 0, DisplayConstants::EPD_HEIGHT - 1);
+
+    // Hver plan sendes som én SPI overførsel med DC/CS sat én gang
+    writePlane(DisplayConstants::CMD_WRITE_RAM_BLACK, blackBuffer);
+    writePlane(DisplayConstants::CMD_WRITE_RAM_RED, redBuffer);
+
+    lastUploadMicros = micros() - start;
+    LOG_D(TAG, "Frame uploaded in %lu us", lastUploadMicros);
+}
+
+int EpaperDisplay::findDirtyRects(DirtyRect* rects) const {
+    int count = 0;
+
+    for (int y = 0; y < DisplayConstants::EPD_HEIGHT; y++) {
+        int offset = y * ROW_BYTES;
+        auto changed = [this, offset](int x) {
+            return blackBuffer[offset + x] != shownBlackBuffer[offset + x] ||
+                   redBuffer[offset + x] != shownRedBuffer[offset + x];
+        };
+        if (memcmp(blackBuffer + offset, shownBlackBuffer + offset, ROW_BYTES) == 0 &&
+            memcmp(redBuffer + offset, shownRedBuffer + offset, ROW_BYTES) == 0) {
+            continue;
+        }
+
+        int first = 0;
+        while (!changed(first)) {
+            first++;
+        }
+        int last = ROW_BYTES - 1;
+        while (!changed(last)) {
+            last--;
+        }
+
+        // Tæt på forrige område, eller ikke plads til flere: udvid det sidste
+        if (count > 0 && (y - rects[count - 1].yEnd <= DisplayConstants::DIRTY_MERGE_ROWS ||
+                          count == DisplayConstants::MAX_DIRTY_RECTS)) {
+            DirtyRect& rect = rects[count - 1];
+            rect.xStart = std::min<uint8_t>(rect.xStart, first);
+            rect.xEnd = std::max<uint8_t>(rect.xEnd, last);
+            rect.yEnd = y;
+        } else {
+            rects[count++] = {static_cast<uint8_t>(first), static_cast<uint8_t>(last), static_cast<uint16_t>(y),
+                              static_cast<uint16_t>(y)};
+        }
+    }
+    return count;
+}
+
+void EpaperDisplay::uploadDirtyRects(const DirtyRect* rects, int count) {
+    unsigned long start = micros();
+    size_t bytes = 0;
+
+    for (int i = 0; i < count; i++) {
+        const DirtyRect& rect = rects[i];
+        size_t width = rect.xEnd - rect.xStart + 1;
+
+        setRamWindow(rect.xStart, rect.xEnd, rect.yStart, rect.yEnd);
+        writeWindow(DisplayConstants::CMD_WRITE_RAM_BLACK, blackBuffer, rect);
+        // Skrivningen flytter adressetællerne, så de sættes tilbage til vinduets hjørne
+        setRamWindow(rect.xStart, rect.xEnd, rect.yStart, rect.yEnd);
+        writeWindow(DisplayConstants::CMD_WRITE_RAM_RED, redBuffer, rect);
+        bytes += 2 * width * (rect.yEnd - rect.yStart + 1);
+    }
+
+    lastUploadMicros = micros() - start;
+    LOG_D(TAG, "Uploaded %d dirty rects (%u bytes) in %lu us", count, static_cast<unsigned>(bytes),
+          lastUploadMicros);
+}
+
+void EpaperDisplay::writeWindow(uint8_t command, const uint8_t* plane, const DirtyRect& rect) {
+    size_t width = rect.xEnd - rect.xStart + 1;
+
+    sendCommand(command);
+    // Ét CS vindue pr. område; rækkerne ligger ikke i forlængelse af hinanden i bufferen
+    digitalWrite(Pins::EINK_DC, HIGH);
+    digitalWrite(Pins::EINK_CS, LOW);
+    for (int y = rect.yStart; y <= rect.yEnd; y++) {
+        SPI.writeBytes(plane + y * ROW_BYTES + rect.xStart, width);
+    }
+    digitalWrite(Pins::EINK_CS, HIGH);
+}
+
+void EpaperDisplay::setRamWindow(uint8_t xStart, uint8_t xEnd, uint16_t yStart, uint16_t yEnd) {
+    const uint8_t xRange[] = {xStart, xEnd};
+    const uint8_t yRange[] = {static_cast<uint8_t>(yStart & 0xFF), static_cast<uint8_t>(yStart >> 8),
+                              static_cast<uint8_t>(yEnd & 0xFF), static_cast<uint8_t>(yEnd >> 8)};
+
+    sendCommand(DisplayConstants::CMD_RAM_X_RANGE);
+    sendData(xRange, sizeof(xRange));
+    sendCommand(DisplayConstants::CMD_RAM_Y_RANGE);
+    sendData(yRange, sizeof(yRange));
+
+    // Adressetællerne starter i vinduets hjørne
+    sendCommand(DisplayConstants::CMD_RAM_X_COUNTER);
+    sendData(xStart);
+    sendCommand(DisplayConstants::CMD_RAM_Y_COUNTER);
+    sendData(yRange, 2);
+}
+
+void EpaperDisplay::writePlane(uint8_t command, const uint8_t* plane) {
+    sendCommand(command);
+    sendData(plane, DisplayConstants::EPD_BUFFER_SIZE);
 }
 
 void EpaperDisplay::sendCommand(uint8_t command) {
@@ -108,29 +349,72 @@ void EpaperDisplay::sendCommand(uint8_t command) {
 }
 
 void EpaperDisplay::sendData(uint8_t data) {
+    sendData(&data, 1);
+}
+
+void EpaperDisplay::sendData(const uint8_t* data, size_t length) {
     digitalWrite(Pins::EINK_DC, HIGH);
     digitalWrite(Pins::EINK_CS, LOW);
-    SPI.transfer(data);
+    SPI.writeBytes(data, length);
     digitalWrite(Pins::EINK_CS, HIGH);
 }
 
 void EpaperDisplay::waitUntilIdle() {
+    bool idle = lightSleepWhileBusy ? sleepUntilIdle() : pollUntilIdle();
+    if (!idle) {
+        LOG_E(TAG, "waitUntilIdle timeout after %d seconds", TimeUtils::to_seconds(TimeConstants::EPAPER_BUSY_TIMEOUT));
+    }
+}
+
+bool EpaperDisplay::pollUntilIdle() {
     unsigned long start = millis();
     while (digitalRead(Pins::EINK_BUSY) == LOW) {
-        TimeUtils::delay_for(TimeConstants::EPAPER_BUSY_POLL_DELAY);
         if (millis() - start > TimeUtils::to_ms(TimeConstants::EPAPER_BUSY_TIMEOUT)) {
-            LOG_E(TAG, "waitUntilIdle timeout after %d seconds",
-                  TimeUtils::to_seconds(TimeConstants::EPAPER_BUSY_TIMEOUT));
+            return false;
+        }
+        if (busyCallback) {
+            busyCallback();
+        }
+        TimeUtils::delay_for(TimeConstants::EPAPER_BUSY_POLL_DELAY);
+    }
+    return true;
+}
+
+bool EpaperDisplay::sleepUntilIdle() {
+    unsigned long timeoutMs = TimeUtils::to_ms(TimeConstants::EPAPER_BUSY_TIMEOUT);
+    unsigned long start = millis();
+
+    // BUSY går HIGH når controlleren er færdig; timeren er fallback hvis det aldrig sker
+    gpio_wakeup_enable(static_cast<gpio_num_t>(Pins::EINK_BUSY), GPIO_INTR_HIGH_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    bool idle = true;
+    while (digitalRead(Pins::EINK_BUSY) == LOW) {
+        unsigned long elapsed = millis() - start;
+        if (elapsed >= timeoutMs) {
+            idle = false;
             break;
         }
+        esp_sleep_enable_timer_wakeup(static_cast<uint64_t>(timeoutMs - elapsed) * 1000);
+        esp_light_sleep_start();
     }
+
+    // Andre light sleeps skal ikke vækkes af BUSY
+    gpio_wakeup_disable(static_cast<gpio_num_t>(Pins::EINK_BUSY));
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    return idle;
 }
 
-void EpaperDisplay::fullRefresh() {
+void EpaperDisplay::refresh(uint8_t updateMode) {
     sendCommand(DisplayConstants::CMD_DISPLAY_UPDATE);
-    sendData(DisplayConstants::PARAM_UPDATE_FULL);
+    sendData(updateMode);
     sendCommand(DisplayConstants::CMD_MASTER_ACTIVATION);
+
+    unsigned long start = millis();
     waitUntilIdle();
+    lastRefreshMillis = millis() - start;
+    LOG_D(TAG, "Refresh 0x%02X took %lu ms", updateMode, lastRefreshMillis);
 }
 
 void EpaperDisplay::setPixel(int16_t x, int16_t y, uint16_t color) {
@@ -160,6 +444,72 @@ void EpaperDisplay::drawPixel(int16_t x, int16_t y, uint16_t color) {
     setPixel(y, x, color);
 }
 
+void EpaperDisplay::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillArea(x, y, w, 1, color);
+}
+
+void EpaperDisplay::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillArea(x, y, 1, h, color);
+}
+
+void EpaperDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    fillArea(x, y, w, h, color);
+}
+
+void EpaperDisplay::fillScreen(uint16_t color) {
+    uint8_t black, red;
+    if (!planeBits(color, black, red)) {
+        return;
+    }
+    memset(blackBuffer, black, DisplayConstants::EPD_BUFFER_SIZE);
+    memset(redBuffer, red, DisplayConstants::EPD_BUFFER_SIZE);
+}
+
+void EpaperDisplay::fillArea(int x, int y, int w, int h, uint16_t color) {
+    // Negative mål tegner mod venstre/op som i Adafruit_GFX
+    if (w < 0) {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0) {
+        y += h + 1;
+        h = -h;
+    }
+
+    int xStart = std::max(x, 0);
+    int xEnd = std::min(x + w, static_cast<int>(width())) - 1;
+    int yStart = std::max(y, 0);
+    int yEnd = std::min(y + h, static_cast<int>(height())) - 1;
+    uint8_t black, red;
+    if (xStart > xEnd || yStart > yEnd || !planeBits(color, black, red)) {
+        return;
+    }
+
+    // Som i drawPixel er GFX x controllerens række og GFX y pixlen i rækken, så hver række er et
+    // sammenhængende bitspænd: kantbytes maskeres, bytes imellem sættes helt
+    int firstByte = yStart / 8;
+    int lastByte = yEnd / 8;
+    uint8_t firstMask = 0xFF >> (yStart % 8);
+    uint8_t lastMask = 0xFF << (7 - yEnd % 8);
+    if (firstByte == lastByte) {
+        firstMask &= lastMask;
+    }
+
+    for (int row = xStart; row <= xEnd; row++) {
+        uint8_t* blackRow = blackBuffer + row * ROW_BYTES;
+        uint8_t* redRow = redBuffer + row * ROW_BYTES;
+
+        blend(blackRow[firstByte], black, firstMask);
+        blend(redRow[firstByte], red, firstMask);
+        if (lastByte > firstByte) {
+            memset(blackRow + firstByte + 1, black, lastByte - firstByte - 1);
+            memset(redRow + firstByte + 1, red, lastByte - firstByte - 1);
+            blend(blackRow[lastByte], black, lastMask);
+            blend(redRow[lastByte], red, lastMask);
+        }
+    }
+}
+
 void EpaperDisplay::drawTestPattern() {
     LOG_D(TAG, "Drawing test pattern");
 
@@ -7,7 +7,8 @@
 static const char* TAG = "SensorManager";
 
 SensorManager::SensorManager()
-    : _lastReadTime(0), _readInterval(15000), _tempOffset(0.0f), _humOffset(0.0f), _firstReading(true),
+    : _lastReadTime(0), _readInterval(15000), _readRequested(false),
+      _bme280Address(Sensors::BME280_ADDR_PRIMARY), _tempOffset(0.0f), _humOffset(0.0f), _firstReading(true),
       _filteredTemp(0.0f), _filteredHum(0.0f), _baselineDistance(0), _loopCallback(nullptr) {
     memset(&_currentData, 0, sizeof(_currentData));
     memset(&_health, 0, sizeof(_health));
@@ -36,10 +37,12 @@ bool SensorManager::begin() {
     scanI2C();
 
     LOG_I(TAG, "Attempting to initialize BME280 at address 0x%02X", Sensors::BME280_ADDR_PRIMARY);
-    unsigned status = _bme.begin(Sensors::BME280_ADDR_PRIMARY, &Wire);
+    _bme280Address = Sensors::BME280_ADDR_PRIMARY;
+    unsigned status = _bme.begin(_bme280Address, &Wire);
     if (!status) {
         LOG_W(TAG, "BME280 not found at primary address, trying secondary 0x%02X", Sensors::BME280_ADDR_SECONDARY);
-        status = _bme.begin(Sensors::BME280_ADDR_SECONDARY, &Wire);
+        _bme280Address = Sensors::BME280_ADDR_SECONDARY;
+        status = _bme.begin(_bme280Address, &Wire);
     }
 
     _health.bme280Connected = status;
@@ -88,6 +91,73 @@ bool SensorManager::begin() {
 #endif
 }
 
+bool SensorManager::resume(const RetainedState& state) {
+    _filteredTemp = state.filteredTemp;
+    _filteredHum = state.filteredHum;
+    _baselineDistance = state.baselineDistance;
+    _currentData.peakRisePercent = state.peakRisePercent;
+    _firstReading = state.firstReading;
+    _bme280Address = state.bme280Address;
+    _readRequested = true;
+
+#ifdef SIMULATE_SENSORS
+    _health.bme280Connected = true;
+    _health.tofConnected = true;
+    return true;
+#else
+    Wire.begin(Pins::I2C_SDA, Pins::I2C_SCL);
+    Wire.setClock(Sensors::I2C_CLOCK_SPEED);
+
+    // BME280 har været strømforsynet hele tiden og skal blot vækkes med samme opsætning som i begin()
+    _health.bme280Connected = state.bme280Connected && _bme.begin(_bme280Address, &Wire);
+    if (_health.bme280Connected) {
+        _bme.setSampling(Adafruit_BME280::MODE_NORMAL, Adafruit_BME280::SAMPLING_X16, Adafruit_BME280::SAMPLING_X1,
+                         Adafruit_BME280::SAMPLING_X16, Adafruit_BME280::FILTER_X16, Adafruit_BME280::STANDBY_MS_0_5);
+    }
+
+    _health.tofConnected = false;
+    if (state.tofConnected) {
+        // XSHUT holdes ikke under deep sleep; VL53L0X skal ud af shutdown før init
+        pinMode(Pins::XSHUT, OUTPUT);
+        digitalWrite(Pins::XSHUT, HIGH);
+        TimeUtils::delay_for(TimeConstants::XSHUT_RESET_DELAY);
+        _health.tofConnected = _tof.init();
+    }
+    if (_health.tofConnected) {
+        _tof.setTimeout(TimeUtils::to_ms(TimeConstants::VL53L0X_TIMEOUT));
+        _tof.setMeasurementTimingBudget(TimeUtils::to_us(TimeConstants::VL53L0X_TIMING_BUDGET));
+        _tof.startContinuous();
+    }
+
+    LOG_I(TAG, "Sensors resumed. BME280=%s, VL53L0X=%s", _health.bme280Connected ? "connected" : "disconnected",
+          _health.tofConnected ? "connected" : "disconnected");
+
+    // Svarer ingen af dem, må begin() lede efter dem igen
+    return _health.bme280Connected || _health.tofConnected;
+#endif
+}
+
+void SensorManager::retain(RetainedState& state) {
+    state.filteredTemp = _filteredTemp;
+    state.filteredHum = _filteredHum;
+    state.baselineDistance = _baselineDistance;
+    state.peakRisePercent = _currentData.peakRisePercent;
+    state.bme280Address = _bme280Address;
+    state.bme280Connected = _health.bme280Connected;
+    state.tofConnected = _health.tofConnected;
+    state.firstReading = _firstReading;
+
+#ifndef SIMULATE_SENSORS
+    // Kontinuerlig måling og BME280 normal mode ville ellers trække strøm hele søvnen
+    if (_health.tofConnected) {
+        _tof.stopContinuous();
+    }
+    if (_health.bme280Connected) {
+        _bme.setSampling(Adafruit_BME280::MODE_SLEEP);
+    }
+#endif
+}
+
 bool SensorManager::readAllSensors() {
     bool success = true;
 
@@ -141,7 +211,7 @@ bool SensorManager::readAllSensors() {
 }
 
 bool SensorManager::shouldRead() const {
-    return (millis() - _lastReadTime) >= _readInterval;
+    return _readRequested || (millis() - _lastReadTime) >= _readInterval;
 }
 
 void SensorManager::resetBaseline() {
@@ -168,6 +238,7 @@ bool SensorManager::collectMultipleSamples() {
           _currentData.inTemp, _currentData.inHumidity, simulatedGrowth);
 
     _firstReading = false;
+    _readRequested = false;
     _lastReadTime = millis();
     return true;
 #else
@@ -285,6 +356,7 @@ bool SensorManager::collectMultipleSamples() {
     }
 
     _firstReading = false;
+    _readRequested = false;
     _lastReadTime = millis();
     return (validTempSamples > 0 || validHumSamples > 0 || validDistSamples > 0);
 #endif
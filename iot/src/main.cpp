@@ -1,8 +1,13 @@
+// Udelades når PlatformIO bygger unit tests, som har deres egen setup()/loop()
+#ifndef PIO_UNIT_TESTING
+
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <WiFi.h>
 #include <Update.h>
+#include "esp_attr.h"
 #include "esp_ota_ops.h"
+#include "esp_sleep.h"
 
 #include "config/constants.h"
 #include "config/settings.h"
@@ -10,6 +15,7 @@
 #include "app/data_types.h"
 #include "app/state_machine.h"
 #include "app/epaper_monitor.h"
+#include "app/history_store.h"
 #include "hardware/button_manager.h"
 #include "hardware/epaper_display.h"
 #include "hardware/sensor_manager.h"
@@ -24,6 +30,7 @@
 #include "network/mqtt_message_router.h"
 #include "logging/logger.h"
 #include "network/ntfy_manager.h"
+#include "util/retained.h"
 
 static const char* TAG = "Main";
 
@@ -41,11 +48,35 @@ Settings settings;
 EpaperDisplay display;
 EpaperMonitor monitor(display);
 SourdoughData historicalData = {};
+HistoryStore historyStore;
 OtaManager otaManager;
 NtfyManager* ntfyManager = nullptr;
 
 unsigned long lastStateCheck = 0;
 bool needsOtaValidation = false;
+bool wokeFromDeepSleep = false;
+
+// WiFi kommer op sideløbende med måling og skærm (se updateWifiStatus); MQTT og NTP forbindes bagefter fra
+// CONNECTING_MQTT, da de blokerer
+bool wifiReady = false;
+bool timeSyncPending = false;
+bool mqttAttempted = false;
+unsigned long lastMqttAttempt = 0;
+
+CycleProgress cycle = {};
+
+// Arbejdstilstanden gennem deep sleep, så opvågningen kan springe settings filen, sensor-søgning, display reset
+// og stabiliseringspauser over. Historikken har sin egen RTC kopi i HistoryStore. RTC_DATA_ATTR nulstilles ved
+// alle andre resets end deep sleep, så alt andet giver en fuld opstart
+struct WakeState {
+    Settings::RetainedState settings;
+    SensorManager::RetainedState sensors;
+    TimeManager::RetainedState time;
+    NtfyManager::RetainedState notifications;
+    EpaperDisplay::RetainedState display;
+};
+constexpr uint32_t WAKE_STATE_MAGIC = 0x42425732; // "BBW2"
+RTC_DATA_ATTR Retained<WakeState, WAKE_STATE_MAGIC> wakeState;
 
 void handleButtonEvents();
 void handleCurrentState();
@@ -57,45 +88,67 @@ void handleStateUpdatingDisplay();
 void handleStatePublishingData();
 void handleStateSleep();
 void handleStateError();
+AppState nextCycleState();
+void serviceWhileBusy();
+void updateWifiStatus();
+void syncTimeAfterConnect();
+bool connectMqtt();
+void enterDeepSleep(std::chrono::seconds duration);
 void handleStateOtaUpdate();
 void handleDiagnosticsRequest(const String& topic, const uint8_t* payload, unsigned int length);
+void handleHistoryRequest(const String& topic, const uint8_t* payload, unsigned int length);
 void handleOtaMessageWrapper(const String& topic, const uint8_t* payload, unsigned int length);
 void setupDiagnosticsHandler();
+void setupHistoryHandler();
 void setupOtaHandler();
 void validateBootAfterOta();
 void publishOtaStatus(const String& status, uint8_t progress);
+void publishOtaBackpressure(bool active, uint8_t queuedChunks);
+void publishOtaResumeRequest(const String& version, uint32_t nextChunk, uint32_t offset);
+void publishOtaAck(uint32_t nextChunk, uint32_t receivedMask, uint32_t window);
 
 void setup() {
     Serial.begin(115200);
     Logger::begin(LOG_DEBUG, true, true);
 
-    LOG_I(TAG, "--- Sourdough analyzer startup ---");
+    bool resumed = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER && wakeState.valid();
+    wokeFromDeepSleep = resumed;
+    // Kun til denne opvågning; går cyklussen galt, skal næste opstart være fuld
+    wakeState.invalidate();
+
+    LOG_I(TAG, resumed ? "--- Sourdough analyzer wake from deep sleep ---" : "--- Sourdough analyzer startup ---");
     
     validateBootAfterOta();
 
-    if (!settings.begin()) {
+    bool settingsReady = resumed ? settings.resume(wakeState.value.settings) : settings.begin();
+    if (!settingsReady) {
         LOG_E(TAG, "Failed to initialize settings");
         stateMachine.transitionTo(STATE_ERROR);
         return;
     }
 
-    display.begin();
+    if (resumed) {
+        display.resume(wakeState.value.display);
+    } else {
+        display.begin();
+    }
     buttonManager.begin();
     batteryManager.begin();
     ledManager.begin();
     
-    historicalData.dataCount = 0;
-    historicalData.oldestIndex = 0;
-    historicalData.bufferFull = false;
+    // Efter settings, som mounter LittleFS
+    historyStore.restore(monitor, historicalData);
     historicalData.batteryLevel = batteryManager.getPercentage();
 
-    if (!sensorManager.begin()) {
+    bool sensorsReady = resumed && sensorManager.resume(wakeState.value.sensors);
+    if (!sensorsReady && !sensorManager.begin()) {
         LOG_E(TAG, "Failed to initialize sensors");
     }
 
     sensorManager.setCalibration(settings.getTempOffset(), settings.getHumOffset());
     sensorManager.setReadInterval(TimeUtils::to_ms(std::chrono::seconds(settings.getSensorInterval())));
-    sensorManager.setLoopCallback([]() { ledManager.loop(); });
+    sensorManager.setLoopCallback(serviceWhileBusy);
+    display.setBusyCallback(serviceWhileBusy);
     LOG_I(TAG, "Sensor interval configured: %d seconds", settings.getSensorInterval());
     
     if (buttonManager.isStartupResetPressed()) {
@@ -105,12 +158,21 @@ void setup() {
         ESP.restart();
     }
 
+    if (resumed) {
+        timeManager.resume(wakeState.value.time);
+    }
+
+    // Returnerer med det samme; forbindelsen kommer op mens der måles
     wifiManager.begin();
+    ledManager.setPattern(LedManager::WIFI_CONNECTING);
 
-    stateMachine.transitionTo(STATE_CONNECTING_WIFI);
+    stateMachine.transitionTo(STATE_SENSING);
 
     String analyzerId = settings.getAnalyzerId();
     ntfyManager = new NtfyManager(analyzerId);
+    if (resumed) {
+        ntfyManager->resume(wakeState.value.notifications);
+    }
 }
 
 void loop() {
@@ -204,81 +266,132 @@ void handleCurrentState() {
 }
 
 void handleStateBoot() {
-    stateMachine.transitionTo(STATE_CONNECTING_WIFI);
+    stateMachine.transitionTo(STATE_SENSING);
 }
 
-void handleStateConnectingWifi() {
-    static bool ledSet = false;
-    if (!ledSet) {
+AppState nextCycleState() {
+    return nextCycleState(cycle, wifiReady, mqttManager.isConnected());
+}
+
+// Kører mellem sensorprøverne og mens skærmen er BUSY. Intet her må blokere
+void serviceWhileBusy() {
+    ledManager.loop();
+    buttonManager.loop();
+    wifiManager.loop();
+    updateWifiStatus();
+}
+
+// Følger WiFi uden at vente på radioen: kun flag og LED. Kaldes både fra CONNECTING tilstandene og under måling
+// og skærmopdatering, så forbindelsen typisk er klar når de er færdige
+void updateWifiStatus() {
+    bool connected = wifiManager.getStatus() == WIFI_CONNECTED;
+    if (connected == wifiReady) {
+        return;
+    }
+
+    wifiReady = connected;
+    if (connected) {
+        LOG_I(TAG, "WiFi connected");
+        ledManager.setPattern(LedManager::CONNECTED);
+        timeSyncPending = true;
+    } else {
         ledManager.setPattern(LedManager::WIFI_CONNECTING);
-        ledSet = true;
     }
-    
+}
+
+// NTP når WiFi er kommet op. Blokerer, så kun fra tilstandsmaskinen
+void syncTimeAfterConnect() {
+    timeSyncPending = false;
+
+    if (!timeManager.isTimeValid()) {
+        LOG_I(TAG, "Synchronizing time with NTP server");
+        timeManager.trySync();
+    } else if (wokeFromDeepSleep) {
+        // Først nu er der netværk til en synkronisering efter lang søvn
+        timeManager.adjustAfterSleep(TimeUtils::to_ms(std::chrono::seconds(settings.getSensorInterval())));
+    }
+    wokeFromDeepSleep = false;
+}
+
+bool connectMqtt() {
+    String server = settings.getMqttServer();
+    int port = settings.getMqttPort();
+    String user = settings.getMqttUser();
+    String password = settings.getMqttPassword();
+    String analyzerId = settings.getAnalyzerId();
+
+    LOG_D(TAG, "Connecting to MQTT - Server: %s, Port: %d", server.c_str(), port);
+
+    if (mqttTopics == nullptr) {
+        mqttTopics = new MqttTopics(analyzerId);
+        mqttManager.setTopics(mqttTopics);
+        messageRouter.setTopics(mqttTopics);
+        LOG_I(TAG, "MQTT topics initialized for device: %s", analyzerId.c_str());
+    }
+
+    if (!mqttManager.begin(server.c_str(), port, user.c_str(), password.c_str(), analyzerId.c_str())) {
+        return false;
+    }
+
+    LOG_I(TAG, "MQTT connection established");
+
+    if (needsOtaValidation) {
+        LOG_I(TAG, "Marking OTA update as valid");
+        esp_ota_mark_app_valid_cancel_rollback();
+        needsOtaValidation = false;
+    }
+
+    mqttManager.setCallback([](char* topic, byte* payload, unsigned int length) {
+        messageRouter.routeMessage(topic, payload, length);
+    });
+
+    messageRouter.setDiagnosticsHandler(handleDiagnosticsRequest);
+    messageRouter.setHistoryHandler(handleHistoryRequest);
+    messageRouter.setOtaHandler(handleOtaMessageWrapper);
+
+    setupDiagnosticsHandler();
+    setupHistoryHandler();
+    setupOtaHandler();
+    return true;
+}
+
+void handleStateConnectingWifi() {
     if (wifiManager.hasError()) {
         LOG_E(TAG, "WiFi manager error detected");
         ledManager.setPattern(LedManager::OFF);
-        ledSet = false;
         stateMachine.transitionTo(STATE_ERROR);
-    } else if (wifiManager.getStatus() == WIFI_CONNECTED) {
-        TimeUtils::delay_for(TimeConstants::WIFI_STABILIZATION_DELAY);
-        LOG_I(TAG, "WiFi connected");
-        ledManager.setPattern(LedManager::CONNECTED);
-        ledSet = false;
-        
-        if (!timeManager.isTimeValid()) {
-            LOG_I(TAG, "Synchronizing time with NTP server");
-            timeManager.trySync();
-        }
-        
+        return;
+    }
+
+    updateWifiStatus();
+    if (wifiReady) {
         stateMachine.transitionTo(STATE_CONNECTING_MQTT);
     }
 }
 
 void handleStateConnectingMqtt() {
-    if (!mqttManager.isConnected()) {
-        String server = settings.getMqttServer();
-        int port = settings.getMqttPort();
-        String user = settings.getMqttUser();
-        String password = settings.getMqttPassword();
-        String analyzerId = settings.getAnalyzerId();
-
-        LOG_D(TAG, "Connecting to MQTT - Server: %s, Port: %d", server.c_str(), port);
-              
-        if (mqttTopics == nullptr) {
-            mqttTopics = new MqttTopics(analyzerId);
-            mqttManager.setTopics(mqttTopics);
-            messageRouter.setTopics(mqttTopics);
-            LOG_I(TAG, "MQTT topics initialized for device: %s", analyzerId.c_str());
-        }
+    updateWifiStatus();
+    if (!wifiReady) {
+        stateMachine.transitionTo(STATE_CONNECTING_WIFI);
+        return;
+    }
 
-        if (mqttManager.begin(server.c_str(), port, user.c_str(), password.c_str(), analyzerId.c_str())) {
-            LOG_I(TAG, "MQTT connection established");
-            
-            if (needsOtaValidation) {
-                LOG_I(TAG, "Marking OTA update as valid");
-                esp_ota_mark_app_valid_cancel_rollback();
-                needsOtaValidation = false;
-            }
-            
-            mqttManager.setCallback([](char* topic, byte* payload, unsigned int length) {
-                messageRouter.routeMessage(topic, payload, length);
-            });
-            
-            messageRouter.setDiagnosticsHandler(handleDiagnosticsRequest);
-            messageRouter.setOtaHandler(handleOtaMessageWrapper);
-            
-            setupDiagnosticsHandler();
-            setupOtaHandler();
-            
-            timeManager.trySync();
-            
-            stateMachine.transitionTo(STATE_SENSING);
-        } else {
+    if (timeSyncPending) {
+        syncTimeAfterConnect();
+    }
+
+    // Før første måling er det kun tiden der mangler; MQTT forbindes når der er noget at sende
+    if (cycle.sampled && !mqttManager.isConnected() &&
+        (!mqttAttempted || millis() - lastMqttAttempt >= TimeUtils::to_ms(TimeConstants::MQTT_RETRY_DELAY))) {
+        mqttAttempted = true;
+        lastMqttAttempt = millis();
+        if (!connectMqtt()) {
             LOG_E(TAG, "MQTT connection failed, retrying in 5 seconds");
-            TimeUtils::delay_for(TimeConstants::MQTT_RETRY_DELAY);
         }
-    } else {
-        stateMachine.transitionTo(STATE_SENSING);
+    }
+
+    if (!cycle.sampled || mqttManager.isConnected()) {
+        stateMachine.transitionTo(nextCycleState());
     }
 }
 
@@ -286,6 +399,12 @@ void handleStateSensing() {
     if (timeManager.shouldRetrySync()) {
         timeManager.trySync();
     }
+
+    // Uden gyldig tid (første opstart) kan målingen ikke tidsstemples; netværket og NTP må op først
+    if (!timeManager.isTimeValid() && (!wifiReady || timeSyncPending)) {
+        stateMachine.transitionTo(STATE_CONNECTING_WIFI);
+        return;
+    }
     
     if (sensorManager.shouldRead()) {
         LOG_I(TAG, "Collecting sensor samples...");
@@ -300,20 +419,21 @@ void handleStateSensing() {
             
             unsigned long timestamp = timeManager.getEpochTime();
             monitor.addDataPoint(historicalData, (int)sensorData.currentRisePercent, timestamp);
+            historyStore.record(historicalData, timestamp, (int)sensorData.currentRisePercent);
             
-            if (ntfyManager) {
-                ntfyManager->checkRiseValue(sensorData.currentRisePercent);
-            }
-            
-            stateMachine.transitionTo(STATE_UPDATING_DISPLAY);
+            cycle = {true, false, false};
+            stateMachine.transitionTo(nextCycleState());
         }
     }
 }
 
 void handleStateUpdatingDisplay() {
+    // Light sleep stopper radioen, så kun når brugeren har valgt strømbesparelse og data allerede er sendt
+    display.setLightSleepWhileBusy(settings.getLowPowerMode() && cycle.published);
     monitor.updateDisplay(historicalData);
     LOG_I(TAG, "Display updated");
-    stateMachine.transitionTo(STATE_PUBLISHING_DATA);
+    cycle.displayed = true;
+    stateMachine.transitionTo(nextCycleState());
 }
 
 void handleStatePublishingData() {
@@ -336,6 +456,12 @@ void handleStatePublishingData() {
         } else {
             LOG_E(TAG, "Failed to publish data");
         }
+        cycle.published = true;
+
+        // Notifikationen går over HTTP og venter derfor også på netværket
+        if (ntfyManager) {
+            ntfyManager->checkRiseValue(data.currentRisePercent);
+        }
         
         mqttManager.loop();
         
@@ -343,7 +469,7 @@ void handleStatePublishingData() {
             LOG_I(TAG, "OTA in progress, staying awake");
             stateMachine.transitionTo(STATE_OTA_UPDATE);
         } else {
-            stateMachine.transitionTo(STATE_SLEEP);
+            stateMachine.transitionTo(nextCycleState());
         }
     }
 }
@@ -356,29 +482,33 @@ void handleStateSleep() {
     }
     
     if (settings.getLowPowerMode()) {
-        WiFi.disconnect(true);
-        WiFi.mode(WIFI_OFF);
-
-        auto sleepDuration = std::chrono::seconds(settings.getSensorInterval());
-        TimeUtils::enable_sleep_timer(sleepDuration);
-        esp_light_sleep_start();
-
-        timeManager.adjustAfterSleep(TimeUtils::to_ms(sleepDuration));
-
-        if (!settings.begin()) {
-            LOG_E(TAG, "Failed to re-initialize settings after sleep");
-            stateMachine.transitionTo(STATE_ERROR);
-            return;
-        }
-
-        WiFi.mode(WIFI_STA);
-        
-        stateMachine.transitionTo(STATE_CONNECTING_WIFI);
+        enterDeepSleep(std::chrono::seconds(settings.getSensorInterval()));
     } else {
         stateMachine.transitionTo(STATE_SENSING);
     }
 }
 
+void enterDeepSleep(std::chrono::seconds duration) {
+    // Sensorerne lægges i dvale uanset hvad; kan settings ikke gemmes, bliver opvågningen en fuld opstart
+    sensorManager.retain(wakeState.value.sensors);
+    timeManager.retain(wakeState.value.time);
+    display.retain(wakeState.value.display);
+    if (ntfyManager) {
+        ntfyManager->retain(wakeState.value.notifications, TimeUtils::to_ms(duration));
+    }
+    if (settings.retain(wakeState.value.settings)) {
+        wakeState.seal();
+    }
+
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+
+    LOG_I(TAG, "Entering deep sleep for %d seconds", TimeUtils::to_seconds(duration));
+    Serial.flush();
+    TimeUtils::enable_sleep_timer(duration);
+    esp_deep_sleep_start();
+}
+
 void handleStateError() {
     LOG_E(TAG, "Error state - resetting in 5 seconds");
     TimeUtils::delay_for(TimeConstants::ERROR_STATE_DELAY);
@@ -417,6 +547,8 @@ void handleStateOtaUpdate() {
             statusDoc["resumed"] = true;
             mqttManager.publish(mqttTopics->getOtaStatusTopic().c_str(), statusDoc);
         }
+        
+        otaManager.requestResume();
     }
     wasConnected = isConnected;
     
@@ -425,9 +557,11 @@ void handleStateOtaUpdate() {
         lastMqttLoop = now;
     }
     
+    otaManager.loop();
+    
     if (!otaManager.isInProgress()) {
         LOG_W(TAG, "OTA state active but no update in progress");
-        stateMachine.transitionTo(STATE_SENSING);
+        stateMachine.transitionTo(nextCycleState());
         initialized = false;
         return;
     }
@@ -444,8 +578,8 @@ void handleStateOtaUpdate() {
     if (timeSinceProgress > TimeConstants::OTA_PROGRESS_STALL_WARNING && currentProgress > 0) {
         if (timeSinceProgress > TimeConstants::OTA_PROGRESS_STALL_TIMEOUT) {
             LOG_E(TAG, "OTA timeout - stuck at %d%%", currentProgress);
-            otaManager.abort("OTA stalled");
-            stateMachine.transitionTo(STATE_SENSING);
+            otaManager.abort("OTA stalled", true);
+            stateMachine.transitionTo(nextCycleState());
             initialized = false;
             return;
         }
@@ -454,8 +588,8 @@ void handleStateOtaUpdate() {
     auto timeInOta = duration_cast<seconds>(now - otaStartTime);
     if (timeInOta > TimeConstants::OTA_INITIAL_TIMEOUT && currentProgress == 0) {
         LOG_E(TAG, "OTA timeout - no chunks received");
-        otaManager.abort("No chunks received");
-        stateMachine.transitionTo(STATE_SENSING);
+        otaManager.abort("No chunks received", true);
+        stateMachine.transitionTo(nextCycleState());
         initialized = false;
         return;
     }
@@ -463,7 +597,7 @@ void handleStateOtaUpdate() {
     auto status = otaManager.getStatus();
     if (status == OtaManager::OtaStatus::ERROR) {
         LOG_E(TAG, "OTA error occurred");
-        stateMachine.transitionTo(STATE_SENSING);
+        stateMachine.transitionTo(nextCycleState());
         initialized = false;
     } else if (status == OtaManager::OtaStatus::COMPLETE) {
         LOG_I(TAG, "OTA complete, device will reboot");
@@ -502,24 +636,76 @@ void handleDiagnosticsRequest(const String& topic, const uint8_t* payload, unsig
     responseDoc[MqttProtocol::DiagnosticsFields::BATTERY][MqttProtocol::DiagnosticsFields::BATTERY_PERCENTAGE] = batteryManager.getPercentage();
     responseDoc[MqttProtocol::DiagnosticsFields::BATTERY][MqttProtocol::DiagnosticsFields::BATTERY_CHARGING] = batteryManager.isCharging();
     
+    responseDoc[MqttProtocol::DiagnosticsFields::DISPLAY][MqttProtocol::DiagnosticsFields::DISPLAY_REFRESHES] = display.getRefreshCount();
+    responseDoc[MqttProtocol::DiagnosticsFields::DISPLAY][MqttProtocol::DiagnosticsFields::DISPLAY_SKIPPED_REFRESHES] = display.getSkippedRefreshCount();
+    responseDoc[MqttProtocol::DiagnosticsFields::DISPLAY][MqttProtocol::DiagnosticsFields::DISPLAY_LAST_REFRESH_MS] = display.getLastRefreshMillis();
+    
     if (mqttTopics && mqttManager.publish(mqttTopics->getDiagnosticsResponseTopic().c_str(), responseDoc)) {
         LOG_I(TAG, "Diagnostics response sent");
     }
 }
 
+void setupHistoryHandler() {
+    if (!mqttTopics) {
+        LOG_E(TAG, "Cannot setup history - topics not initialized");
+        return;
+    }
+    
+    if (mqttManager.subscribe(mqttTopics->getHistoryRequestTopic().c_str())) {
+        LOG_I(TAG, "History handler registered");
+    }
+}
+
+// Hele historikken (op til ca. 62 timer) som nedsamplet kurve; displayet viser kun de seneste 12 timer
+void handleHistoryRequest(const String& topic, const uint8_t* payload, unsigned int length) {
+    LOG_I(TAG, "History request received");
+    
+    // To arrays med HISTORY_CURVE_POINTS elementer à 16 bytes plus de faste felter
+    DynamicJsonDocument responseDoc(4096);
+    
+    responseDoc[MqttProtocol::HistoryFields::ANALYZER_ID] = settings.getAnalyzerId();
+    responseDoc[MqttProtocol::HistoryFields::EPOCH_TIME] = timeManager.getEpochTime();
+    JsonArray timestamps = responseDoc.createNestedArray(MqttProtocol::HistoryFields::TIMESTAMPS);
+    JsonArray rise = responseDoc.createNestedArray(MqttProtocol::HistoryFields::RISE);
+    
+    unsigned long bucketSeconds = historicalData.history.forEachBucketPeak(
+        MonitoringConstants::HISTORY_CURVE_POINTS, [&](const GrowthSample& point) {
+            timestamps.add(point.timestamp);
+            rise.add(point.growth);
+        });
+    responseDoc[MqttProtocol::HistoryFields::BUCKET_SECONDS] = bucketSeconds;
+    
+    if (mqttTopics && mqttManager.publish(mqttTopics->getHistoryResponseTopic().c_str(), responseDoc)) {
+        LOG_I(TAG, "History response sent, %u points", (unsigned)rise.size());
+    }
+}
+
 void setupOtaHandler() {
     if (!mqttTopics) {
         LOG_E(TAG, "Cannot setup OTA - topics not initialized");
         return;
     }
     
+#ifdef OTA_SIGNING_PUBLIC_KEY
+    // Sat fra .env af generate_settings.py; uden nøgle accepteres usignerede images
+    otaManager.setSigningKey(OTA_SIGNING_PUBLIC_KEY);
+#endif
     otaManager.begin();
     
     otaManager.setBatteryCheckCallback([]() {
         return batteryManager.isSafeForOta();
     });
     
-    otaManager.setStatusCallback(publishOtaStatus);
+    otaManager.setStatusCallback([](const String& status, uint8_t progress) {
+        // Den nye firmware kan have et andet RTC layout, så ventende punkter skal i journalen før genstart
+        if (status == MqttProtocol::OtaFields::StatusValues::COMPLETE) {
+            historyStore.flush();
+        }
+        publishOtaStatus(status, progress);
+    });
+    otaManager.setBackpressureCallback(publishOtaBackpressure);
+    otaManager.setResumeRequestCallback(publishOtaResumeRequest);
+    otaManager.setAckCallback(publishOtaAck);
     
     String otaStartTopic = mqttTopics->getOtaStartTopic();
     String otaChunkTopic = mqttTopics->getOtaChunkTopic();
@@ -531,6 +717,11 @@ void setupOtaHandler() {
     if (mqttManager.subscribe(otaChunkTopic.c_str())) {
         LOG_I(TAG, "Subscribed to OTA chunk topic");
     }
+    
+    // Et afbrudt image fra før genstarten: fortæl serveren hvor det kan fortsætte
+    if (!otaManager.isInProgress() && otaManager.hasCheckpoint()) {
+        otaManager.requestResume();
+    }
 }
 
 void handleOtaMessageWrapper(const String& topic, const uint8_t* payload, unsigned int length) {
@@ -561,4 +752,44 @@ void publishOtaStatus(const String& status, uint8_t progress) {
         mqttManager.publish(mqttTopics->getOtaStatusTopic().c_str(), statusDoc);
         lastPublish = now;
     }
-}
\ No newline at end of file
+}
+
+void publishOtaBackpressure(bool active, uint8_t queuedChunks) {
+    if (!mqttTopics || !mqttManager.isConnected()) return;
+    
+    // Status forbliver "downloading", så serveren stadig ser opdateringen som aktiv
+    DynamicJsonDocument statusDoc(128);
+    statusDoc[MqttProtocol::OtaFields::STATUS] = MqttProtocol::OtaFields::StatusValues::DOWNLOADING;
+    statusDoc[MqttProtocol::OtaFields::PROGRESS] = otaManager.getProgress();
+    statusDoc[MqttProtocol::OtaFields::BACKPRESSURE] = active;
+    statusDoc[MqttProtocol::OtaFields::QUEUED] = queuedChunks;
+    
+    mqttManager.publish(mqttTopics->getOtaStatusTopic().c_str(), statusDoc);
+}
+
+void publishOtaResumeRequest(const String& version, uint32_t nextChunk, uint32_t offset) {
+    if (!mqttTopics || !mqttManager.isConnected()) return;
+    
+    DynamicJsonDocument requestDoc(128);
+    requestDoc[MqttProtocol::OtaFields::VERSION] = version;
+    requestDoc[MqttProtocol::OtaFields::RESUME] = true;
+    requestDoc[MqttProtocol::OtaFields::NEXT_CHUNK] = nextChunk;
+    requestDoc[MqttProtocol::OtaFields::OFFSET] = offset;
+    
+    mqttManager.publish(mqttTopics->getOtaCheckTopic().c_str(), requestDoc);
+}
+
+void publishOtaAck(uint32_t nextChunk, uint32_t receivedMask, uint32_t window) {
+    if (!mqttTopics || !mqttManager.isConnected()) return;
+    
+    DynamicJsonDocument statusDoc(128);
+    statusDoc[MqttProtocol::OtaFields::STATUS] = MqttProtocol::OtaFields::StatusValues::DOWNLOADING;
+    statusDoc[MqttProtocol::OtaFields::PROGRESS] = otaManager.getProgress();
+    statusDoc[MqttProtocol::OtaFields::ACK] = nextChunk;
+    statusDoc[MqttProtocol::OtaFields::SACK] = receivedMask;
+    statusDoc[MqttProtocol::OtaFields::RECEIVE_WINDOW] = window;
+    
+    mqttManager.publish(mqttTopics->getOtaStatusTopic().c_str(), statusDoc);
+}
+
+#endif
@@ -9,7 +9,8 @@ static const char* TAG = "CaptivePortal";
 
 
 CaptivePortalManager::CaptivePortalManager()
-    : server(nullptr), dns(nullptr), portalRunning(false), apModeStartTime(0), apModeTimeoutEnabled(false) {}
+    : server(nullptr), dns(nullptr), portalRunning(false), apModeStartTime(0), apModeTimeoutEnabled(false),
+      connectPending(false), connectStartTime(0), stopPending(false), connectedTime(0) {}
 
 CaptivePortalManager::~CaptivePortalManager() {
     stopCustomPortal();
@@ -63,6 +64,8 @@ void CaptivePortalManager::stopCustomPortal() {
     WiFi.mode(WIFI_STA);
 
     portalRunning = false;
+    connectPending = false;
+    stopPending = false;
 }
 
 void CaptivePortalManager::loop() {
@@ -70,6 +73,15 @@ void CaptivePortalManager::loop() {
         dns->processNextRequest();
         server->handleClient();
     }
+
+    if (connectPending) {
+        checkPendingConnection();
+    }
+
+    // Portalen lever lidt efter forbindelsen, så siden kan nå at hente resultatet fra /status
+    if (stopPending && millis() - connectedTime >= TimeUtils::to_ms(TimeConstants::WIFI_STABILIZATION_DELAY)) {
+        stopCustomPortal();
+    }
 }
 
 void CaptivePortalManager::setupWebServer() {
@@ -144,63 +156,71 @@ void CaptivePortalManager::handleConnect() {
         WiFi.begin(ssid.c_str(), password.c_str());
     }
 
-    int timeout = NetworkConstants::WIFI_CONNECT_ATTEMPTS;
-    while (WiFi.status() != WL_CONNECTED && timeout > 0) {
-        TimeUtils::delay_for(TimeConstants::WIFI_RETRY_DELAY);
-        LOG_D(TAG, "Connecting...");
-        timeout--;
-    }
+    pendingSsid = ssid;
+    connectPending = true;
+    connectStartTime = millis();
+}
 
+void CaptivePortalManager::checkPendingConnection() {
     if (WiFi.status() == WL_CONNECTED) {
-        LOG_I(TAG, "Connected to WiFi!");
-        LOG_I(TAG, "IP address: %s", WiFi.localIP().toString().c_str());
-
-        WiFi.setHostname(NetworkConstants::HOSTNAME);
+        connectPending = false;
+        onConnectSucceeded();
+    } else if (millis() - connectStartTime >= TimeUtils::to_ms(TimeConstants::WIFI_PORTAL_CONNECT_TIMEOUT)) {
+        connectPending = false;
+        onConnectFailed();
+    }
+}
 
-        WiFi.setAutoReconnect(true);
+void CaptivePortalManager::onConnectSucceeded() {
+    LOG_I(TAG, "Connected to WiFi!");
+    LOG_I(TAG, "IP address: %s", WiFi.localIP().toString().c_str());
 
-        DynamicJsonDocument responseDoc(NetworkConstants::PORTAL_JSON_SIZE);
-        responseDoc["success"] = true;
-        responseDoc["ip"] = WiFi.localIP().toString();
-        responseDoc["message"] = "Forbundet til " + ssid + "! Du kan nu forlade opsætningssiden.";
-        responseDoc["disconnectAP"] = true;
+    WiFi.setHostname(NetworkConstants::HOSTNAME);
 
-        String jsonResponse;
-        serializeJson(responseDoc, jsonResponse);
+    WiFi.setAutoReconnect(true);
 
-        lastConnectionStatus = jsonResponse;
+    DynamicJsonDocument responseDoc(NetworkConstants::PORTAL_JSON_SIZE);
+    responseDoc["success"] = true;
+    responseDoc["ip"] = WiFi.localIP().toString();
+    responseDoc["message"] = "Forbundet til " + pendingSsid + "! Du kan nu forlade opsætningssiden.";
+    responseDoc["disconnectAP"] = true;
 
-        if (statusCallback) {
-            statusCallback(WIFI_CONNECTED);
-        }
+    String jsonResponse;
+    serializeJson(responseDoc, jsonResponse);
 
-        TimeUtils::delay_for(TimeConstants::WIFI_STABILIZATION_DELAY);
+    lastConnectionStatus = jsonResponse;
 
-        stopCustomPortal();
-    } else {
-        LOG_E(TAG, "Failed to connect to WiFi");
+    if (statusCallback) {
+        statusCallback(WIFI_CONNECTED);
+    }
 
-        switch (WiFi.status()) {
-            case WL_NO_SSID_AVAIL:
-                LOG_E(TAG, "Network not found");
-                break;
-            case WL_CONNECT_FAILED:
-                LOG_E(TAG, "Connection failed - check password");
-                break;
-            case WL_CONNECTION_LOST:
-                LOG_E(TAG, "Connection lost");
-                break;
-            case WL_DISCONNECTED:
-                LOG_E(TAG, "Disconnected");
-                break;
-            default:
-                LOG_E(TAG, "WiFi error code: %d", WiFi.status());
-        }
+    stopPending = true;
+    connectedTime = millis();
+}
 
-        WiFi.disconnect();
-        WiFi.mode(WIFI_AP);
-        WiFi.softAP(NetworkConstants::AP_NAME, NetworkConstants::AP_PASSWORD);
+void CaptivePortalManager::onConnectFailed() {
+    LOG_E(TAG, "Failed to connect to WiFi");
+
+    switch (WiFi.status()) {
+        case WL_NO_SSID_AVAIL:
+            LOG_E(TAG, "Network not found");
+            break;
+        case WL_CONNECT_FAILED:
+            LOG_E(TAG, "Connection failed - check password");
+            break;
+        case WL_CONNECTION_LOST:
+            LOG_E(TAG, "Connection lost");
+            break;
+        case WL_DISCONNECTED:
+            LOG_E(TAG, "Disconnected");
+            break;
+        default:
+            LOG_E(TAG, "WiFi error code: %d", WiFi.status());
     }
+
+    WiFi.disconnect();
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(NetworkConstants::AP_NAME, NetworkConstants::AP_PASSWORD);
 }
 
 void CaptivePortalManager::handleNotFound() {
@@ -0,0 +1,101 @@
+#include "network/crc32.h"
+
+#include <array>
+#include <cstring>
+
+#if CRC32_ROM_BACKEND
+    #include <esp_rom_crc.h>
+#endif
+
+namespace {
+    using Table = std::array<std::array<uint32_t, 256>, 8>;
+
+    constexpr Table makeTable() {
+        Table table = {};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) * Crc32::POLYNOMIAL);
+            }
+            table[0][i] = crc;
+        }
+        // table[k][i] er CRC'en af byte i efterfulgt af k nul-bytes
+        for (uint32_t i = 0; i < 256; i++) {
+            for (size_t k = 1; k < 8; k++) {
+                uint32_t previous = table[k - 1][i];
+                table[k][i] = (previous >> 8) ^ table[0][previous & 0xFF];
+            }
+        }
+        return table;
+    }
+
+    constexpr Table TABLE = makeTable();
+
+    static_assert(TABLE[0][1] == 0x77073096, "CRC32 table generation is broken");
+    static_assert(TABLE[0][255] == 0x2D02EF8D, "CRC32 table generation is broken");
+
+    inline uint32_t readLe32(const uint8_t* p) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap32(value);
+#endif
+        return value;
+    }
+}
+
+namespace Crc32 {
+    uint32_t update(uint32_t crc, const uint8_t* data, size_t length) {
+#if CRC32_ROM_BACKEND
+        return updateRom(crc, data, length);
+#else
+        return updateSliceBy8(crc, data, length);
+#endif
+    }
+
+    const char* backendName() {
+#if CRC32_ROM_BACKEND
+        return "rom";
+#else
+        return "slice-by-8";
+#endif
+    }
+
+    uint32_t updateSliceBy8(uint32_t crc, const uint8_t* data, size_t length) {
+        crc = ~crc;
+
+        while (length >= 8) {
+            uint32_t low = readLe32(data) ^ crc;
+            uint32_t high = readLe32(data + 4);
+            crc = TABLE[7][low & 0xFF] ^ TABLE[6][(low >> 8) & 0xFF] ^ TABLE[5][(low >> 16) & 0xFF] ^
+                  TABLE[4][low >> 24] ^ TABLE[3][high & 0xFF] ^ TABLE[2][(high >> 8) & 0xFF] ^
+                  TABLE[1][(high >> 16) & 0xFF] ^ TABLE[0][high >> 24];
+            data += 8;
+            length -= 8;
+        }
+
+        while (length--) {
+            crc = (crc >> 8) ^ TABLE[0][(crc ^ *data++) & 0xFF];
+        }
+
+        return ~crc;
+    }
+
+    uint32_t updateBitwise(uint32_t crc, const uint8_t* data, size_t length) {
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) * POLYNOMIAL);
+            }
+        }
+        return ~crc;
+    }
+
+#if CRC32_ROM_BACKEND
+    uint32_t updateRom(uint32_t crc, const uint8_t* data, size_t length) {
+        // ROM'ens crc32_le inverterer selv før og efter, så den kædes som de andre
+        return esp_rom_crc32_le(crc, data, length);
+    }
+#endif
+}
@@ -0,0 +1,245 @@
+#include "network/delta_patcher.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "network/crc32.h"
+
+namespace {
+    constexpr uint8_t MAGIC[4] = {'B', 'D', 'P', '1'};
+
+    inline uint32_t readLe32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+}
+
+DeltaPatcher::DeltaPatcher()
+    : state(State::HEADER)
+    , base(nullptr)
+    , baseSize(0)
+    , baseCrc32(0)
+    , field{}
+    , fieldLength(0)
+    , basePosition(0)
+    , diffRemaining(0)
+    , extraRemaining(0)
+    , seek(0)
+    , baseCache(nullptr)
+    , baseCacheOffset(0)
+    , baseCacheLength(0)
+    , output(nullptr)
+    , outputLength(0)
+    , outputBytes(0) {
+}
+
+DeltaPatcher::~DeltaPatcher() {
+    end();
+}
+
+bool DeltaPatcher::partitionCrc32(const esp_partition_t* partition, uint32_t size, uint32_t& crc) {
+    if (!partition || size > partition->size) {
+        return false;
+    }
+
+    uint8_t* buffer = static_cast<uint8_t*>(malloc(BASE_CACHE_SIZE));
+    if (!buffer) {
+        return false;
+    }
+
+    crc = 0;
+    bool readOk = true;
+    for (uint32_t offset = 0; offset < size && readOk; offset += BASE_CACHE_SIZE) {
+        uint32_t length = std::min<uint32_t>(BASE_CACHE_SIZE, size - offset);
+        readOk = esp_partition_read(partition, offset, buffer, length) == ESP_OK;
+        crc = Crc32::update(crc, buffer, length);
+    }
+    free(buffer);
+    return readOk;
+}
+
+bool DeltaPatcher::begin(const esp_partition_t* base, uint32_t baseSize, uint32_t baseCrc32) {
+    end();
+    if (!base || baseSize > base->size) {
+        return false;
+    }
+
+    baseCache = static_cast<uint8_t*>(malloc(BASE_CACHE_SIZE));
+    output = static_cast<uint8_t*>(malloc(OUTPUT_BLOCK_SIZE));
+    if (!baseCache || !output) {
+        end();
+        return false;
+    }
+
+    this->base = base;
+    this->baseSize = baseSize;
+    this->baseCrc32 = baseCrc32;
+    state = State::HEADER;
+    fieldLength = 0;
+    basePosition = 0;
+    diffRemaining = 0;
+    extraRemaining = 0;
+    seek = 0;
+    baseCacheOffset = 0;
+    baseCacheLength = 0;
+    outputLength = 0;
+    outputBytes = 0;
+    return true;
+}
+
+void DeltaPatcher::end() {
+    free(baseCache);
+    free(output);
+    baseCache = nullptr;
+    output = nullptr;
+    base = nullptr;
+}
+
+bool DeltaPatcher::write(const uint8_t* data, size_t length, const Sink& sink) {
+    if (!isActive()) {
+        return false;
+    }
+
+    size_t position = 0;
+    while (position < length) {
+        switch (state) {
+            case State::HEADER:
+            case State::RECORD: {
+                size_t fieldSize = state == State::HEADER ? HEADER_SIZE : RECORD_SIZE;
+                size_t count = std::min(fieldSize - fieldLength, length - position);
+                memcpy(field + fieldLength, data + position, count);
+                fieldLength += count;
+                position += count;
+                if (fieldLength < fieldSize) {
+                    break;
+                }
+                fieldLength = 0;
+                if (state == State::HEADER) {
+                    if (!parseHeader()) {
+                        state = State::FAILED;
+                        return false;
+                    }
+                    state = State::RECORD;
+                } else {
+                    parseRecord();
+                }
+                break;
+            }
+
+            case State::DIFF: {
+                size_t count = std::min<size_t>(diffRemaining, length - position);
+                for (size_t i = 0; i < count; i++) {
+                    uint8_t value;
+                    if (!baseByte(basePosition++, value)) {
+                        state = State::FAILED;
+                        return false;
+                    }
+                    if (!emit(static_cast<uint8_t>(value + data[position + i]), sink)) {
+                        state = State::FAILED;
+                        return false;
+                    }
+                }
+                position += count;
+                diffRemaining -= count;
+                if (diffRemaining == 0) {
+                    if (extraRemaining > 0) {
+                        state = State::EXTRA;
+                    } else {
+                        basePosition += seek;
+                        state = State::RECORD;
+                    }
+                }
+                break;
+            }
+
+            case State::EXTRA: {
+                size_t count = std::min<size_t>(extraRemaining, length - position);
+                for (size_t i = 0; i < count; i++) {
+                    if (!emit(data[position + i], sink)) {
+                        state = State::FAILED;
+                        return false;
+                    }
+                }
+                position += count;
+                extraRemaining -= count;
+                if (extraRemaining == 0) {
+                    basePosition += seek;
+                    state = State::RECORD;
+                }
+                break;
+            }
+
+            case State::FAILED:
+                return false;
+        }
+    }
+    return true;
+}
+
+bool DeltaPatcher::finish(const Sink& sink) {
+    // Patchen skal slutte præcis efter en hel record
+    if (!isActive() || state != State::RECORD || fieldLength != 0) {
+        return false;
+    }
+    if (outputLength > 0 && !sink(output, outputLength)) {
+        return false;
+    }
+    outputLength = 0;
+    return true;
+}
+
+bool DeltaPatcher::parseHeader() {
+    if (memcmp(field, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+    // field[4..8] er den nye størrelse; den kontrolleres af den der skriver outputtet
+    return readLe32(field + 8) == baseSize && readLe32(field + 12) == baseCrc32;
+}
+
+void DeltaPatcher::parseRecord() {
+    diffRemaining = readLe32(field);
+    extraRemaining = readLe32(field + 4);
+    seek = static_cast<int32_t>(readLe32(field + 8));
+
+    if (diffRemaining > 0) {
+        state = State::DIFF;
+    } else if (extraRemaining > 0) {
+        state = State::EXTRA;
+    } else {
+        basePosition += seek;
+        state = State::RECORD;
+    }
+}
+
+bool DeltaPatcher::baseByte(int64_t position, uint8_t& value) {
+    // Som bspatch: bytes uden for basen tæller som 0
+    if (position < 0 || position >= baseSize) {
+        value = 0;
+        return true;
+    }
+
+    uint32_t offset = static_cast<uint32_t>(position);
+    if (offset < baseCacheOffset || offset >= baseCacheOffset + baseCacheLength) {
+        baseCacheOffset = offset - offset % BASE_CACHE_SIZE;
+        baseCacheLength = std::min<uint32_t>(BASE_CACHE_SIZE, baseSize - baseCacheOffset);
+        if (esp_partition_read(base, baseCacheOffset, baseCache, baseCacheLength) != ESP_OK) {
+            baseCacheLength = 0;
+            return false;
+        }
+    }
+
+    value = baseCache[offset - baseCacheOffset];
+    return true;
+}
+
+bool DeltaPatcher::emit(uint8_t value, const Sink& sink) {
+    output[outputLength++] = value;
+    outputBytes++;
+
+    if (outputLength == OUTPUT_BLOCK_SIZE) {
+        outputLength = 0;
+        return sink(output, OUTPUT_BLOCK_SIZE);
+    }
+    return true;
+}
@@ -0,0 +1,506 @@
+#include "network/ed25519.h"
+
+#include <cstring>
+
+namespace {
+    // ---- SHA-512, kun til de korte input signaturen hasher ----
+
+    constexpr uint64_t SHA512_INITIAL_STATE[8] = {
+        0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+    };
+
+    constexpr uint64_t SHA512_ROUND_CONSTANTS[80] = {
+        0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+        0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+        0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+        0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+        0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+        0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+        0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+        0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+        0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+        0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+        0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+        0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+        0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+        0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+        0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+        0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+        0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+        0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+        0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+        0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+    };
+
+    class Sha512 {
+    public:
+        static constexpr size_t DIGEST_SIZE = 64;
+
+        Sha512() : totalLength(0), bufferLength(0) {
+            memcpy(state, SHA512_INITIAL_STATE, sizeof(state));
+        }
+
+        void update(const uint8_t* data, size_t length) {
+            totalLength += length;
+            while (length > 0) {
+                size_t count = length < BLOCK_SIZE - bufferLength ? length : BLOCK_SIZE - bufferLength;
+                memcpy(buffer + bufferLength, data, count);
+                bufferLength += count;
+                data += count;
+                length -= count;
+                if (bufferLength == BLOCK_SIZE) {
+                    compress();
+                    bufferLength = 0;
+                }
+            }
+        }
+
+        void finish(uint8_t digest[DIGEST_SIZE]) {
+            uint64_t bitLength = totalLength * 8;
+            buffer[bufferLength++] = 0x80;
+            if (bufferLength > BLOCK_SIZE - 16) {
+                memset(buffer + bufferLength, 0, BLOCK_SIZE - bufferLength);
+                compress();
+                bufferLength = 0;
+            }
+            memset(buffer + bufferLength, 0, BLOCK_SIZE - 8 - bufferLength);
+            writeBe64(buffer + BLOCK_SIZE - 8, bitLength);
+            compress();
+
+            for (int i = 0; i < 8; i++) {
+                writeBe64(digest + 8 * i, state[i]);
+            }
+        }
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 128;
+
+        uint64_t state[8];
+        uint64_t totalLength;
+        uint8_t buffer[BLOCK_SIZE];
+        size_t bufferLength;
+
+        static uint64_t rotr(uint64_t value, int bits) {
+            return (value >> bits) | (value << (64 - bits));
+        }
+
+        static uint64_t readBe64(const uint8_t* p) {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; i++) {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        static void writeBe64(uint8_t* p, uint64_t value) {
+            for (int i = 7; i >= 0; i--) {
+                p[i] = static_cast<uint8_t>(value);
+                value >>= 8;
+            }
+        }
+
+        void compress() {
+            uint64_t w[80];
+            for (int i = 0; i < 16; i++) {
+                w[i] = readBe64(buffer + 8 * i);
+            }
+            for (int i = 16; i < 80; i++) {
+                uint64_t s0 = rotr(w[i - 15], 1) ^ rotr(w[i - 15], 8) ^ (w[i - 15] >> 7);
+                uint64_t s1 = rotr(w[i - 2], 19) ^ rotr(w[i - 2], 61) ^ (w[i - 2] >> 6);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint64_t v[8];
+            memcpy(v, state, sizeof(v));
+            for (int i = 0; i < 80; i++) {
+                uint64_t s1 = rotr(v[4], 14) ^ rotr(v[4], 18) ^ rotr(v[4], 41);
+                uint64_t choose = (v[4] & v[5]) ^ (~v[4] & v[6]);
+                uint64_t t1 = v[7] + s1 + choose + SHA512_ROUND_CONSTANTS[i] + w[i];
+                uint64_t s0 = rotr(v[0], 28) ^ rotr(v[0], 34) ^ rotr(v[0], 39);
+                uint64_t majority = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+                memmove(v + 1, v, 7 * sizeof(uint64_t));
+                v[4] += t1;
+                v[0] = t1 + s0 + majority;
+            }
+            for (int i = 0; i < 8; i++) {
+                state[i] += v[i];
+            }
+        }
+    };
+
+    // ---- Feltaritmetik modulo 2^255 - 19: 16 limbs a 16 bit i int64, som TweetNaCl ----
+
+    using Field = int64_t[16];
+
+    constexpr Field FIELD_ZERO = {0};
+    constexpr Field FIELD_ONE = {1};
+    constexpr Field CURVE_D = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070,
+                               0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203};
+    constexpr Field CURVE_D2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0,
+                                0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406};
+    constexpr Field BASE_X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c,
+                              0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169};
+    constexpr Field BASE_Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666,
+                              0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666};
+    constexpr Field SQRT_MINUS_ONE = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43,
+                                      0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+
+    // Gruppens orden L = 2^252 + 27742317777372353535851937790883648493, little endian
+    constexpr uint8_t ORDER[32] = {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7,
+                                   0xa2, 0xde, 0xf9, 0xde, 0x14, 0,    0,    0,    0,    0,    0,
+                                   0,    0,    0,    0,    0,    0,    0,    0,    0,    0x10};
+
+    void copy(Field out, const Field in) {
+        memcpy(out, in, sizeof(Field));
+    }
+
+    void carry(Field o) {
+        for (int i = 0; i < 16; i++) {
+            o[i] += 1LL << 16;
+            int64_t c = o[i] >> 16;
+            if (i < 15) {
+                o[i + 1] += c - 1;
+            } else {
+                o[0] += 38 * (c - 1);
+            }
+            o[i] -= c * 65536;
+        }
+    }
+
+    // Bytter p og q hvis bit er 1, uden at forgrene på hemmelige data
+    void select(Field p, Field q, int bit) {
+        int64_t mask = ~(static_cast<int64_t>(bit) - 1);
+        for (int i = 0; i < 16; i++) {
+            int64_t t = mask & (p[i] ^ q[i]);
+            p[i] ^= t;
+            q[i] ^= t;
+        }
+    }
+
+    void pack(uint8_t out[32], const Field n) {
+        Field m, t;
+        copy(t, n);
+        carry(t);
+        carry(t);
+        carry(t);
+        for (int j = 0; j < 2; j++) {
+            m[0] = t[0] - 0xffed;
+            for (int i = 1; i < 15; i++) {
+                m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+                m[i - 1] &= 0xffff;
+            }
+            m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+            int borrow = static_cast<int>((m[15] >> 16) & 1);
+            m[14] &= 0xffff;
+            select(t, m, 1 - borrow);
+        }
+        for (int i = 0; i < 16; i++) {
+            out[2 * i] = static_cast<uint8_t>(t[i] & 0xff);
+            out[2 * i + 1] = static_cast<uint8_t>(t[i] >> 8);
+        }
+    }
+
+    void unpack(Field out, const uint8_t in[32]) {
+        for (int i = 0; i < 16; i++) {
+            out[i] = in[2 * i] + (static_cast<int64_t>(in[2 * i + 1]) << 8);
+        }
+        out[15] &= 0x7fff;
+    }
+
+    bool equal(const Field a, const Field b) {
+        uint8_t packedA[32], packedB[32];
+        pack(packedA, a);
+        pack(packedB, b);
+        return memcmp(packedA, packedB, 32) == 0;
+    }
+
+    int parity(const Field a) {
+        uint8_t packed[32];
+        pack(packed, a);
+        return packed[0] & 1;
+    }
+
+    void add(Field o, const Field a, const Field b) {
+        for (int i = 0; i < 16; i++) o[i] = a[i] + b[i];
+    }
+
+    void subtract(Field o, const Field a, const Field b) {
+        for (int i = 0; i < 16; i++) o[i] = a[i] - b[i];
+    }
+
+    void multiply(Field o, const Field a, const Field b) {
+        int64_t t[31] = {0};
+        for (int i = 0; i < 16; i++) {
+            for (int j = 0; j < 16; j++) {
+                t[i + j] += a[i] * b[j];
+            }
+        }
+        // 2^256 = 38 mod p
+        for (int i = 0; i < 15; i++) {
+            t[i] += 38 * t[i + 16];
+        }
+        for (int i = 0; i < 16; i++) o[i] = t[i];
+        carry(o);
+        carry(o);
+    }
+
+    void square(Field o, const Field a) {
+        multiply(o, a, a);
+    }
+
+    // a^(p-2)
+    void invert(Field o, const Field in) {
+        Field c;
+        copy(c, in);
+        for (int a = 253; a >= 0; a--) {
+            square(c, c);
+            if (a != 2 && a != 4) multiply(c, c, in);
+        }
+        copy(o, c);
+    }
+
+    // a^((p-5)/8), bruges til kvadratroden ved udpakning af punkter
+    void pow2523(Field o, const Field in) {
+        Field c;
+        copy(c, in);
+        for (int a = 250; a >= 0; a--) {
+            square(c, c);
+            if (a != 1) multiply(c, c, in);
+        }
+        copy(o, c);
+    }
+
+    // ---- Punkter i udvidede koordinater (X, Y, Z, T) ----
+
+    using Point = Field[4];
+
+    void pointAdd(Point p, const Point q) {
+        Field a, b, c, d, t, e, f, g, h;
+        subtract(a, p[1], p[0]);
+        subtract(t, q[1], q[0]);
+        multiply(a, a, t);
+        add(b, p[0], p[1]);
+        add(t, q[0], q[1]);
+        multiply(b, b, t);
+        multiply(c, p[3], q[3]);
+        multiply(c, c, CURVE_D2);
+        multiply(d, p[2], q[2]);
+        add(d, d, d);
+        subtract(e, b, a);
+        subtract(f, d, c);
+        add(g, d, c);
+        add(h, b, a);
+
+        multiply(p[0], e, f);
+        multiply(p[1], h, g);
+        multiply(p[2], g, f);
+        multiply(p[3], e, h);
+    }
+
+    void pointSelect(Point p, Point q, int bit) {
+        for (int i = 0; i < 4; i++) {
+            select(p[i], q[i], bit);
+        }
+    }
+
+    void pointPack(uint8_t out[32], Point p) {
+        Field tx, ty, zi;
+        invert(zi, p[2]);
+        multiply(tx, p[0], zi);
+        multiply(ty, p[1], zi);
+        pack(out, ty);
+        out[31] ^= static_cast<uint8_t>(parity(tx) << 7);
+    }
+
+    // Montgomery ladder med konstant tid; q ødelægges
+    void scalarMultiply(Point p, Point q, const uint8_t scalar[32]) {
+        copy(p[0], FIELD_ZERO);
+        copy(p[1], FIELD_ONE);
+        copy(p[2], FIELD_ONE);
+        copy(p[3], FIELD_ZERO);
+        for (int i = 255; i >= 0; i--) {
+            int bit = (scalar[i / 8] >> (i & 7)) & 1;
+            pointSelect(p, q, bit);
+            pointAdd(q, p);
+            pointAdd(p, p);
+            pointSelect(p, q, bit);
+        }
+    }
+
+    void scalarMultiplyBase(Point p, const uint8_t scalar[32]) {
+        Point q;
+        copy(q[0], BASE_X);
+        copy(q[1], BASE_Y);
+        copy(q[2], FIELD_ONE);
+        multiply(q[3], BASE_X, BASE_Y);
+        scalarMultiply(p, q, scalar);
+    }
+
+    // Udpakker -A, så verify kan regne [s]B + [h](-A) med én addition
+    bool unpackNegated(Point r, const uint8_t in[32]) {
+        Field t, check, num, den, den2, den4, den6;
+        copy(r[2], FIELD_ONE);
+        unpack(r[1], in);
+        square(num, r[1]);
+        multiply(den, num, CURVE_D);
+        subtract(num, num, r[2]);
+        add(den, r[2], den);
+
+        square(den2, den);
+        square(den4, den2);
+        multiply(den6, den4, den2);
+        multiply(t, den6, num);
+        multiply(t, t, den);
+
+        pow2523(t, t);
+        multiply(t, t, num);
+        multiply(t, t, den);
+        multiply(t, t, den);
+        multiply(r[0], t, den);
+
+        square(check, r[0]);
+        multiply(check, check, den);
+        if (!equal(check, num)) multiply(r[0], r[0], SQRT_MINUS_ONE);
+
+        square(check, r[0]);
+        multiply(check, check, den);
+        if (!equal(check, num)) return false;
+
+        if (parity(r[0]) == (in[31] >> 7)) subtract(r[0], FIELD_ZERO, r[0]);
+
+        multiply(r[3], r[0], r[1]);
+        return true;
+    }
+
+    // ---- Skalarer modulo L ----
+
+    void reduceModOrder(uint8_t out[32], int64_t x[64]) {
+        for (int i = 63; i >= 32; i--) {
+            int64_t c = 0;
+            int j;
+            for (j = i - 32; j < i - 12; j++) {
+                x[j] += c - 16 * x[i] * ORDER[j - (i - 32)];
+                c = (x[j] + 128) >> 8;
+                x[j] -= c * 256;
+            }
+            x[j] += c;
+            x[i] = 0;
+        }
+
+        int64_t c = 0;
+        for (int j = 0; j < 32; j++) {
+            x[j] += c - (x[31] >> 4) * ORDER[j];
+            c = x[j] >> 8;
+            x[j] &= 255;
+        }
+        for (int j = 0; j < 32; j++) {
+            x[j] -= c * ORDER[j];
+        }
+        for (int i = 0; i < 32; i++) {
+            x[i + 1] += x[i] >> 8;
+            out[i] = static_cast<uint8_t>(x[i] & 255);
+        }
+    }
+
+    // Reducerer et 64 byte hash til en skalar på de første 32 bytes
+    void reduceHash(uint8_t hash[64]) {
+        int64_t x[64];
+        for (int i = 0; i < 64; i++) {
+            x[i] = hash[i];
+            hash[i] = 0;
+        }
+        reduceModOrder(hash, x);
+    }
+
+    // RFC 8032 kræver s < L, ellers kan en gyldig signatur omskrives til en anden
+    bool scalarIsCanonical(const uint8_t s[32]) {
+        for (int i = 31; i >= 0; i--) {
+            if (s[i] != ORDER[i]) {
+                return s[i] < ORDER[i];
+            }
+        }
+        return false;
+    }
+
+    void hashParts(uint8_t digest[64], const uint8_t* a, size_t aLength, const uint8_t* b, size_t bLength,
+                   const uint8_t* message, size_t length) {
+        Sha512 sha;
+        sha.update(a, aLength);
+        sha.update(b, bLength);
+        sha.update(message, length);
+        sha.finish(digest);
+    }
+
+    void expandSeed(const uint8_t seed[32], uint8_t expanded[64]) {
+        Sha512 sha;
+        sha.update(seed, 32);
+        sha.finish(expanded);
+        expanded[0] &= 248;
+        expanded[31] &= 127;
+        expanded[31] |= 64;
+    }
+}
+
+namespace Ed25519 {
+    bool verify(const uint8_t signature[SIGNATURE_SIZE], const uint8_t* message, size_t length,
+                const uint8_t publicKey[PUBLIC_KEY_SIZE]) {
+        Point p, q;
+        if (!scalarIsCanonical(signature + 32) || !unpackNegated(q, publicKey)) {
+            return false;
+        }
+
+        uint8_t h[64];
+        hashParts(h, signature, 32, publicKey, PUBLIC_KEY_SIZE, message, length);
+        reduceHash(h);
+
+        // R' = [s]B - [h]A skal give signaturens R
+        scalarMultiply(p, q, h);
+        scalarMultiplyBase(q, signature + 32);
+        pointAdd(p, q);
+
+        uint8_t r[32];
+        pointPack(r, p);
+        return memcmp(r, signature, 32) == 0;
+    }
+
+    void derivePublicKey(const uint8_t seed[SEED_SIZE], uint8_t publicKey[PUBLIC_KEY_SIZE]) {
+        uint8_t expanded[64];
+        expandSeed(seed, expanded);
+        Point p;
+        scalarMultiplyBase(p, expanded);
+        pointPack(publicKey, p);
+    }
+
+    void sign(const uint8_t seed[SEED_SIZE], const uint8_t* message, size_t length,
+              uint8_t signature[SIGNATURE_SIZE]) {
+        uint8_t expanded[64];
+        uint8_t publicKey[PUBLIC_KEY_SIZE];
+        expandSeed(seed, expanded);
+        derivePublicKey(seed, publicKey);
+
+        // r = H(prefix || M), R = [r]B
+        uint8_t r[64];
+        hashParts(r, expanded + 32, 32, nullptr, 0, message, length);
+        reduceHash(r);
+        Point p;
+        scalarMultiplyBase(p, r);
+        pointPack(signature, p);
+
+        // s = r + H(R || A || M) * a mod L
+        uint8_t h[64];
+        hashParts(h, signature, 32, publicKey, PUBLIC_KEY_SIZE, message, length);
+        reduceHash(h);
+
+        int64_t x[64] = {0};
+        for (int i = 0; i < 32; i++) {
+            x[i] = r[i];
+        }
+        for (int i = 0; i < 32; i++) {
+            for (int j = 0; j < 32; j++) {
+                x[i + j] += static_cast<int64_t>(h[i]) * expanded[j];
+            }
+        }
+        reduceModOrder(signature + 32, x);
+    }
+}
@@ -0,0 +1,159 @@
+#include "network/heatshrink_decoder.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    // Formatets grænser (heatshrink_common.h)
+    constexpr uint8_t MIN_WINDOW_BITS = 4;
+    constexpr uint8_t MAX_WINDOW_BITS = 15;
+    constexpr uint8_t MIN_LOOKAHEAD_BITS = 3;
+}
+
+HeatshrinkDecoder::HeatshrinkDecoder()
+    : state(State::TAG_BIT)
+    , windowBits(0)
+    , lookaheadBits(0)
+    , window(nullptr)
+    , windowMask(0)
+    , head(0)
+    , output(nullptr)
+    , outputLength(0)
+    , outputBytes(0)
+    , bitBuffer(0)
+    , bitCount(0)
+    , input(nullptr)
+    , inputLength(0)
+    , backrefOffset(0)
+    , backrefCount(0) {
+}
+
+HeatshrinkDecoder::~HeatshrinkDecoder() {
+    end();
+}
+
+bool HeatshrinkDecoder::validParameters(uint8_t windowBits, uint8_t lookaheadBits) {
+    return windowBits >= MIN_WINDOW_BITS && windowBits <= MAX_WINDOW_BITS &&
+           lookaheadBits >= MIN_LOOKAHEAD_BITS && lookaheadBits < windowBits;
+}
+
+bool HeatshrinkDecoder::begin(uint8_t windowBits, uint8_t lookaheadBits) {
+    end();
+    if (!validParameters(windowBits, lookaheadBits)) {
+        return false;
+    }
+
+    uint32_t windowSize = 1UL << windowBits;
+    window = static_cast<uint8_t*>(malloc(windowSize));
+    output = static_cast<uint8_t*>(malloc(OUTPUT_BLOCK_SIZE));
+    if (!window || !output) {
+        end();
+        return false;
+    }
+
+    // Encoderen starter med et nulstillet vindue, så referencer før starten giver 0
+    memset(window, 0, windowSize);
+    this->windowBits = windowBits;
+    this->lookaheadBits = lookaheadBits;
+    windowMask = windowSize - 1;
+    head = 0;
+    state = State::TAG_BIT;
+    outputLength = 0;
+    outputBytes = 0;
+    bitBuffer = 0;
+    bitCount = 0;
+    return true;
+}
+
+void HeatshrinkDecoder::end() {
+    free(window);
+    free(output);
+    window = nullptr;
+    output = nullptr;
+    input = nullptr;
+    inputLength = 0;
+}
+
+bool HeatshrinkDecoder::decode(const uint8_t* data, size_t length, const Sink& sink) {
+    if (!isActive()) {
+        return false;
+    }
+
+    input = data;
+    inputLength = length;
+    uint32_t value;
+
+    // Hver tilstand læser alle sine bits på én gang eller venter på mere input
+    while (true) {
+        switch (state) {
+            case State::TAG_BIT:
+                if (!getBits(1, value)) return true;
+                state = value ? State::LITERAL : State::BACKREF_INDEX;
+                break;
+
+            case State::LITERAL:
+                if (!getBits(8, value)) return true;
+                state = State::TAG_BIT;
+                if (!emit(static_cast<uint8_t>(value), sink)) return false;
+                break;
+
+            case State::BACKREF_INDEX:
+                if (!getBits(windowBits, value)) return true;
+                backrefOffset = value + 1;
+                state = State::BACKREF_COUNT;
+                break;
+
+            case State::BACKREF_COUNT:
+                if (!getBits(lookaheadBits, value)) return true;
+                backrefCount = value + 1;
+                state = State::BACKREF_COPY;
+                break;
+
+            case State::BACKREF_COPY:
+                while (backrefCount > 0) {
+                    backrefCount--;
+                    if (!emit(window[(head - backrefOffset) & windowMask], sink)) return false;
+                }
+                state = State::TAG_BIT;
+                break;
+        }
+    }
+}
+
+bool HeatshrinkDecoder::finish(const Sink& sink) {
+    if (!isActive()) {
+        return false;
+    }
+    if (outputLength > 0 && !sink(output, outputLength)) {
+        return false;
+    }
+    outputLength = 0;
+    return true;
+}
+
+bool HeatshrinkDecoder::getBits(uint8_t count, uint32_t& value) {
+    while (bitCount < count) {
+        if (inputLength == 0) {
+            return false;
+        }
+        bitBuffer = (bitBuffer << 8) | *input++;
+        inputLength--;
+        bitCount += 8;
+    }
+
+    bitCount -= count;
+    value = (bitBuffer >> bitCount) & ((1UL << count) - 1);
+    return true;
+}
+
+bool HeatshrinkDecoder::emit(uint8_t value, const Sink& sink) {
+    window[head++ & windowMask] = value;
+    output[outputLength++] = value;
+    outputBytes++;
+
+    if (outputLength == OUTPUT_BLOCK_SIZE) {
+        outputLength = 0;
+        return sink(output, OUTPUT_BLOCK_SIZE);
+    }
+    return true;
+}
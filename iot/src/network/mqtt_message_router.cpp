@@ -8,6 +8,7 @@ const char* MqttMessageRouter::TAG = "MqttRouter";
 MqttMessageRouter::MqttMessageRouter() 
     : mqttTopics(nullptr)
     , diagnosticsHandler(nullptr)
+    , historyHandler(nullptr)
     , otaHandler(nullptr)
     , messageCount(0)
     , lastMessageTime(0) {
@@ -34,6 +35,10 @@ void MqttMessageRouter::routeMessage(char* topic, byte* payload, unsigned int le
         if (diagnosticsHandler) {
             diagnosticsHandler(topicStr, payload, length);
         }
+    } else if (topicStr == mqttTopics->getHistoryRequestTopic()) {
+        if (historyHandler) {
+            historyHandler(topicStr, payload, length);
+        }
     } else if (topicStr == mqttTopics->getOtaStartTopic() || 
                topicStr == mqttTopics->getOtaChunkTopic()) {
         if (otaHandler) {
@@ -73,4 +73,28 @@ bool NtfyManager::isInCooldown() const {
         return false; 
     }
     return (millis() - _lastNotificationTime) < TimeUtils::to_ms(TimeConstants::NOTIFICATION_COOLDOWN);
-}
\ No newline at end of file
+}
+
+void NtfyManager::resume(const RetainedState& state) {
+    _lastRiseValue = state.lastRiseValue;
+    _consecutiveDecreases = state.consecutiveDecreases;
+    _decreaseNotificationSent = state.decreaseNotificationSent;
+    _lastNotificationTime = 0;
+    if (state.cooldownRemainingMs > 0) {
+        // Som om notifikationen blev sendt så længe siden at den resterende cooldown passer; 0 betyder aldrig
+        unsigned long elapsed = TimeUtils::to_ms(TimeConstants::NOTIFICATION_COOLDOWN) - state.cooldownRemainingMs;
+        _lastNotificationTime = max(millis() - elapsed, 1UL);
+    }
+}
+
+void NtfyManager::retain(RetainedState& state, unsigned long sleepMs) const {
+    state.lastRiseValue = _lastRiseValue;
+    state.consecutiveDecreases = _consecutiveDecreases;
+    state.decreaseNotificationSent = _decreaseNotificationSent;
+    state.cooldownRemainingMs = 0;
+    if (isInCooldown()) {
+        unsigned long elapsed = millis() - _lastNotificationTime;
+        unsigned long remaining = TimeUtils::to_ms(TimeConstants::NOTIFICATION_COOLDOWN) - elapsed;
+        state.cooldownRemainingMs = remaining > sleepMs ? remaining - sleepMs : 0;
+    }
+}
@@ -1,10 +1,31 @@
 #include "network/ota_manager.h"
 #include <ArduinoJson.h>
+#include "network/crc32.h"
 #include "network/mqtt_protocol.h"
 #include "config/constants.h"
 
 const char* OtaManager::TAG = "OtaManager";
 
+static_assert(OtaConstants::RECEIVE_WINDOW_CHUNKS <= 32, "SACK bitmap holds at most 32 chunks");
+
+namespace {
+    bool parseHex(const char* hex, uint8_t* out, size_t length) {
+        if (!hex || strlen(hex) != length * 2) {
+            return false;
+        }
+        for (size_t i = 0; i < length * 2; i++) {
+            char c = hex[i];
+            uint8_t nibble;
+            if (c >= '0' && c <= '9') nibble = c - '0';
+            else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+            else return false;
+            out[i / 2] = (i % 2 == 0) ? nibble << 4 : out[i / 2] | nibble;
+        }
+        return true;
+    }
+}
+
 OtaManager::OtaManager() 
     : status(OtaStatus::IDLE)
     , inProgress(false)
@@ -12,19 +33,68 @@ OtaManager::OtaManager()
     , updatePartition(nullptr)
     , totalBytes(0)
     , receivedBytes(0)
+    , imageSize(0)
     , expectedCrc32(0)
     , calculatedCrc32(0)
+    , checkpoint{}
+    , checkpointValid(false)
+    , offsetWrites(false)
+    , chunksSinceCheckpoint(0)
+    , chunkPool(nullptr)
+    , freeSlots(nullptr)
+    , filledSlots(nullptr)
+    , writerDone(nullptr)
+    , writerTask(nullptr)
+    , writerError(ESP_OK)
+    , writtenBytes(0)
+    , signature{}
+    , signaturePresent(false)
+    , signingKey{}
+    , signingKeySet(false)
+    , reorderPool(nullptr)
+    , reorderSlots(0)
+    , duplicateChunks(0)
+    , chunksSinceAck(0)
     , batteryCheck(nullptr)
-    , statusCallback(nullptr) {
+    , statusCallback(nullptr)
+    , backpressureCallback(nullptr)
+    , resumeRequestCallback(nullptr)
+    , ackCallback(nullptr) {
 }
 
 bool OtaManager::begin() {
-    LOG_I(TAG, "OTA Manager initialized");
+    LOG_I(TAG, "OTA Manager initialized (CRC32 backend: %s, SHA-256 backend: %s)", Crc32::backendName(),
+          Sha256::backendName());
+    if (!signingKeySet) {
+        LOG_W(TAG, "No OTA signing key - images are only checked with CRC32");
+    }
+
+    // Kaldes igen ved MQTT reconnect; under en opdatering ejer writeren checkpointet
+    if (!inProgress) {
+        loadCheckpoint();
+        if (checkpointValid) {
+            LOG_I(TAG, "Interrupted OTA found - Version: %s, %d/%d bytes written", checkpoint.version,
+                  checkpoint.bytesWritten, checkpoint.size);
+        }
+    }
     return true;
 }
 
+bool OtaManager::setSigningKey(const char* publicKeyHex) {
+    signingKeySet = parseHex(publicKeyHex, signingKey, sizeof(signingKey));
+    if (!signingKeySet) {
+        LOG_E(TAG, "Invalid OTA signing key");
+    }
+    return signingKeySet;
+}
+
 bool OtaManager::startUpdate(const OtaInfo& info) {
     if (inProgress) {
+        // Afsenderen er startet forfra på samme image, fx efter et reconnect: fortsæt hvor vi er
+        if (info.version == version && info.size == totalBytes && info.crc32 == expectedCrc32) {
+            LOG_I(TAG, "Update %s already in progress - continuing at %d bytes", version.c_str(), receivedBytes);
+            return true;
+        }
         LOG_W(TAG, "Update already in progress");
         return false;
     }
@@ -37,6 +107,26 @@ bool OtaManager::startUpdate(const OtaInfo& info) {
     LOG_I(TAG, "Starting OTA update - Version: %s, Size: %d bytes, CRC32: 0x%08X", 
           info.version.c_str(), info.size, info.crc32);
     
+    if (info.compressed) {
+        LOG_I(TAG, "Compressed image (heatshrink w%d l%d), %d bytes unpacked", info.windowBits, info.lookaheadBits,
+              info.imageSize);
+        if (!HeatshrinkDecoder::validParameters(info.windowBits, info.lookaheadBits) ||
+            info.windowBits > OtaConstants::HEATSHRINK_MAX_WINDOW_BITS) {
+            LOG_E(TAG, "Unsupported compression parameters");
+            return false;
+        }
+    }
+    
+    signaturePresent = info.signature.length() > 0;
+    if (signaturePresent && !parseHex(info.signature.c_str(), signature, sizeof(signature))) {
+        LOG_E(TAG, "Malformed OTA signature");
+        return false;
+    }
+    if (signingKeySet && !signaturePresent) {
+        LOG_E(TAG, "Unsigned OTA image rejected");
+        return false;
+    }
+    
     updatePartition = esp_ota_get_next_update_partition(nullptr);
     if (!updatePartition) {
         LOG_E(TAG, "No OTA partition available");
@@ -46,24 +136,93 @@ bool OtaManager::startUpdate(const OtaInfo& info) {
     LOG_I(TAG, "Target partition: %s, size: %d bytes", 
           updatePartition->label, updatePartition->size);
     
-    if (info.size > updatePartition->size) {
-        LOG_E(TAG, "Firmware too large: %d > %d", info.size, updatePartition->size);
+    if (info.imageSize > updatePartition->size) {
+        LOG_E(TAG, "Firmware too large: %d > %d", info.imageSize, updatePartition->size);
+        return false;
+    }
+    
+    if (info.delta && !prepareDelta(info)) {
         return false;
     }
     
+    // Dekoderens og patchens tilstand overlever ikke en genstart, så kun rå images kan genoptages fra flash.
+    // verifyCheckpoint læser alligevel det skrevne igen og fører det samtidig gennem hashen.
+    imageHash.begin();
+    bool resume = !info.compressed && !info.delta && matchesCheckpoint(info, updatePartition) &&
+                  verifyCheckpoint(updatePartition);
+    if (checkpointValid && !resume) {
+        LOG_W(TAG, "Discarding OTA checkpoint for version %s", checkpoint.version);
+        clearCheckpoint();
+    }
+    if (!resume) {
+        imageHash.begin();
+    }
+    
     esp_err_t err = esp_ota_begin(updatePartition, OTA_WITH_SEQUENTIAL_WRITES, &otaHandle);
     if (err != ESP_OK) {
         LOG_E(TAG, "Failed to begin OTA: %s", esp_err_to_name(err));
+        patcher.end();
         return false;
     }
     
-    status = OtaStatus::DOWNLOADING;
-    inProgress = true;
+    if (resume) {
+        // Checkpoints ligger på en chunk grænse, og chunks er sektorstore, så resten kan slettes direkte
+        uint32_t eraseEnd = (info.size + OtaConstants::FLASH_SECTOR_SIZE - 1) / OtaConstants::FLASH_SECTOR_SIZE *
+                            OtaConstants::FLASH_SECTOR_SIZE;
+        err = esp_partition_erase_range(updatePartition, checkpoint.bytesWritten, eraseEnd - checkpoint.bytesWritten);
+        if (err != ESP_OK) {
+            LOG_E(TAG, "Failed to erase partition tail: %s", esp_err_to_name(err));
+            esp_ota_abort(otaHandle);
+            otaHandle = 0;
+            clearCheckpoint();
+            return false;
+        }
+        LOG_I(TAG, "Resuming OTA update at %d/%d bytes", checkpoint.bytesWritten, info.size);
+    } else {
+        snprintf(checkpoint.version, sizeof(checkpoint.version), "%s", info.version.c_str());
+        snprintf(checkpoint.partition, sizeof(checkpoint.partition), "%s", updatePartition->label);
+        checkpoint.size = info.size;
+        checkpoint.expectedCrc32 = info.crc32;
+        checkpoint.crc32 = 0;
+        checkpoint.bytesWritten = 0;
+        checkpoint.lastChunkIndex = 0;
+    }
+    
+    if (info.compressed && !decoder.begin(info.windowBits, info.lookaheadBits)) {
+        LOG_E(TAG, "Not enough memory for decompression window");
+        patcher.end();
+        esp_ota_abort(otaHandle);
+        otaHandle = 0;
+        return false;
+    }
+    
+    version = info.version;
     totalBytes = info.size;
+    imageSize = info.imageSize;
     expectedCrc32 = info.crc32;
-    receivedBytes = 0;
-    calculatedCrc32 = 0;
+    receivedBytes = resume ? checkpoint.bytesWritten : 0;
+    calculatedCrc32 = resume ? checkpoint.crc32 : 0;
+    writtenBytes = receivedBytes;
+    offsetWrites = resume;
+    chunksSinceCheckpoint = 0;
+    writerError = ESP_OK;
+    reorderSlots = 0;
+    duplicateChunks = 0;
+    chunksSinceAck = 0;
+
+    if (!startWriter()) {
+        LOG_E(TAG, "Failed to start flash writer");
+        decoder.end();
+        patcher.end();
+        esp_ota_abort(otaHandle);
+        otaHandle = 0;
+        return false;
+    }
+    
+    status = OtaStatus::DOWNLOADING;
+    inProgress = true;
     lastChunkTime = std::chrono::steady_clock::now();
+    lastAck = lastChunkTime;
     
     LOG_I(TAG, "OTA update started successfully");
     return true;
@@ -77,29 +236,52 @@ bool OtaManager::processChunk(const uint8_t* data, size_t length, uint32_t chunk
     }
     
     auto now = std::chrono::steady_clock::now();
-    auto timeSinceLastChunk = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastChunkTime);
     
-    if (timeSinceLastChunk > TimeConstants::OTA_CHUNK_TIMEOUT) {
-        abort("Chunk timeout");
-        return false;
+    uint32_t expectedIndex = getNextChunkIndex();
+    if (chunkIndex < expectedIndex || isBuffered(chunkIndex)) {
+        // Allerede modtaget, fx en gentagelse efter en genoptagelse eller et reconnect
+        LOG_D(TAG, "Ignoring duplicate chunk %d", chunkIndex);
+        duplicateChunks++;
+        return true;
     }
     
-    if (length != chunkSize) {
+    // Alle chunks undtagen den sidste er fulde, ellers passer chunk index og offset ikke sammen
+    uint32_t expectedLength = expectedChunkLength(chunkIndex);
+    if (expectedLength == 0 || length != chunkSize || length != expectedLength) {
         abort("Chunk size mismatch");
         return false;
     }
     
-    calculatedCrc32 = updateCrc32(calculatedCrc32, data, length);
+    if (chunkIndex >= expectedIndex + OtaConstants::RECEIVE_WINDOW_CHUNKS) {
+        // Uden for vinduet: afsenderen er for langt foran, bed den fortsætte fra hullet
+        LOG_W(TAG, "Chunk %d outside receive window - expected %d", chunkIndex, expectedIndex);
+        if (now - lastResumeRequest > TimeConstants::OTA_RESUME_REQUEST_MIN_GAP) {
+            requestResume();
+        }
+        return true;
+    }
     
-    esp_err_t err = esp_ota_write(otaHandle, data, length);
-    if (err != ESP_OK) {
-        LOG_E(TAG, "esp_ota_write failed: %s (0x%x)", esp_err_to_name(err), err);
-        abort("Write failed: " + String(esp_err_to_name(err)));
+    auto timeSinceLastChunk = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastChunkTime);
+    if (timeSinceLastChunk > TimeConstants::OTA_CHUNK_TIMEOUT) {
+        LOG_W(TAG, "Transfer continued after %lu ms pause", static_cast<unsigned long>(timeSinceLastChunk.count()));
+    }
+    lastChunkTime = now;
+    
+    if (chunkIndex > expectedIndex) {
+        // Gemmes til hullet er lukket; kvitteringen fortæller afsenderen hvad der mangler
+        LOG_D(TAG, "Buffering chunk %d - waiting for %d", chunkIndex, expectedIndex);
+        bufferChunk(data, length, chunkIndex);
+        sendAck();
+        return true;
+    }
+    
+    if (!queueChunk(data, length, chunkIndex) || !drainBuffered()) {
         return false;
     }
     
-    receivedBytes += length;
-    lastChunkTime = now;
+    if (++chunksSinceAck >= OtaConstants::SACK_INTERVAL_CHUNKS && receivedBytes < totalBytes) {
+        sendAck();
+    }
     
     if (chunkIndex % OtaConstants::CHUNK_LOG_INTERVAL == 0 || receivedBytes >= totalBytes) {
         LOG_I(TAG, "OTA Progress: %d/%d bytes (%d%%)", 
@@ -111,7 +293,19 @@ bool OtaManager::processChunk(const uint8_t* data, size_t length, uint32_t chunk
     }
     
     if (receivedBytes >= totalBytes) {
-        LOG_I(TAG, "All bytes received! Starting completion process...");
+        LOG_I(TAG, "All bytes received! Waiting for flash writer...");
+        if (!stopWriter()) {
+            abort("Flash writer did not finish");
+            return false;
+        }
+        esp_err_t err = writerError;
+        if (err != ESP_OK) {
+            abort("Write failed: " + String(esp_err_to_name(err)));
+            return false;
+        }
+        if (!finishImage()) {
+            return false;
+        }
         completeUpdate();
     }
     
@@ -133,6 +327,11 @@ void OtaManager::completeUpdate() {
         return;
     }
     
+    if (!verifySignature()) {
+        abort("Signature verification failed");
+        return;
+    }
+    
     LOG_I(TAG, "CRC32 verified, finalizing update...");
     
     esp_err_t err = esp_ota_end(otaHandle);
@@ -147,6 +346,7 @@ void OtaManager::completeUpdate() {
         return;
     }
     
+    clearCheckpoint();
     status = OtaStatus::COMPLETE;
     inProgress = false;
     
@@ -161,14 +361,29 @@ void OtaManager::completeUpdate() {
     ESP.restart();
 }
 
-void OtaManager::abort(const String& reason) {
+void OtaManager::abort(const String& reason, bool keepCheckpoint) {
     LOG_E(TAG, "Aborting OTA: %s", reason.c_str());
     
+    // Writeren skal være stoppet før partitionen lukkes under den
+    stopWriter();
+    
     if (otaHandle != 0) {
         esp_ota_abort(otaHandle);
         otaHandle = 0;
     }
     
+    decoder.end();
+    patcher.end();
+    
+    if (keepCheckpoint) {
+        loadCheckpoint();
+        if (checkpointValid) {
+            LOG_I(TAG, "Keeping checkpoint at %d bytes for resume", checkpoint.bytesWritten);
+        }
+    } else {
+        clearCheckpoint();
+    }
+    
     status = OtaStatus::ERROR;
     inProgress = false;
     updatePartition = nullptr;
@@ -176,29 +391,430 @@ void OtaManager::abort(const String& reason) {
     receivedBytes = 0;
 }
 
-uint8_t OtaManager::getProgress() const {
-    if (totalBytes == 0) return 0;
-    return (receivedBytes * 100) / totalBytes;
+bool OtaManager::startWriter() {
+    chunkPool = static_cast<uint8_t*>(malloc(OtaConstants::WRITE_BUFFER_COUNT * OtaConstants::MAX_CHUNK_SIZE));
+    reorderPool = static_cast<uint8_t*>(malloc(OtaConstants::RECEIVE_WINDOW_CHUNKS * OtaConstants::MAX_CHUNK_SIZE));
+    freeSlots = xQueueCreate(OtaConstants::WRITE_BUFFER_COUNT, sizeof(uint8_t));
+    // Plads til alle buffere plus stop markøren
+    filledSlots = xQueueCreate(OtaConstants::WRITE_BUFFER_COUNT + 1, sizeof(uint8_t));
+    writerDone = xSemaphoreCreateBinary();
+
+    if (!chunkPool || !reorderPool || !freeSlots || !filledSlots || !writerDone) {
+        LOG_E(TAG, "Not enough memory for %d chunk buffers",
+              OtaConstants::WRITE_BUFFER_COUNT + OtaConstants::RECEIVE_WINDOW_CHUNKS);
+        stopWriter();
+        return false;
+    }
+
+    for (uint8_t slot = 0; slot < OtaConstants::WRITE_BUFFER_COUNT; slot++) {
+        xQueueSend(freeSlots, &slot, 0);
+    }
+
+    if (xTaskCreatePinnedToCore(writerTaskEntry, "ota_writer", OtaConstants::WRITER_TASK_STACK_SIZE, this,
+                                OtaConstants::WRITER_TASK_PRIORITY, &writerTask,
+                                OtaConstants::WRITER_TASK_CORE) != pdPASS) {
+        writerTask = nullptr;
+        stopWriter();
+        return false;
+    }
+
+    LOG_D(TAG, "Flash writer started with %d x %d byte buffers", OtaConstants::WRITE_BUFFER_COUNT,
+          OtaConstants::MAX_CHUNK_SIZE);
+    return true;
+}
+
+bool OtaManager::stopWriter() {
+    // Vinduet bruges kun af modtageren og kan altid frigives
+    free(reorderPool);
+    reorderPool = nullptr;
+    reorderSlots = 0;
+    
+    if (writerTask) {
+        uint8_t stop = STOP_SLOT;
+        xQueueSend(filledSlots, &stop, portMAX_DELAY);
+        if (xSemaphoreTake(writerDone, pdMS_TO_TICKS(TimeUtils::to_ms(TimeConstants::OTA_WRITER_STOP_TIMEOUT))) !=
+            pdTRUE) {
+            // Writeren bruger stadig bufferne; hellere lække dem end at frigive dem under den
+            LOG_E(TAG, "Flash writer did not stop in time");
+            writerTask = nullptr;
+            chunkPool = nullptr;
+            freeSlots = filledSlots = writerDone = nullptr;
+            return false;
+        }
+        writerTask = nullptr;
+    }
+
+    if (freeSlots) vQueueDelete(freeSlots);
+    if (filledSlots) vQueueDelete(filledSlots);
+    if (writerDone) vSemaphoreDelete(writerDone);
+    free(chunkPool);
+    freeSlots = filledSlots = writerDone = nullptr;
+    chunkPool = nullptr;
+    return true;
 }
 
-uint32_t OtaManager::updateCrc32(uint32_t crc, const uint8_t* data, size_t length) {
-    static const uint32_t polynomial = 0xEDB88320;
-    crc = ~crc;
+bool OtaManager::waitForSlot(uint8_t& slot) {
+    // Alle buffere venter på flash: bed afsenderen om at sætte tempoet ned, og vent på writeren
+    LOG_W(TAG, "Flash writer busy - %d chunks queued", getQueuedChunks());
+    if (backpressureCallback) {
+        backpressureCallback(true, getQueuedChunks());
+    }
+
+    TickType_t timeout = pdMS_TO_TICKS(TimeUtils::to_ms(TimeConstants::OTA_WRITER_BACKPRESSURE_TIMEOUT));
+    if (xQueueReceive(freeSlots, &slot, timeout) != pdTRUE) {
+        return false;
+    }
+
+    if (backpressureCallback) {
+        backpressureCallback(false, getQueuedChunks());
+    }
+    return true;
+}
+
+bool OtaManager::queueChunk(const uint8_t* data, uint32_t length, uint32_t chunkIndex) {
+    esp_err_t err = writerError;
+    if (err != ESP_OK) {
+        abort("Write failed: " + String(esp_err_to_name(err)));
+        return false;
+    }
     
-    for (size_t i = 0; i < length; i++) {
-        crc ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            crc = (crc >> 1) ^ ((crc & 1) * polynomial);
+    uint8_t slot;
+    if (xQueueReceive(freeSlots, &slot, 0) != pdTRUE) {
+        // data ligger normalt i PubSubClient's buffer, som publish i waitForSlot skriver oven i. Flyt chunken
+        // til dens plads i modtagevinduet først; pladsen for den næste forventede chunk er altid ledig
+        uint32_t position = chunkIndex % OtaConstants::RECEIVE_WINDOW_CHUNKS;
+        uint8_t* staged = reorderPool + position * OtaConstants::MAX_CHUNK_SIZE;
+        if (data != staged) {
+            memcpy(staged, data, length);
+            data = staged;
+        }
+        if (!waitForSlot(slot)) {
+            abort("Flash writer stalled");
+            return false;
+        }
+    }
+    
+    memcpy(chunkPool + slot * OtaConstants::MAX_CHUNK_SIZE, data, length);
+    slotLength[slot] = length;
+    slotOffset[slot] = receivedBytes;
+    slotChunkIndex[slot] = chunkIndex;
+    xQueueSend(filledSlots, &slot, portMAX_DELAY);
+    
+    receivedBytes += length;
+    return true;
+}
+
+uint32_t OtaManager::expectedChunkLength(uint32_t chunkIndex) const {
+    uint64_t offset = static_cast<uint64_t>(chunkIndex) * OtaConstants::MAX_CHUNK_SIZE;
+    if (offset >= totalBytes) {
+        return 0;
+    }
+    return std::min<uint32_t>(OtaConstants::MAX_CHUNK_SIZE, totalBytes - static_cast<uint32_t>(offset));
+}
+
+bool OtaManager::isBuffered(uint32_t chunkIndex) const {
+    uint32_t position = chunkIndex % OtaConstants::RECEIVE_WINDOW_CHUNKS;
+    return (reorderSlots & (1u << position)) && reorderIndex[position] == chunkIndex;
+}
+
+void OtaManager::bufferChunk(const uint8_t* data, uint32_t length, uint32_t chunkIndex) {
+    // Vinduet er kun RECEIVE_WINDOW_CHUNKS bredt, så to ventende chunks deler aldrig plads
+    uint32_t position = chunkIndex % OtaConstants::RECEIVE_WINDOW_CHUNKS;
+    memcpy(reorderPool + position * OtaConstants::MAX_CHUNK_SIZE, data, length);
+    reorderIndex[position] = chunkIndex;
+    reorderLength[position] = length;
+    reorderSlots |= 1u << position;
+}
+
+bool OtaManager::drainBuffered() {
+    // Send de ventende chunks videre til writeren så længe de ligger i forlængelse af hinanden
+    while (receivedBytes < totalBytes && isBuffered(getNextChunkIndex())) {
+        uint32_t chunkIndex = getNextChunkIndex();
+        uint32_t position = chunkIndex % OtaConstants::RECEIVE_WINDOW_CHUNKS;
+        reorderSlots &= ~(1u << position);
+        if (!queueChunk(reorderPool + position * OtaConstants::MAX_CHUNK_SIZE, reorderLength[position], chunkIndex)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t OtaManager::getReceivedMask() const {
+    uint32_t nextChunk = getNextChunkIndex();
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i + 1 < OtaConstants::RECEIVE_WINDOW_CHUNKS; i++) {
+        if (isBuffered(nextChunk + 1 + i)) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+uint8_t OtaManager::getBufferedChunks() const {
+    return static_cast<uint8_t>(__builtin_popcount(reorderSlots));
+}
+
+void OtaManager::sendAck() {
+    chunksSinceAck = 0;
+    lastAck = std::chrono::steady_clock::now();
+    if (ackCallback) {
+        ackCallback(getNextChunkIndex(), getReceivedMask(), OtaConstants::RECEIVE_WINDOW_CHUNKS);
+    }
+}
+
+void OtaManager::writerTaskEntry(void* param) {
+    static_cast<OtaManager*>(param)->writerLoop();
+    vTaskDelete(nullptr);
+}
+
+void OtaManager::writerLoop() {
+    uint8_t slot;
+
+    while (xQueueReceive(filledSlots, &slot, portMAX_DELAY) == pdTRUE && slot != STOP_SLOT) {
+        // Efter en fejl tømmes køen blot, så modtageren ikke blokerer; den ser fejlen ved næste chunk
+        if (writerError == ESP_OK) {
+            const uint8_t* data = chunkPool + slot * OtaConstants::MAX_CHUNK_SIZE;
+            uint32_t length = slotLength[slot];
+
+            if (decoder.isActive() || patcher.isActive()) {
+                // Udpakkede blokke skrives sekventielt efterhånden som dekoderen og patchen fylder dem
+                bool unpacked = decoder.isActive()
+                                    ? decoder.decode(data, length,
+                                                     [this](const uint8_t* block, size_t blockLength) {
+                                                         return writeUnpacked(block, blockLength);
+                                                     })
+                                    : writeUnpacked(data, length);
+                if (!unpacked && writerError == ESP_OK) {
+                    LOG_E(TAG, "Invalid OTA stream");
+                    writerError = ESP_FAIL;
+                }
+            } else if (writeImage(data, length, slotOffset[slot]) &&
+                       ++chunksSinceCheckpoint >= OtaConstants::CHECKPOINT_INTERVAL_CHUNKS) {
+                chunksSinceCheckpoint = 0;
+                saveCheckpoint(slotChunkIndex[slot]);
+            }
         }
+
+        xQueueSend(freeSlots, &slot, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(writerDone);
+}
+
+void OtaManager::loop() {
+    if (!inProgress || status != OtaStatus::DOWNLOADING) {
+        return;
+    }
+    
+    // Ingen chunks i et stykke tid: afsenderen har måske mistet beskeder eller forbindelsen
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastChunkTime > TimeConstants::OTA_RESUME_REQUEST_INTERVAL &&
+        now - lastResumeRequest > TimeConstants::OTA_RESUME_REQUEST_INTERVAL) {
+        requestResume();
+        return;
     }
     
-    return ~crc;
+    // Løbende kvittering, så afsenderen kan genudsende tabte chunks uden at vente på en timeout
+    if (now - lastAck > TimeConstants::OTA_SACK_INTERVAL) {
+        sendAck();
+    }
+}
+
+bool OtaManager::requestResume() {
+    String requestVersion;
+    uint32_t offset;
+    
+    if (inProgress) {
+        requestVersion = version;
+        offset = receivedBytes;
+    } else if (checkpointValid) {
+        requestVersion = checkpoint.version;
+        offset = checkpoint.bytesWritten;
+    } else {
+        return false;
+    }
+    
+    if (!resumeRequestCallback) {
+        return false;
+    }
+    
+    uint32_t nextChunk = offset / OtaConstants::MAX_CHUNK_SIZE;
+    LOG_I(TAG, "Requesting OTA resume - Version: %s, next chunk: %d", requestVersion.c_str(), nextChunk);
+    lastResumeRequest = std::chrono::steady_clock::now();
+    resumeRequestCallback(requestVersion, nextChunk, offset);
+    return true;
+}
+
+bool OtaManager::prepareDelta(const OtaInfo& info) {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    LOG_I(TAG, "Delta update from base %s (%d bytes, CRC32: 0x%08X)", info.baseVersion.c_str(), info.baseSize,
+          info.baseCrc32);
+    
+    // Patchen er kun gyldig mod præcis den firmware den er lavet ud fra
+    uint32_t crc;
+    if (!DeltaPatcher::partitionCrc32(running, info.baseSize, crc) || crc != info.baseCrc32) {
+        LOG_E(TAG, "Delta base does not match running firmware on %s", running ? running->label : "?");
+        return false;
+    }
+    
+    if (!patcher.begin(running, info.baseSize, info.baseCrc32)) {
+        LOG_E(TAG, "Not enough memory for delta patching");
+        return false;
+    }
+    return true;
+}
+
+bool OtaManager::matchesCheckpoint(const OtaInfo& info, const esp_partition_t* partition) const {
+    return checkpointValid && info.version == checkpoint.version && info.size == checkpoint.size &&
+           info.crc32 == checkpoint.expectedCrc32 && strcmp(partition->label, checkpoint.partition) == 0 &&
+           checkpoint.bytesWritten < info.size && checkpoint.bytesWritten % OtaConstants::MAX_CHUNK_SIZE == 0;
+}
+
+bool OtaManager::verifyCheckpoint(const esp_partition_t* partition) {
+    // Flash indholdet skal stadig give checkpointets CRC, ellers startes forfra
+    uint8_t* buffer = static_cast<uint8_t*>(malloc(OtaConstants::FLASH_SECTOR_SIZE));
+    if (!buffer) {
+        return false;
+    }
+    
+    uint32_t crc = 0;
+    bool readOk = true;
+    for (uint32_t offset = 0; offset < checkpoint.bytesWritten && readOk; offset += OtaConstants::FLASH_SECTOR_SIZE) {
+        uint32_t length = std::min(OtaConstants::FLASH_SECTOR_SIZE, checkpoint.bytesWritten - offset);
+        readOk = esp_partition_read(partition, offset, buffer, length) == ESP_OK;
+        crc = Crc32::update(crc, buffer, length);
+        imageHash.update(buffer, length);
+    }
+    free(buffer);
+    
+    if (!readOk || crc != checkpoint.crc32) {
+        LOG_W(TAG, "OTA checkpoint does not match flash contents");
+        return false;
+    }
+    return true;
+}
+
+void OtaManager::loadCheckpoint() {
+    preferences.begin(OtaConstants::PREFERENCES_NAMESPACE, false);
+    checkpointValid = preferences.getBytesLength(OtaConstants::PREF_KEY_CHECKPOINT) == sizeof(checkpoint) &&
+                      preferences.getBytes(OtaConstants::PREF_KEY_CHECKPOINT, &checkpoint, sizeof(checkpoint)) ==
+                          sizeof(checkpoint);
+    preferences.end();
+    
+    checkpoint.version[sizeof(checkpoint.version) - 1] = '\0';
+    checkpoint.partition[sizeof(checkpoint.partition) - 1] = '\0';
+}
+
+void OtaManager::saveCheckpoint(uint32_t chunkIndex) {
+    // Kaldes fra writer tasken lige efter en chunk er skrevet
+    checkpoint.crc32 = calculatedCrc32;
+    checkpoint.bytesWritten = writtenBytes;
+    checkpoint.lastChunkIndex = chunkIndex;
+    
+    preferences.begin(OtaConstants::PREFERENCES_NAMESPACE, false);
+    if (preferences.putBytes(OtaConstants::PREF_KEY_CHECKPOINT, &checkpoint, sizeof(checkpoint)) != sizeof(checkpoint)) {
+        LOG_W(TAG, "Failed to save OTA checkpoint");
+    }
+    preferences.end();
+}
+
+void OtaManager::clearCheckpoint() {
+    preferences.begin(OtaConstants::PREFERENCES_NAMESPACE, false);
+    preferences.remove(OtaConstants::PREF_KEY_CHECKPOINT);
+    preferences.end();
+    checkpointValid = false;
+}
+
+bool OtaManager::writeImage(const uint8_t* data, size_t length, uint32_t offset) {
+    if (writtenBytes + length > imageSize) {
+        LOG_E(TAG, "Image larger than announced %d bytes", imageSize);
+        writerError = ESP_ERR_INVALID_SIZE;
+        return false;
+    }
+    
+    calculatedCrc32 = Crc32::update(calculatedCrc32, data, length);
+    imageHash.update(data, length);
+    
+    esp_err_t err = offsetWrites ? esp_ota_write_with_offset(otaHandle, data, length, offset)
+                                 : esp_ota_write(otaHandle, data, length);
+    if (err != ESP_OK) {
+        LOG_E(TAG, "esp_ota_write failed: %s (0x%x)", esp_err_to_name(err), err);
+        writerError = err;
+        return false;
+    }
+    
+    writtenBytes += length;
+    return true;
+}
+
+bool OtaManager::writeUnpacked(const uint8_t* data, size_t length) {
+    if (!patcher.isActive()) {
+        return writeImage(data, length, writtenBytes);
+    }
+    return patcher.write(data, length, [this](const uint8_t* block, size_t blockLength) {
+        return writeImage(block, blockLength, writtenBytes);
+    });
+}
+
+bool OtaManager::finishImage() {
+    // Writeren er stoppet; resten af dekoderens og patchens output skrives herfra
+    bool flushed = true;
+    if (decoder.isActive()) {
+        flushed = decoder.finish([this](const uint8_t* block, size_t blockLength) {
+            return writeUnpacked(block, blockLength);
+        });
+        decoder.end();
+    }
+    if (patcher.isActive()) {
+        flushed = flushed && patcher.finish([this](const uint8_t* block, size_t blockLength) {
+            return writeImage(block, blockLength, writtenBytes);
+        });
+        patcher.end();
+    }
+    if (!flushed) {
+        abort("Failed to unpack image");
+        return false;
+    }
+    
+    if (writtenBytes != imageSize) {
+        abort("Image size mismatch: expected " + String(imageSize) + ", got " + String(writtenBytes.load()));
+        return false;
+    }
+    return true;
+}
+
+bool OtaManager::verifySignature() {
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    imageHash.finish(digest);
+    
+    if (!signaturePresent) {
+        return !signingKeySet;
+    }
+    if (!signingKeySet) {
+        LOG_W(TAG, "Image is signed but no signing key is configured - signature not checked");
+        return true;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    bool valid = Ed25519::verify(signature, digest, sizeof(digest), signingKey);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_I(TAG, "Ed25519 signature %s (%lu ms)", valid ? "valid" : "INVALID", static_cast<unsigned long>(elapsed.count()));
+    return valid;
+}
+
+uint8_t OtaManager::getQueuedChunks() const {
+    return filledSlots ? uxQueueMessagesWaiting(filledSlots) : 0;
+}
+
+uint8_t OtaManager::getProgress() const {
+    if (totalBytes == 0) return 0;
+    return (receivedBytes * 100) / totalBytes;
 }
 
 bool OtaManager::handleOtaMessage(const String& topic, const uint8_t* payload, unsigned int length, 
                                   const String& otaStartTopic, const String& otaChunkTopic) {
     if (topic == otaStartTopic) {
-        DynamicJsonDocument doc(256);
+        DynamicJsonDocument doc(512);  // Delta felter og en 128 tegns signatur
         DeserializationError error = deserializeJson(doc, payload, length);
         
         if (error) {
@@ -211,8 +827,36 @@ bool OtaManager::handleOtaMessage(const String& topic, const uint8_t* payload, u
         info.size = doc[MqttProtocol::OtaFields::SIZE];
         info.crc32 = doc[MqttProtocol::OtaFields::CRC32];
         
-        if (startUpdate(info)) {
+        String compression = doc[MqttProtocol::OtaFields::COMPRESSION] | MqttProtocol::OtaFields::CompressionValues::NONE;
+        info.compressed = compression == MqttProtocol::OtaFields::CompressionValues::HEATSHRINK;
+        info.imageSize = doc[MqttProtocol::OtaFields::IMAGE_SIZE] | info.size;
+        info.windowBits = doc[MqttProtocol::OtaFields::WINDOW_BITS] | 0;
+        info.lookaheadBits = doc[MqttProtocol::OtaFields::LOOKAHEAD_BITS] | 0;
+        
+        String patch = doc[MqttProtocol::OtaFields::PATCH] | MqttProtocol::OtaFields::PatchValues::NONE;
+        info.delta = patch == MqttProtocol::OtaFields::PatchValues::BSDIFF;
+        info.baseVersion = doc[MqttProtocol::OtaFields::BASE_VERSION] | "";
+        info.baseSize = doc[MqttProtocol::OtaFields::BASE_SIZE] | 0;
+        info.baseCrc32 = doc[MqttProtocol::OtaFields::BASE_CRC32] | 0;
+        info.signature = doc[MqttProtocol::OtaFields::SIGNATURE] | "";
+        
+        if ((!info.compressed && compression != MqttProtocol::OtaFields::CompressionValues::NONE) ||
+            (!info.delta && patch != MqttProtocol::OtaFields::PatchValues::NONE)) {
+            LOG_E(TAG, "Unsupported OTA encoding: %s/%s", compression.c_str(), patch.c_str());
             if (statusCallback) {
+                statusCallback(MqttProtocol::OtaFields::StatusValues::ERROR, 0);
+            }
+            return false;
+        }
+        
+        if (startUpdate(info)) {
+            if (receivedBytes > 0) {
+                // Genoptaget: afsenderen skal springe det over vi allerede har
+                if (statusCallback) {
+                    statusCallback(MqttProtocol::OtaFields::StatusValues::DOWNLOADING, getProgress());
+                }
+                requestResume();
+            } else if (statusCallback) {
                 statusCallback(MqttProtocol::OtaFields::StatusValues::STARTED, 0);
             }
             return true;
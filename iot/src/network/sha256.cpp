@@ -0,0 +1,190 @@
+#include "network/sha256.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if SHA256_MBEDTLS_BACKEND
+    #include <mbedtls/version.h>
+    // mbedtls 2.x (ESP-IDF 4) har kun de returnerende varianter under _ret navnene
+    #if MBEDTLS_VERSION_NUMBER < 0x03000000
+        #define mbedtls_sha256_starts mbedtls_sha256_starts_ret
+        #define mbedtls_sha256_update mbedtls_sha256_update_ret
+        #define mbedtls_sha256_finish mbedtls_sha256_finish_ret
+    #endif
+#endif
+
+#if !SHA256_MBEDTLS_BACKEND
+namespace {
+    constexpr uint32_t INITIAL_STATE[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    constexpr uint32_t ROUND_CONSTANTS[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    inline uint32_t rotr(uint32_t value, int bits) {
+        return (value >> bits) | (value << (32 - bits));
+    }
+
+    inline uint32_t readBe32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    inline void writeBe32(uint8_t* p, uint32_t value) {
+        p[0] = static_cast<uint8_t>(value >> 24);
+        p[1] = static_cast<uint8_t>(value >> 16);
+        p[2] = static_cast<uint8_t>(value >> 8);
+        p[3] = static_cast<uint8_t>(value);
+    }
+}
+#endif
+
+Sha256::Sha256() {
+#if SHA256_MBEDTLS_BACKEND
+    mbedtls_sha256_init(&context);
+#endif
+    begin();
+}
+
+Sha256::~Sha256() {
+#if SHA256_MBEDTLS_BACKEND
+    mbedtls_sha256_free(&context);
+#endif
+}
+
+void Sha256::hash(const uint8_t* data, size_t length, uint8_t digest[DIGEST_SIZE]) {
+    Sha256 sha;
+    sha.update(data, length);
+    sha.finish(digest);
+}
+
+const char* Sha256::backendName() {
+#if SHA256_MBEDTLS_BACKEND
+    return "mbedtls";
+#else
+    return "software";
+#endif
+}
+
+#if SHA256_MBEDTLS_BACKEND
+
+void Sha256::begin() {
+    mbedtls_sha256_starts(&context, 0);
+}
+
+void Sha256::update(const uint8_t* data, size_t length) {
+    mbedtls_sha256_update(&context, data, length);
+}
+
+void Sha256::finish(uint8_t digest[DIGEST_SIZE]) {
+    mbedtls_sha256_finish(&context, digest);
+    begin();
+}
+
+#else
+
+void Sha256::begin() {
+    memcpy(state, INITIAL_STATE, sizeof(state));
+    totalLength = 0;
+    bufferLength = 0;
+}
+
+void Sha256::update(const uint8_t* data, size_t length) {
+    totalLength += length;
+
+    if (bufferLength > 0) {
+        size_t count = std::min(BLOCK_SIZE - bufferLength, length);
+        memcpy(buffer + bufferLength, data, count);
+        bufferLength += count;
+        data += count;
+        length -= count;
+        if (bufferLength < BLOCK_SIZE) {
+            return;
+        }
+        compress(buffer);
+        bufferLength = 0;
+    }
+
+    // Hele blokke hashes direkte fra input uden at kopiere
+    while (length >= BLOCK_SIZE) {
+        compress(data);
+        data += BLOCK_SIZE;
+        length -= BLOCK_SIZE;
+    }
+
+    memcpy(buffer, data, length);
+    bufferLength = length;
+}
+
+void Sha256::finish(uint8_t digest[DIGEST_SIZE]) {
+    uint64_t bitLength = totalLength * 8;
+
+    buffer[bufferLength++] = 0x80;
+    if (bufferLength > BLOCK_SIZE - 8) {
+        memset(buffer + bufferLength, 0, BLOCK_SIZE - bufferLength);
+        compress(buffer);
+        bufferLength = 0;
+    }
+    memset(buffer + bufferLength, 0, BLOCK_SIZE - 8 - bufferLength);
+    writeBe32(buffer + BLOCK_SIZE - 8, static_cast<uint32_t>(bitLength >> 32));
+    writeBe32(buffer + BLOCK_SIZE - 4, static_cast<uint32_t>(bitLength));
+    compress(buffer);
+
+    for (int i = 0; i < 8; i++) {
+        writeBe32(digest + 4 * i, state[i]);
+    }
+    begin();
+}
+
+void Sha256::compress(const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = readBe32(block + 4 * i);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        uint32_t choose = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + choose + ROUND_CONSTANTS[i] + w[i];
+        uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+#endif
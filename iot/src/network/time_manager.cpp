@@ -8,8 +8,8 @@ TimeManager::TimeManager() :
     _timeInitialized(false),
     _timeZone("CET-1CEST,M3.5.0,M10.5.0/3"),
     _ntpServer("pool.ntp.org"),
-    _lastSyncMillis(0),
-    _syncInterval(TimeUtils::to_ms(TimeConstants::NTP_SYNC_INTERVAL)),
+    _lastSyncEpoch(0),
+    _syncInterval(TimeUtils::to_seconds(TimeConstants::NTP_SYNC_INTERVAL)),
     _lastRetryAttempt(0) {
 }
 
@@ -23,7 +23,7 @@ bool TimeManager::begin(const char* timeZone, const char* ntpServer) {
 }
 
 void TimeManager::loop() {
-    if (_timeInitialized && ((unsigned long)(millis() - _lastSyncMillis) > _syncInterval)) {
+    if (_timeInitialized && time(nullptr) - _lastSyncEpoch > static_cast<time_t>(_syncInterval)) {
         LOG_I(TAG, "Performing periodic NTP sync");
         syncWithNTP();
     }
@@ -98,7 +98,7 @@ bool TimeManager::syncWithNTP() {
     
     if (isTimeValid()) {
         _timeInitialized = true;
-        _lastSyncMillis = millis();
+        _lastSyncEpoch = time(nullptr);
         LOG_I(TAG, "NTP sync successful. Local time: %s", getLocalTimeString().c_str());
         return true;
     }
@@ -121,6 +121,17 @@ void TimeManager::adjustAfterSleep(unsigned long sleepTimeMs) {
     }
 }
 
+void TimeManager::resume(const RetainedState& state) {
+    setTimeZone(_timeZone.c_str());
+    _timeInitialized = state.initialized && isTimeValid();
+    _lastSyncEpoch = state.lastSyncEpoch;
+}
+
+void TimeManager::retain(RetainedState& state) const {
+    state.initialized = _timeInitialized;
+    state.lastSyncEpoch = _lastSyncEpoch;
+}
+
 bool TimeManager::trySync() {
     if (!isTimeValid()) {
         LOG_W(TAG, "Time not valid, attempting sync");
@@ -1,10 +1,12 @@
 #include "network/wifi_manager.h"
 
 #include <Arduino.h>
+#include <esp_attr.h>
 
 #include "config/constants.h"
 #include "config/time_utils.h"
 #include "logging/logger.h"
+#include "util/retained.h"
 
 static const char* TAG = "WiFiManager";
 
@@ -12,54 +14,48 @@ static const char* TAG = "WiFiManager";
 
 TaskHandle_t blinkTaskHandle = NULL;
 
+namespace {
+    constexpr uint32_t LEASE_MAGIC = 0x42424C31; // "BBL1"
+
+    // Access point og adresser fra sidste forbindelse. Med dem springes scanning og DHCP over ved næste opvågning
+    struct WifiLease {
+        uint8_t bssid[6];
+        int32_t channel;
+        uint32_t localIp;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+        uint32_t reuses;
+    };
+
+    RTC_NOINIT_ATTR Retained<WifiLease, LEASE_MAGIC> lease;
+}
+
 WifiManager::WifiManager()
-    : currentStatus(WIFI_DISCONNECTED), connectStartTime(0), previousMillis(0), ledState(LOW), lastWiFiCheck(0),
-      apModeStartTime(0), apModeTimeoutEnabled(true), apModeTimeoutOccurred(false) {}
+    : currentStatus(WIFI_DISCONNECTED), phase(PHASE_IDLE), connectStartTime(0), previousMillis(0), ledState(LOW),
+      gotIpEvent(false), disconnectedEvent(false), disconnectReason(0), eventsRegistered(false), apModeStartTime(0),
+      apModeTimeoutEnabled(true), apModeTimeoutOccurred(false) {}
 
 void WifiManager::begin() {
     currentStatus = WIFI_CONNECTING;
     ledState = LOW;
-    connectStartTime = millis();
 
     createBlinkTask();
 
+    if (!eventsRegistered) {
+        WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { this->onWiFiEvent(event, info); });
+        eventsRegistered = true;
+    }
+
     LOG_I(TAG, "Attempting to connect with saved credentials");
 
     preferences.begin(WiFiConstants::PREFERENCES_NAMESPACE, false);
-    String ssid = preferences.getString(WiFiConstants::PREF_KEY_SSID, "");
-    String password = preferences.getString(WiFiConstants::PREF_KEY_PASSWORD, "");
+    ssid = preferences.getString(WiFiConstants::PREF_KEY_SSID, "");
+    password = preferences.getString(WiFiConstants::PREF_KEY_PASSWORD, "");
     preferences.end();
 
-    if (ssid.length() > 0) {
-        LOG_I(TAG, "Found saved SSID: %s", ssid.c_str());
-        WiFi.begin(ssid.c_str(), password.c_str());
-    } else {
-        WiFi.begin();
-    }
-
-    int timeout =
-        TimeUtils::to_ms(TimeConstants::WIFI_CONNECTION_TIMEOUT) / TimeUtils::to_ms(TimeConstants::WIFI_RETRY_DELAY);
-    while (WiFi.status() != WL_CONNECTED && timeout > 0) {
-        TimeUtils::delay_for(TimeConstants::WIFI_RETRY_DELAY);
-        LOG_D(TAG, "Connecting...");
-        timeout--;
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-        LOG_I(TAG, "Connected to WiFi!");
-        LOG_I(TAG, "IP address: %s", WiFi.localIP().toString().c_str());
-
-        WiFi.setHostname(NetworkConstants::HOSTNAME);
-
-        currentStatus = WIFI_CONNECTED;
-    } else {
-        LOG_W(TAG, "Failed to connect with saved credentials, starting custom portal");
-        captivePortalManager.setSaveCredentialsCallback(
-            [this](const String& ssid, const String& password) { this->saveWiFiCredentials(ssid, password); });
-        captivePortalManager.setStatusCallback([this](int status) { this->currentStatus = (WiFiStatus)status; });
-        captivePortalManager.setBlinkTaskCallback([this]() { this->createBlinkTask(); });
-        captivePortalManager.startCustomPortal();
-        apModeStartTime = millis();
+    if (ssid.length() == 0 || !startFastConnect()) {
+        startFullConnect();
     }
 }
 
@@ -74,15 +70,138 @@ void WifiManager::loop() {
         }
     }
 
-    wl_status_t wifiStatus = WiFi.status();
-    if (wifiStatus == WL_CONNECTED && currentStatus != WIFI_CONNECTED) {
-        currentStatus = WIFI_CONNECTED;
-    } else if (wifiStatus != WL_CONNECTED && currentStatus == WIFI_CONNECTED) {
-        currentStatus = WIFI_DISCONNECTED;
+    handleEvents();
+    handleTimeouts();
+}
+
+void WifiManager::onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    // Kører i WiFi tasken; kun flag her, resten sker i loop()
+    if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+        gotIpEvent = true;
+    } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        disconnectReason = info.wifi_sta_disconnected.reason;
+        disconnectedEvent = true;
+    }
+}
+
+void WifiManager::handleEvents() {
+    bool disconnected = disconnectedEvent.exchange(false);
+    bool gotIp = gotIpEvent.exchange(false);
+
+    if (disconnected) {
+        if (phase == PHASE_FAST) {
+            // Access pointet er flyttet, skiftet kanal eller afviser os; ingen grund til at vente på timeout
+            LOG_W(TAG, "Fast reconnect failed (reason %u), falling back to full scan", (unsigned)disconnectReason);
+            lease.invalidate();
+            startFullConnect();
+            return;
+        }
+        if (phase == PHASE_IDLE && currentStatus == WIFI_CONNECTED) {
+            LOG_W(TAG, "WiFi connection lost (reason %u)", (unsigned)disconnectReason);
+            currentStatus = WIFI_DISCONNECTED;
+        }
+    }
+
+    if (gotIp) {
+        onConnected();
+    }
+}
+
+void WifiManager::handleTimeouts() {
+    unsigned long elapsed = millis() - connectStartTime;
+    if (phase == PHASE_FAST && elapsed >= TimeUtils::to_ms(TimeConstants::WIFI_FAST_CONNECT_TIMEOUT)) {
+        LOG_W(TAG, "Fast reconnect timed out, falling back to full scan");
+        lease.invalidate();
+        startFullConnect();
+    } else if (phase == PHASE_FULL && elapsed >= TimeUtils::to_ms(TimeConstants::WIFI_CONNECTION_TIMEOUT)) {
+        LOG_W(TAG, "Failed to connect with saved credentials, starting custom portal");
+        startPortal();
+    }
+}
+
+bool WifiManager::startFastConnect() {
+    if (!lease.valid()) {
+        return false;
+    }
+    if (lease.value.reuses >= WiFiConstants::LEASE_MAX_REUSES) {
+        LOG_I(TAG, "Cached lease used %u times, renewing via DHCP", (unsigned)lease.value.reuses);
+        lease.invalidate();
+        return false;
+    }
+
+    const WifiLease& cached = lease.value;
+    LOG_I(TAG, "Fast reconnect to %s on channel %d", ssid.c_str(), (int)cached.channel);
+
+    WiFi.mode(WIFI_STA);
+    WiFi.config(IPAddress(cached.localIp), IPAddress(cached.gateway), IPAddress(cached.subnet), IPAddress(cached.dns));
+    WiFi.begin(ssid.c_str(), password.c_str(), cached.channel, cached.bssid);
+    phase = PHASE_FAST;
+    connectStartTime = millis();
+    return true;
+}
+
+void WifiManager::startFullConnect() {
+    if (phase == PHASE_FAST) {
+        WiFi.disconnect();
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+
+    if (ssid.length() > 0) {
+        LOG_I(TAG, "Found saved SSID: %s", ssid.c_str());
+        WiFi.begin(ssid.c_str(), password.c_str());
+    } else {
+        WiFi.begin();
     }
+    phase = PHASE_FULL;
+    connectStartTime = millis();
+}
 
+void WifiManager::startPortal() {
+    captivePortalManager.setSaveCredentialsCallback(
+        [this](const String& ssid, const String& password) { this->saveWiFiCredentials(ssid, password); });
+    captivePortalManager.setStatusCallback([this](int status) { this->currentStatus = (WiFiStatus)status; });
+    captivePortalManager.setBlinkTaskCallback([this]() { this->createBlinkTask(); });
+    captivePortalManager.startCustomPortal();
+    phase = PHASE_PORTAL;
+    apModeStartTime = millis();
+    apModeTimeoutEnabled = true;
+}
+
+void WifiManager::onConnected() {
+    if (phase == PHASE_IDLE && currentStatus != WIFI_CONNECTED) {
+        LOG_I(TAG, "WiFi reconnected");
+    } else if (phase != PHASE_IDLE) {
+        LOG_I(TAG, "Connected to WiFi after %lu ms", millis() - connectStartTime);
+    }
+    LOG_I(TAG, "IP address: %s", WiFi.localIP().toString().c_str());
 
-    checkWiFiStatus();
+    WiFi.setHostname(NetworkConstants::HOSTNAME);
+    if (phase == PHASE_FAST) {
+        lease.value.reuses++;
+        lease.seal();
+    } else {
+        storeLease();
+    }
+
+    phase = PHASE_IDLE;
+    currentStatus = WIFI_CONNECTED;
+}
+
+void WifiManager::storeLease() {
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid == nullptr) {
+        return;
+    }
+
+    WifiLease& cached = lease.value;
+    memcpy(cached.bssid, bssid, sizeof(cached.bssid));
+    cached.channel = WiFi.channel();
+    cached.localIp = WiFi.localIP();
+    cached.gateway = WiFi.gatewayIP();
+    cached.subnet = WiFi.subnetMask();
+    cached.dns = WiFi.dnsIP(0);
+    cached.reuses = 0;
+    lease.seal();
 }
 
 void WifiManager::createBlinkTask() {
@@ -101,24 +220,6 @@ void WifiManager::createBlinkTask() {
         &blinkTaskHandle);
 }
 
-void WifiManager::checkWiFiStatus() {
-    if (millis() - lastWiFiCheck > TimeUtils::to_ms(TimeConstants::WIFI_CHECK_INTERVAL)) {
-        lastWiFiCheck = millis();
-
-        if (currentStatus == WIFI_CONNECTED) {
-            if (WiFi.status() != WL_CONNECTED) {
-                LOG_W(TAG, "WiFi connection lost");
-                currentStatus = WIFI_DISCONNECTED;
-            }
-        } else if (currentStatus == WIFI_DISCONNECTED) {
-            if (WiFi.status() == WL_CONNECTED) {
-                currentStatus = WIFI_CONNECTED;
-                LOG_I(TAG, "WiFi reconnected");
-            }
-        }
-    }
-}
-
 void WifiManager::saveWiFiCredentials(const String& ssid, const String& password) {
     preferences.begin(WiFiConstants::PREFERENCES_NAMESPACE, false);
     preferences.putString(WiFiConstants::PREF_KEY_SSID, ssid);
@@ -133,6 +234,7 @@ void WifiManager::resetSettings() {
     preferences.end();
 
     LOG_I(TAG, "Disconnecting and erasing WiFi config from ESP32");
+    lease.invalidate();
     WiFi.disconnect(true, true);
     TimeUtils::delay_for(std::chrono::milliseconds(100));
     
@@ -158,11 +260,5 @@ bool WifiManager::hasError() const {
 
 void WifiManager::startCaptivePortal() {
     LOG_I(TAG, "Starting captive portal on demand");
-    captivePortalManager.setSaveCredentialsCallback(
-        [this](const String& ssid, const String& password) { this->saveWiFiCredentials(ssid, password); });
-    captivePortalManager.setStatusCallback([this](int status) { this->currentStatus = (WiFiStatus)status; });
-    captivePortalManager.setBlinkTaskCallback([this]() { this->createBlinkTask(); });
-    captivePortalManager.startCustomPortal();
-    apModeStartTime = millis();
-    apModeTimeoutEnabled = true;
-}
\ No newline at end of file
+    startPortal();
+}
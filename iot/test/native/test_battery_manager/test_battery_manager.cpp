@@ -0,0 +1,104 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "config/constants.h"
+#include "hardware/battery_manager.h"
+#include "native_hal.h"
+
+namespace {
+    // ADC værdi 2048 svarer til 3300mV efter spændingsdeleren; 10 ADC trin er ca. 16mV
+    const uint16_t BASE_ADC = 2048;
+
+    // Én måling i historikken: opladningsstatus opdateres højst hvert 30. sekund
+    void sample(BatteryManager& battery, uint16_t adc) {
+        NativeHal::setAnalogValue(Pins::BATTERY, adc);
+        NativeHal::advanceMicros(30000000);
+        battery.getVoltage();
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_charging_needs_five_samples() {
+    BatteryManager battery;
+    for (int i = 0; i < 4; i++) {
+        sample(battery, BASE_ADC + i * 50);
+    }
+    TEST_ASSERT_FALSE(battery.isCharging());
+
+    sample(battery, BASE_ADC + 200);
+    TEST_ASSERT_TRUE(battery.isCharging());
+}
+
+void test_flat_voltage_is_not_charging() {
+    BatteryManager battery;
+    for (int i = 0; i < 8; i++) {
+        sample(battery, BASE_ADC);
+    }
+    TEST_ASSERT_FALSE(battery.isCharging());
+}
+
+void test_rising_voltage_is_charging() {
+    BatteryManager battery;
+    for (int i = 0; i < 5; i++) {
+        sample(battery, BASE_ADC + i * 10);
+    }
+    TEST_ASSERT_TRUE(battery.isCharging());
+}
+
+void test_falling_voltage_is_not_charging() {
+    BatteryManager battery;
+    for (int i = 0; i < 5; i++) {
+        sample(battery, BASE_ADC - i * 10);
+    }
+    TEST_ASSERT_FALSE(battery.isCharging());
+}
+
+void test_trend_only_covers_last_five_samples() {
+    BatteryManager battery;
+    for (int i = 0; i < 5; i++) {
+        sample(battery, BASE_ADC + i * 10);
+    }
+    TEST_ASSERT_TRUE(battery.isCharging());
+
+    // Stigningen glider ud af vinduet når spændingen er stabil i 5 målinger
+    for (int i = 0; i < 4; i++) {
+        sample(battery, BASE_ADC + 40);
+    }
+    TEST_ASSERT_FALSE(battery.isCharging());
+}
+
+void test_zero_sample_skips_detection() {
+    BatteryManager battery;
+    sample(battery, 0);
+    for (int i = 1; i < 5; i++) {
+        sample(battery, BASE_ADC + i * 10);
+    }
+    TEST_ASSERT_FALSE(battery.isCharging());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_charging_needs_five_samples);
+    RUN_TEST(test_flat_voltage_is_not_charging);
+    RUN_TEST(test_rising_voltage_is_charging);
+    RUN_TEST(test_falling_voltage_is_not_charging);
+    RUN_TEST(test_trend_only_covers_last_five_samples);
+    RUN_TEST(test_zero_sample_skips_detection);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    NativeHal::useVirtualClock(true);
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
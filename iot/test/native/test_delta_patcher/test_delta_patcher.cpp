@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "delta_encoder.h"
+#include "native_hal.h"
+#include "network/crc32.h"
+#include "network/delta_patcher.h"
+
+namespace {
+    std::vector<uint8_t> makeBase(size_t size) {
+        std::vector<uint8_t> base(size);
+        for (size_t i = 0; i < base.size(); i++) {
+            base[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+        }
+        return base;
+    }
+
+    // Ændrede konstanter, en indsat blok og en fjernet blok
+    std::vector<uint8_t> makeImage(const std::vector<uint8_t>& base) {
+        std::vector<uint8_t> image(base.begin(), base.begin() + 5000);
+        for (size_t i = 0; i < image.size(); i += 211) {
+            image[i] += 4;
+        }
+        for (int i = 0; i < 700; i++) {
+            image.push_back(static_cast<uint8_t>(i));
+        }
+        image.insert(image.end(), base.begin() + 6000, base.end());
+        return image;
+    }
+
+    const esp_partition_t* writeBase(const std::vector<uint8_t>& base) {
+        const esp_partition_t* partition = esp_ota_get_running_partition();
+        esp_partition_write(partition, 0, base.data(), base.size());
+        return partition;
+    }
+
+    // Tom ved fejl
+    std::vector<uint8_t> applyInPieces(const esp_partition_t* partition, const std::vector<uint8_t>& base,
+                                       const std::vector<uint8_t>& patch, size_t pieceSize) {
+        DeltaPatcher patcher;
+        std::vector<uint8_t> out;
+        auto sink = [&out](const uint8_t* data, size_t length) {
+            out.insert(out.end(), data, data + length);
+            return true;
+        };
+
+        bool ok = patcher.begin(partition, base.size(), Crc32::update(0, base.data(), base.size()));
+        for (size_t offset = 0; ok && offset < patch.size(); offset += pieceSize) {
+            ok = patcher.write(patch.data() + offset, std::min(pieceSize, patch.size() - offset), sink);
+        }
+        if (!ok || !patcher.finish(sink)) {
+            out.clear();
+        }
+        return out;
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_patch_reconstructs_image_for_any_split() {
+    std::vector<uint8_t> base = makeBase(40000);
+    std::vector<uint8_t> image = makeImage(base);
+    const esp_partition_t* partition = writeBase(base);
+    std::vector<uint8_t> patch = DeltaEncoder::diff(base.data(), base.size(), image.data(), image.size());
+
+    const size_t pieceSizes[] = {1, 5, 12, 4096, patch.size()};
+    for (size_t pieceSize : pieceSizes) {
+        std::vector<uint8_t> out = applyInPieces(partition, base, patch, pieceSize);
+        TEST_ASSERT_EQUAL_UINT32(image.size(), out.size());
+        TEST_ASSERT_EQUAL_MEMORY(image.data(), out.data(), image.size());
+    }
+}
+
+void test_partition_crc_matches_written_base() {
+    std::vector<uint8_t> base = makeBase(10000);
+    const esp_partition_t* partition = writeBase(base);
+
+    uint32_t crc = 0;
+    TEST_ASSERT_TRUE(DeltaPatcher::partitionCrc32(partition, base.size(), crc));
+    TEST_ASSERT_EQUAL_UINT32(Crc32::update(0, base.data(), base.size()), crc);
+}
+
+void test_patch_for_other_base_is_rejected() {
+    std::vector<uint8_t> base = makeBase(20000);
+    std::vector<uint8_t> other = base;
+    other[42] ^= 1;
+    const esp_partition_t* partition = writeBase(base);
+    std::vector<uint8_t> patch = DeltaEncoder::diff(other.data(), other.size(), base.data(), base.size());
+
+    TEST_ASSERT_EQUAL(0, applyInPieces(partition, base, patch, patch.size()).size());
+}
+
+void test_truncated_patch_fails_on_finish() {
+    std::vector<uint8_t> base = makeBase(20000);
+    std::vector<uint8_t> image = makeImage(base);
+    const esp_partition_t* partition = writeBase(base);
+    std::vector<uint8_t> patch = DeltaEncoder::diff(base.data(), base.size(), image.data(), image.size());
+    patch.resize(patch.size() - 3);
+
+    TEST_ASSERT_EQUAL(0, applyInPieces(partition, base, patch, 4096).size());
+}
+
+int main() {
+    NativeHal::setSerialEnabled(false);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_patch_reconstructs_image_for_any_split);
+    RUN_TEST(test_partition_crc_matches_written_base);
+    RUN_TEST(test_patch_for_other_base_is_rejected);
+    RUN_TEST(test_truncated_patch_fails_on_finish);
+    return UNITY_END();
+}
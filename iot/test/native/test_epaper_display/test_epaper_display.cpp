@@ -0,0 +1,270 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "config/constants.h"
+#include "config/time_utils.h"
+#include "hardware/epaper_display.h"
+#include "native_hal.h"
+
+namespace {
+    // Hvad controlleren modtog ved én updateDisplay
+    struct Transfer {
+        std::vector<uint8_t> commands;
+        uint8_t updateMode = 0;
+        size_t blackBytes = 0;
+        size_t redBytes = 0;
+        std::vector<uint8_t> data;
+    };
+
+    EpaperDisplay display;
+    Transfer transfer;
+    // Hvor længe BUSY holdes LOW efter master activation
+    uint64_t busyMicros = 0;
+
+    void recordSpi(const uint8_t* data, size_t length, bool dataMode) {
+        if (!dataMode) {
+            transfer.commands.insert(transfer.commands.end(), data, data + length);
+            if (data[length - 1] == DisplayConstants::CMD_MASTER_ACTIVATION && busyMicros > 0) {
+                NativeHal::setPinLevel(Pins::EINK_BUSY, LOW);
+                NativeHal::schedulePinLevel(Pins::EINK_BUSY, HIGH, busyMicros);
+            }
+            return;
+        }
+        switch (transfer.commands.empty() ? 0 : transfer.commands.back()) {
+            case DisplayConstants::CMD_DISPLAY_UPDATE:
+                transfer.updateMode = data[0];
+                break;
+            case DisplayConstants::CMD_WRITE_RAM_BLACK:
+                transfer.blackBytes += length;
+                transfer.data.insert(transfer.data.end(), data, data + length);
+                break;
+            case DisplayConstants::CMD_WRITE_RAM_RED:
+                transfer.redBytes += length;
+                transfer.data.insert(transfer.data.end(), data, data + length);
+                break;
+        }
+    }
+
+    const Transfer& update() {
+        transfer = Transfer();
+        display.updateDisplay();
+        return transfer;
+    }
+
+    // Begge planer efter tegning på et nyt display; første update er altid fuld
+    template <typename Draw>
+    std::vector<uint8_t> renderFrame(Draw draw) {
+        display.begin();
+        draw();
+        return update().data;
+    }
+
+    void fillRectPerPixel(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for (int16_t i = x; i < x + w; i++) {
+            for (int16_t j = y; j < y + h; j++) {
+                display.drawPixel(i, j, color);
+            }
+        }
+    }
+
+    int countCommand(const Transfer& t, uint8_t command) {
+        int count = 0;
+        for (uint8_t c : t.commands) {
+            count += c == command;
+        }
+        return count;
+    }
+}
+
+void setUp() {
+    busyMicros = 0;
+    display.begin();
+    display.setLightSleepWhileBusy(false);
+    NativeHal::setSpiSink(recordSpi);
+}
+
+void tearDown() {
+    NativeHal::setSpiSink(nullptr);
+    NativeHal::setPinLevel(Pins::EINK_BUSY, HIGH);
+}
+
+void test_first_update_is_full() {
+    const Transfer& t = update();
+    TEST_ASSERT_EQUAL_HEX8(DisplayConstants::PARAM_UPDATE_FULL, t.updateMode);
+    TEST_ASSERT_EQUAL(DisplayConstants::EPD_BUFFER_SIZE, t.blackBytes);
+    TEST_ASSERT_EQUAL(DisplayConstants::EPD_BUFFER_SIZE, t.redBytes);
+    TEST_ASSERT_FALSE(display.lastRefreshWasPartial());
+}
+
+void test_small_change_uploads_only_its_window() {
+    update();
+
+    display.fillRect(10, 20, 30, 5, DisplayConstants::COLOR_BLACK);
+    const Transfer& t = update();
+
+    TEST_ASSERT_EQUAL_HEX8(DisplayConstants::PARAM_UPDATE_PARTIAL, t.updateMode);
+    TEST_ASSERT_TRUE(display.lastRefreshWasPartial());
+    TEST_ASSERT_EQUAL(2, countCommand(t, DisplayConstants::CMD_RAM_X_RANGE));
+    // Rotationen gør GFX x til controllerens rækker: 30 rækker á 2 bytes (y 20..24 ligger i byte 2 og 3)
+    TEST_ASSERT_EQUAL(30 * 2, t.blackBytes);
+    TEST_ASSERT_EQUAL(30 * 2, t.redBytes);
+}
+
+void test_separate_changes_get_separate_windows() {
+    update();
+
+    display.drawPixel(5, 5, DisplayConstants::COLOR_BLACK);
+    display.drawPixel(200, 100, DisplayConstants::COLOR_BLACK);
+    const Transfer& t = update();
+
+    TEST_ASSERT_EQUAL(4, countCommand(t, DisplayConstants::CMD_RAM_X_RANGE));
+    TEST_ASSERT_EQUAL(2, t.blackBytes);
+}
+
+void test_red_change_is_uploaded_in_window() {
+    update();
+
+    display.drawPixel(50, 50, DisplayConstants::COLOR_RED);
+    const Transfer& t = update();
+
+    TEST_ASSERT_EQUAL_HEX8(DisplayConstants::PARAM_UPDATE_PARTIAL, t.updateMode);
+    TEST_ASSERT_EQUAL(1, t.redBytes);
+    TEST_ASSERT_EQUAL(1, t.blackBytes);
+}
+
+void test_unchanged_frame_is_skipped() {
+    update();
+    uint32_t skipped = display.getSkippedRefreshCount();
+
+    // Samme indhold tegnet forfra giver samme planer
+    display.clearBuffers();
+    const Transfer& t = update();
+
+    TEST_ASSERT_TRUE(t.commands.empty());
+    TEST_ASSERT_EQUAL(skipped + 1, display.getSkippedRefreshCount());
+}
+
+void test_full_refresh_after_interval() {
+    update();
+
+    for (int i = 0; i < DisplayConstants::FULL_REFRESH_INTERVAL; i++) {
+        display.drawPixel(i, 0, DisplayConstants::COLOR_BLACK);
+        TEST_ASSERT_EQUAL_HEX8(DisplayConstants::PARAM_UPDATE_PARTIAL, update().updateMode);
+    }
+
+    display.drawPixel(100, 0, DisplayConstants::COLOR_BLACK);
+    TEST_ASSERT_EQUAL_HEX8(DisplayConstants::PARAM_UPDATE_FULL, update().updateMode);
+}
+
+void test_light_sleep_until_busy_releases() {
+    busyMicros = 700000;
+    display.setLightSleepWhileBusy(true);
+    uint64_t slept = NativeHal::lightSleepMicros();
+
+    update();
+
+    TEST_ASSERT_EQUAL(700, display.getLastRefreshMillis());
+    TEST_ASSERT_EQUAL(busyMicros, NativeHal::lightSleepMicros() - slept);
+    TEST_ASSERT_EQUAL(ESP_SLEEP_WAKEUP_GPIO, esp_sleep_get_wakeup_cause());
+}
+
+void test_light_sleep_times_out_when_busy_stays_low() {
+    busyMicros = 60000000;
+    display.setLightSleepWhileBusy(true);
+
+    update();
+
+    TEST_ASSERT_EQUAL(TimeUtils::to_ms(TimeConstants::EPAPER_BUSY_TIMEOUT), display.getLastRefreshMillis());
+    TEST_ASSERT_EQUAL(ESP_SLEEP_WAKEUP_TIMER, esp_sleep_get_wakeup_cause());
+}
+
+void test_polling_measures_refresh_without_sleep() {
+    busyMicros = 700000;
+    uint64_t slept = NativeHal::lightSleepMicros();
+
+    update();
+
+    // Polling opdager først skiftet ved næste 10 ms tick
+    TEST_ASSERT_EQUAL(700, display.getLastRefreshMillis());
+    TEST_ASSERT_EQUAL(0, NativeHal::lightSleepMicros() - slept);
+}
+
+void test_fast_primitives_match_pixel_drawing() {
+    // Kanter midt i bytes, hele bytes, én pixel, klipning og alle farver
+    const int16_t rects[][4] = {
+        {0, 0, 296, 128}, {10, 3, 40, 2}, {5, 8, 1, 8}, {100, 7, 3, 1}, {-5, -3, 20, 12},
+        {290, 120, 20, 20}, {50, 17, 100, 90}, {0, 127, 296, 1}, {295, 0, 1, 128},
+    };
+    const uint16_t colors[] = {DisplayConstants::COLOR_BLACK, DisplayConstants::COLOR_RED, DisplayConstants::COLOR_WHITE};
+
+    for (const auto& r : rects) {
+        for (uint16_t color : colors) {
+            // Baggrund med begge farver, så hvid også skal overskrive noget
+            auto background = []() {
+                fillRectPerPixel(0, 0, 148, 128, DisplayConstants::COLOR_BLACK);
+                fillRectPerPixel(148, 0, 148, 128, DisplayConstants::COLOR_RED);
+            };
+            std::vector<uint8_t> expected = renderFrame([&]() {
+                background();
+                fillRectPerPixel(r[0], r[1], r[2], r[3], color);
+            });
+            std::vector<uint8_t> actual = renderFrame([&]() {
+                background();
+                display.fillRect(r[0], r[1], r[2], r[3], color);
+            });
+            TEST_ASSERT_EQUAL_MEMORY(expected.data(), actual.data(), expected.size());
+        }
+    }
+}
+
+void test_fast_lines_match_pixel_drawing() {
+    std::vector<uint8_t> expected = renderFrame([]() {
+        fillRectPerPixel(3, 9, 250, 1, DisplayConstants::COLOR_BLACK);
+        fillRectPerPixel(200, 2, 1, 120, DisplayConstants::COLOR_RED);
+        fillRectPerPixel(20, 30, 11, 1, DisplayConstants::COLOR_BLACK);
+        fillRectPerPixel(40, 50, 1, 11, DisplayConstants::COLOR_BLACK);
+    });
+    std::vector<uint8_t> actual = renderFrame([]() {
+        display.drawFastHLine(3, 9, 250, DisplayConstants::COLOR_BLACK);
+        display.drawFastVLine(200, 2, 120, DisplayConstants::COLOR_RED);
+        display.drawLine(30, 30, 20, 30, DisplayConstants::COLOR_BLACK);
+        display.drawFastVLine(40, 60, -11, DisplayConstants::COLOR_BLACK);
+    });
+    TEST_ASSERT_EQUAL_MEMORY(expected.data(), actual.data(), expected.size());
+}
+
+void test_fill_screen_and_clear() {
+    std::vector<uint8_t> expected = renderFrame([]() { fillRectPerPixel(0, 0, 296, 128, DisplayConstants::COLOR_RED); });
+    std::vector<uint8_t> actual = renderFrame([]() { display.fillScreen(DisplayConstants::COLOR_RED); });
+    TEST_ASSERT_EQUAL_MEMORY(expected.data(), actual.data(), expected.size());
+
+    std::vector<uint8_t> cleared = renderFrame([]() {
+        display.fillScreen(DisplayConstants::COLOR_BLACK);
+        display.clearBuffers();
+    });
+    for (size_t i = 0; i < cleared.size(); i++) {
+        TEST_ASSERT_EQUAL_HEX8(i < DisplayConstants::EPD_BUFFER_SIZE ? 0xFF : 0x00, cleared[i]);
+    }
+}
+
+int main() {
+    NativeHal::setSerialEnabled(false);
+    NativeHal::useVirtualClock(true);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_first_update_is_full);
+    RUN_TEST(test_small_change_uploads_only_its_window);
+    RUN_TEST(test_separate_changes_get_separate_windows);
+    RUN_TEST(test_red_change_is_uploaded_in_window);
+    RUN_TEST(test_unchanged_frame_is_skipped);
+    RUN_TEST(test_full_refresh_after_interval);
+    RUN_TEST(test_fast_primitives_match_pixel_drawing);
+    RUN_TEST(test_fast_lines_match_pixel_drawing);
+    RUN_TEST(test_fill_screen_and_clear);
+    RUN_TEST(test_light_sleep_until_busy_releases);
+    RUN_TEST(test_light_sleep_times_out_when_busy_stays_low);
+    RUN_TEST(test_polling_measures_refresh_without_sleep);
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "app/epaper_monitor.h"
+#include "config/constants.h"
+#include "epaper_panel.h"
+#include "hardware/epaper_display.h"
+#include "native_hal.h"
+
+namespace {
+    EpaperDisplay display;
+    EpaperMonitor monitor(display);
+
+    // Golden billeder ligger committet ved siden af testen. Kun med BRODBUDDY_UPDATE_GOLDEN sat skrives de
+    // forfra fra den aktuelle rendering, som så skal committes. De skal renderes med det rigtige Adafruit GFX
+    // fra lib_deps i [env:native], da teksten ellers ikke bliver den samme
+    std::string goldenDirectory() {
+        std::string file = __FILE__;
+        return file.substr(0, file.find_last_of('/')) + "/golden";
+    }
+
+    std::vector<uint8_t> readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Planerne fra en fuld upload; begin() sikrer at næste update sender hele framen
+    std::vector<uint8_t> renderFrame(const SourdoughData& data) {
+        std::vector<uint8_t> frame;
+        uint8_t command = 0;
+        NativeHal::setSpiSink([&frame, &command](const uint8_t* bytes, size_t length, bool dataMode) {
+            if (!dataMode) {
+                command = bytes[length - 1];
+            } else if (command == DisplayConstants::CMD_WRITE_RAM_BLACK ||
+                       command == DisplayConstants::CMD_WRITE_RAM_RED) {
+                frame.insert(frame.end(), bytes, bytes + length);
+            }
+        });
+        display.begin();
+        monitor.updateDisplay(data);
+        NativeHal::setSpiSink(nullptr);
+        return frame;
+    }
+
+    std::vector<GrowthSample> decode(const GrowthLog& log) {
+        std::vector<GrowthSample> samples;
+        GrowthLog::Reader reader(log);
+        GrowthSample sample;
+        while (reader.next(sample)) {
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    SourdoughData otherData() {
+        SourdoughData mock = monitor.generateMockData();
+        SourdoughData data = {};
+        for (const GrowthSample& sample : decode(mock.history)) {
+            monitor.addDataPoint(data, 400 - sample.growth / 2, sample.timestamp);
+        }
+        data.currentGrowth = 321;
+        data.inTemp = 18.2f;
+        return data;
+    }
+
+    // Lineær scanning: ældste positive maksimum inden for grafens vindue, regnet fra nyeste timestamp
+    void scanPeak(const SourdoughData& data, int& peak, float& hoursAgo) {
+        std::vector<GrowthSample> samples = decode(data.history);
+        unsigned long newest = 0;
+        for (const GrowthSample& sample : samples) {
+            newest = std::max(newest, sample.timestamp);
+        }
+
+        peak = 0;
+        unsigned long peakTime = 0;
+        for (const GrowthSample& sample : samples) {
+            if (sample.timestamp + 12 * 3600 >= newest && sample.growth > peak) {
+                peak = sample.growth;
+                peakTime = sample.timestamp;
+            }
+        }
+        hoursAgo = peak > 0 ? (newest - peakTime) / 3600.0 : 0;
+    }
+}
+
+void setUp() {
+    monitor.invalidateBackground();
+}
+
+void tearDown() {}
+
+void test_cached_background_gives_same_frame() {
+    SourdoughData data = monitor.generateMockData();
+    std::vector<uint8_t> uncached = renderFrame(data);
+
+    // Cachen bygges med en anden frame, så intet fra den hænger ved
+    renderFrame(otherData());
+    std::vector<uint8_t> cached = renderFrame(data);
+
+    TEST_ASSERT_EQUAL(2 * DisplayConstants::EPD_BUFFER_SIZE, cached.size());
+    TEST_ASSERT_EQUAL_MEMORY(uncached.data(), cached.data(), uncached.size());
+}
+
+void test_partial_refreshes_end_on_same_pixels_as_full() {
+    NativeHal::EpaperPanel panel;
+    panel.attach();
+    display.begin();
+    monitor.updateDisplay(otherData());
+    monitor.updateDisplay(monitor.generateMockData());
+    TEST_ASSERT_TRUE(display.lastRefreshWasPartial());
+    std::vector<uint8_t> partial = panel.toPbm(DisplayConstants::COLOR_BLACK);
+    std::vector<uint8_t> partialRed = panel.toPbm(DisplayConstants::COLOR_RED);
+
+    display.begin();
+    monitor.updateDisplay(monitor.generateMockData());
+    panel.detach();
+    TEST_ASSERT_FALSE(display.lastRefreshWasPartial());
+
+    TEST_ASSERT_TRUE(partial == panel.toPbm(DisplayConstants::COLOR_BLACK));
+    TEST_ASSERT_TRUE(partialRed == panel.toPbm(DisplayConstants::COLOR_RED));
+}
+
+void test_mock_data_matches_golden_image() {
+    NativeHal::EpaperPanel panel;
+    panel.attach();
+    display.begin();
+    monitor.updateDisplay(monitor.generateMockData());
+    panel.detach();
+
+    const uint16_t colors[] = {DisplayConstants::COLOR_BLACK, DisplayConstants::COLOR_RED};
+    const char* names[] = {"mock_data_black.pbm", "mock_data_red.pbm"};
+    const char* update = getenv("BRODBUDDY_UPDATE_GOLDEN");
+    bool updating = update && *update;
+    if (updating) {
+        mkdir(goldenDirectory().c_str(), 0755);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        std::string path = goldenDirectory() + "/" + names[i];
+        std::vector<uint8_t> actual = panel.toPbm(colors[i]);
+        std::vector<uint8_t> golden = readFile(path);
+
+        if (updating) {
+            TEST_ASSERT_TRUE_MESSAGE(panel.writeFile(path, actual), path.c_str());
+        } else if (golden.empty()) {
+            std::string message = "Missing " + path + ", run BRODBUDDY_UPDATE_GOLDEN=1 pio test -e native "
+                                  "-f native/test_epaper_monitor and commit it";
+            TEST_FAIL_MESSAGE(message.c_str());
+        } else if (golden != actual) {
+            std::string actualPath = NativeHal::storageRoot() + "/mock_data_actual.png";
+            panel.writeFile(actualPath, panel.toPng());
+            std::string message = "Frame differs from " + path + ", rendering written to " + actualPath;
+            TEST_FAIL_MESSAGE(message.c_str());
+        }
+    }
+
+    if (updating) {
+        TEST_IGNORE_MESSAGE("Golden images written, commit them to compare future renderings");
+    }
+}
+
+void test_peak_matches_linear_scan_across_wraparound() {
+    SourdoughData data = {};
+    uint32_t seed = 12345;
+    unsigned long timestamp = 1700000000UL;
+
+    // Flere runder end bufferen rummer, med gentagne værdier, faldende serier og negative tal
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        int growth;
+        if (i % 97 < 30) {
+            growth = 500 - i % 97 * 10;
+        } else {
+            growth = static_cast<int>((seed >> 16) % 41) * 10 - 50;
+        }
+        timestamp += 600;
+        monitor.addDataPoint(data, growth, timestamp);
+
+        int expectedPeak;
+        float expectedHours;
+        scanPeak(data, expectedPeak, expectedHours);
+        TEST_ASSERT_EQUAL_MESSAGE(expectedPeak, data.peakGrowth, "peakGrowth");
+        TEST_ASSERT_EQUAL_FLOAT_MESSAGE(expectedHours, data.peakHoursAgo, "peakHoursAgo");
+    }
+}
+
+void test_old_peak_leaves_with_graph_window() {
+    SourdoughData data = {};
+    const unsigned long start = 1700000000UL;
+    const unsigned long interval = 5 * 60;
+
+    // Første fodring topper højt; den næste stiger kun til 250
+    monitor.addDataPoint(data, 380, start);
+    for (int i = 1; i <= 12 * 12; i++) {
+        monitor.addDataPoint(data, 200 + i % 40, start + i * interval);
+    }
+    TEST_ASSERT_EQUAL(380, data.peakGrowth);
+    TEST_ASSERT_EQUAL_FLOAT(12.0f, data.peakHoursAgo);
+
+    // Ét punkt mere, og den gamle peak er uden for grafen
+    monitor.addDataPoint(data, 250, start + (12 * 12 + 1) * interval);
+    TEST_ASSERT_TRUE(data.history.oldest().timestamp == start);
+    TEST_ASSERT_EQUAL(250, data.peakGrowth);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, data.peakHoursAgo);
+}
+
+void test_curve_covers_days_at_full_resolution() {
+    SourdoughData data = {};
+    const unsigned long start = 1700000000UL;
+    const unsigned long interval = 5 * 60;
+    const int count = 72 * 12;
+    for (int i = 0; i < count; i++) {
+        monitor.addDataPoint(data, 200, start + i * interval);
+    }
+
+    std::vector<GrowthSample> curve;
+    EpaperMonitor::forEachCurvePoint(data, 0, [&curve](const GrowthSample& point) { curve.push_back(point); });
+
+    TEST_ASSERT_TRUE(curve == decode(data.history));
+    unsigned long newest = start + (count - 1) * interval;
+    TEST_ASSERT_EQUAL(newest, curve.back().timestamp);
+    TEST_ASSERT_TRUE(newest - curve.front().timestamp >= 48UL * 3600);
+
+    // Kun punkter efter since
+    unsigned long since = newest - 12 * 3600;
+    size_t visited = 0;
+    EpaperMonitor::forEachCurvePoint(data, since, [&](const GrowthSample& point) {
+        TEST_ASSERT_TRUE(point.timestamp >= since);
+        visited++;
+    });
+    TEST_ASSERT_TRUE(visited > 0 && visited < curve.size());
+}
+
+void test_restore_without_saved_background_fails() {
+    EpaperDisplay fresh;
+    TEST_ASSERT_FALSE(fresh.restoreBackground());
+    TEST_ASSERT_TRUE(fresh.saveBackground());
+    TEST_ASSERT_TRUE(fresh.restoreBackground());
+}
+
+int main() {
+    NativeHal::setSerialEnabled(false);
+    NativeHal::useVirtualClock(true);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_cached_background_gives_same_frame);
+    RUN_TEST(test_partial_refreshes_end_on_same_pixels_as_full);
+    RUN_TEST(test_mock_data_matches_golden_image);
+    RUN_TEST(test_peak_matches_linear_scan_across_wraparound);
+    RUN_TEST(test_old_peak_leaves_with_graph_window);
+    RUN_TEST(test_curve_covers_days_at_full_resolution);
+    RUN_TEST(test_restore_without_saved_background_fails);
+    return UNITY_END();
+}
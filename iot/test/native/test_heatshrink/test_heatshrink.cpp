@@ -0,0 +1,123 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "heatshrink_encoder.h"
+#include "native_hal.h"
+#include "network/heatshrink_decoder.h"
+
+namespace {
+    std::vector<uint8_t> makeData(size_t size) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < data.size(); i++) {
+            // Blanding af gentagne mønstre og støj, så både literals og backrefs bruges
+            data[i] = static_cast<uint8_t>((i / 97) % 3 == 0 ? (i * 2654435761u) >> 24 : i % 41);
+        }
+        return data;
+    }
+
+    // Tom ved fejl
+    std::vector<uint8_t> decodeInPieces(const std::vector<uint8_t>& packed, uint8_t windowBits, uint8_t lookaheadBits,
+                                        size_t pieceSize) {
+        HeatshrinkDecoder decoder;
+        std::vector<uint8_t> out;
+        auto sink = [&out](const uint8_t* data, size_t length) {
+            out.insert(out.end(), data, data + length);
+            return true;
+        };
+
+        bool ok = decoder.begin(windowBits, lookaheadBits);
+        for (size_t offset = 0; ok && offset < packed.size(); offset += pieceSize) {
+            size_t length = std::min(pieceSize, packed.size() - offset);
+            ok = decoder.decode(packed.data() + offset, length, sink);
+        }
+        if (!ok || !decoder.finish(sink) || out.size() != decoder.getOutputBytes()) {
+            out.clear();
+        }
+        return out;
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_round_trip_for_supported_parameters() {
+    std::vector<uint8_t> data = makeData(50000);
+    const uint8_t parameters[][2] = {{8, 4}, {11, 4}, {13, 5}, {15, 8}};
+
+    for (const auto& parameter : parameters) {
+        std::vector<uint8_t> packed = HeatshrinkEncoder::encode(data.data(), data.size(), parameter[0], parameter[1]);
+        TEST_ASSERT_LESS_THAN(data.size(), packed.size());
+
+        std::vector<uint8_t> out = decodeInPieces(packed, parameter[0], parameter[1], packed.size());
+        TEST_ASSERT_EQUAL_UINT32(data.size(), out.size());
+        TEST_ASSERT_EQUAL_MEMORY(data.data(), out.data(), data.size());
+    }
+}
+
+// Chunk grænser kan falde midt i et symbol; resultatet må ikke afhænge af hvordan input deles op
+void test_input_split_anywhere_gives_same_output() {
+    std::vector<uint8_t> data = makeData(20000);
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(data.data(), data.size(), 11, 4);
+
+    const size_t pieceSizes[] = {1, 3, 7, 4096};
+    for (size_t pieceSize : pieceSizes) {
+        std::vector<uint8_t> out = decodeInPieces(packed, 11, 4, pieceSize);
+        TEST_ASSERT_EQUAL_UINT32(data.size(), out.size());
+        TEST_ASSERT_EQUAL_MEMORY(data.data(), out.data(), data.size());
+    }
+}
+
+void test_output_is_delivered_in_full_blocks() {
+    std::vector<uint8_t> data = makeData(3 * HeatshrinkDecoder::OUTPUT_BLOCK_SIZE + 100);
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(data.data(), data.size(), 11, 4);
+    std::vector<size_t> blocks;
+    auto sink = [&blocks](const uint8_t*, size_t length) {
+        blocks.push_back(length);
+        return true;
+    };
+
+    HeatshrinkDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.begin(11, 4));
+    TEST_ASSERT_TRUE(decoder.decode(packed.data(), packed.size(), sink));
+    TEST_ASSERT_EQUAL(3, blocks.size());
+    TEST_ASSERT_TRUE(decoder.finish(sink));
+    TEST_ASSERT_EQUAL(4, blocks.size());
+    TEST_ASSERT_EQUAL_UINT32(100, blocks.back());
+}
+
+void test_sink_failure_stops_decoding() {
+    std::vector<uint8_t> data = makeData(3 * HeatshrinkDecoder::OUTPUT_BLOCK_SIZE);
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(data.data(), data.size(), 11, 4);
+    int calls = 0;
+
+    HeatshrinkDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.begin(11, 4));
+    TEST_ASSERT_FALSE(decoder.decode(packed.data(), packed.size(), [&calls](const uint8_t*, size_t) {
+        calls++;
+        return false;
+    }));
+    TEST_ASSERT_EQUAL(1, calls);
+}
+
+void test_invalid_parameters_are_rejected() {
+    HeatshrinkDecoder decoder;
+    TEST_ASSERT_FALSE(decoder.begin(3, 2));
+    TEST_ASSERT_FALSE(decoder.begin(16, 4));
+    TEST_ASSERT_FALSE(decoder.begin(8, 8));
+    TEST_ASSERT_FALSE(decoder.isActive());
+}
+
+int main() {
+    NativeHal::setSerialEnabled(false);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_for_supported_parameters);
+    RUN_TEST(test_input_split_anywhere_gives_same_output);
+    RUN_TEST(test_output_is_delivered_in_full_blocks);
+    RUN_TEST(test_sink_failure_stops_decoding);
+    RUN_TEST(test_invalid_parameters_are_rejected);
+    return UNITY_END();
+}
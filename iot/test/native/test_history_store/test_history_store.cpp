@@ -0,0 +1,203 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "app/epaper_monitor.h"
+#include "app/history_store.h"
+#include "config/constants.h"
+#include "hardware/epaper_display.h"
+
+namespace {
+    using MonitoringConstants::HISTORY_JOURNAL_BATCH;
+    using MonitoringConstants::HISTORY_JOURNAL_MAX_RECORDS;
+
+    EpaperDisplay display;
+    EpaperMonitor monitor(display);
+    SourdoughData data;
+    std::vector<GrowthSample> recorded;
+
+    std::vector<GrowthSample> decode(const GrowthLog& log) {
+        std::vector<GrowthSample> samples;
+        GrowthLog::Reader reader(log);
+        GrowthSample sample;
+        while (reader.next(sample)) {
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    // Som handleStateSensing: monitoren først, så lageret
+    void record(HistoryStore& store, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            unsigned long timestamp = 1700000000UL + recorded.size() * 300;
+            int growth = 100 + static_cast<int>((recorded.size() * 7) % 90);
+            monitor.addDataPoint(data, growth, timestamp);
+            store.record(data, timestamp, growth);
+            recorded.push_back({timestamp, growth});
+        }
+    }
+
+    size_t journalSize() {
+        File file = LittleFS.open(HistoryStore::JOURNAL_FILE, "r");
+        return file ? file.size() : 0;
+    }
+
+    // Genstart: ny arbejdskopi og nyt lager, kun RTC kopien og journalen er tilbage
+    SourdoughData reboot(bool& restored) {
+        SourdoughData rebooted = {};
+        HistoryStore store;
+        restored = store.restore(monitor, rebooted);
+        return rebooted;
+    }
+
+    void assertSameHistory(const SourdoughData& expected, const SourdoughData& actual) {
+        TEST_ASSERT_TRUE(decode(expected.history) == decode(actual.history));
+        TEST_ASSERT_EQUAL(expected.currentGrowth, actual.currentGrowth);
+        TEST_ASSERT_EQUAL(expected.peakGrowth, actual.peakGrowth);
+        TEST_ASSERT_EQUAL_FLOAT(expected.peakHoursAgo, actual.peakHoursAgo);
+    }
+}
+
+void setUp() {
+    LittleFS.remove(HistoryStore::JOURNAL_FILE);
+    HistoryStore::invalidateSnapshot();
+    data = {};
+    recorded.clear();
+    HistoryStore store;
+    store.restore(monitor, data);
+}
+
+void tearDown() {}
+
+void test_first_boot_starts_empty() {
+    HistoryStore::invalidateSnapshot();
+    bool restored = true;
+    SourdoughData rebooted = reboot(restored);
+    TEST_ASSERT_FALSE(restored);
+    TEST_ASSERT_TRUE(rebooted.history.empty());
+    TEST_ASSERT_EQUAL(0, rebooted.peakGrowth);
+}
+
+void test_reset_restores_from_rtc() {
+    HistoryStore store;
+    record(store, 3 * HISTORY_JOURNAL_BATCH + 3);
+    TEST_ASSERT_EQUAL(3, store.pendingCount());
+
+    bool restored = false;
+    SourdoughData rebooted = reboot(restored);
+    TEST_ASSERT_TRUE(restored);
+    assertSameHistory(data, rebooted);
+
+    // Ventende punkter følger med, så journalen bliver komplet ved næste batch
+    HistoryStore after;
+    TEST_ASSERT_EQUAL(3, after.pendingCount());
+}
+
+void test_journal_written_in_batches() {
+    HistoryStore store;
+    size_t previous = journalSize();
+    int writes = 0;
+    for (int i = 0; i < 4 * HISTORY_JOURNAL_BATCH; i++) {
+        record(store, 1);
+        size_t size = journalSize();
+        if (size != previous) {
+            writes++;
+            TEST_ASSERT_EQUAL(0, store.pendingCount());
+        }
+        previous = size;
+    }
+    TEST_ASSERT_EQUAL(4, writes);
+}
+
+void test_power_loss_replays_journal() {
+    HistoryStore store;
+    record(store, 5 * HISTORY_JOURNAL_BATCH + 2);
+    HistoryStore::invalidateSnapshot();
+
+    bool restored = false;
+    SourdoughData rebooted = reboot(restored);
+    TEST_ASSERT_TRUE(restored);
+
+    // Alt undtagen det ufærdige batch; peak bygges op igen fra punkterne
+    std::vector<GrowthSample> expected(recorded.begin(), recorded.end() - 2);
+    TEST_ASSERT_TRUE(expected == decode(rebooted.history));
+    TEST_ASSERT_EQUAL(expected.back().growth, rebooted.currentGrowth);
+    TEST_ASSERT_TRUE(rebooted.peakGrowth > 0);
+}
+
+void test_flush_before_restart_keeps_everything() {
+    HistoryStore store;
+    record(store, HISTORY_JOURNAL_BATCH / 2);
+    TEST_ASSERT_TRUE(store.flush());
+    TEST_ASSERT_EQUAL(0, store.pendingCount());
+    HistoryStore::invalidateSnapshot();
+
+    bool restored = false;
+    SourdoughData rebooted = reboot(restored);
+    TEST_ASSERT_TRUE(restored);
+    assertSameHistory(data, rebooted);
+}
+
+void test_partial_record_is_cut_off() {
+    HistoryStore store;
+    record(store, HISTORY_JOURNAL_BATCH);
+    File file = LittleFS.open(HistoryStore::JOURNAL_FILE, "a");
+    file.write(reinterpret_cast<const uint8_t*>("\x01\x02\x03"), 3);
+    file.close();
+
+    record(store, HISTORY_JOURNAL_BATCH);
+    HistoryStore::invalidateSnapshot();
+    bool restored = false;
+    SourdoughData rebooted = reboot(restored);
+    TEST_ASSERT_TRUE(decode(data.history) == decode(rebooted.history));
+}
+
+void test_journal_is_compacted() {
+    HistoryStore store;
+    record(store, HISTORY_JOURNAL_MAX_RECORDS + HISTORY_JOURNAL_BATCH);
+    // 8 bytes header og 8 bytes pr. punkt
+    size_t records = (journalSize() - 8) / 8;
+    TEST_ASSERT_TRUE(records <= static_cast<size_t>(HISTORY_JOURNAL_MAX_RECORDS));
+    TEST_ASSERT_TRUE(records >= static_cast<size_t>(HISTORY_JOURNAL_MAX_RECORDS / 2));
+
+    // Den nyeste del er nok til at fylde fuld opløsnings loggen. Blokkene deles anderledes når afspilningen
+    // starter et andet sted, så kun de nyeste punkter sammenlignes
+    HistoryStore::invalidateSnapshot();
+    bool restored = false;
+    SourdoughData rebooted = reboot(restored);
+    TEST_ASSERT_TRUE(restored);
+    std::vector<GrowthSample> before = decode(data.history);
+    std::vector<GrowthSample> after = decode(rebooted.history);
+    size_t common = std::min(before.size(), after.size());
+    TEST_ASSERT_TRUE(common > before.size() / 2);
+    TEST_ASSERT_TRUE(std::vector<GrowthSample>(before.end() - common, before.end()) ==
+                     std::vector<GrowthSample>(after.end() - common, after.end()));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_boot_starts_empty);
+    RUN_TEST(test_reset_restores_from_rtc);
+    RUN_TEST(test_journal_written_in_batches);
+    RUN_TEST(test_power_loss_replays_journal);
+    RUN_TEST(test_flush_before_restart_keeps_everything);
+    RUN_TEST(test_partial_record_is_cut_off);
+    RUN_TEST(test_journal_is_compacted);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
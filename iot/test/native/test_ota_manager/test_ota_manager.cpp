@@ -0,0 +1,717 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <unity.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "config/constants.h"
+#include "delta_encoder.h"
+#include "heatshrink_encoder.h"
+#include "native_hal.h"
+#include "network/crc32.h"
+#include "network/ed25519.h"
+#include "network/mqtt_manager.h"
+#include "network/mqtt_message_router.h"
+#include "network/mqtt_protocol.h"
+#include "network/mqtt_topics.h"
+#include "network/ota_manager.h"
+#include "network/sha256.h"
+
+namespace {
+    const String START_TOPIC = "analyzer/test/ota/start";
+    const String CHUNK_TOPIC = "analyzer/test/ota/chunk";
+
+    std::vector<uint8_t> makeImage(size_t size) {
+        std::vector<uint8_t> image(size);
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = static_cast<uint8_t>((i * 31) ^ (i >> 7));
+        }
+        return image;
+    }
+
+    bool sendStartDocument(OtaManager& ota, const JsonDocument& doc) {
+        String payload;
+        serializeJson(doc, payload);
+        return ota.handleOtaMessage(START_TOPIC, reinterpret_cast<const uint8_t*>(payload.c_str()), payload.length(),
+                                    START_TOPIC, CHUNK_TOPIC);
+    }
+
+    bool sendStart(OtaManager& ota, uint32_t size, uint32_t crc32) {
+        DynamicJsonDocument doc(256);
+        doc[MqttProtocol::OtaFields::VERSION] = "test-1.0.0";
+        doc[MqttProtocol::OtaFields::SIZE] = size;
+        doc[MqttProtocol::OtaFields::CRC32] = crc32;
+        return sendStartDocument(ota, doc);
+    }
+
+    bool sendCompressedStart(OtaManager& ota, const std::vector<uint8_t>& packed, const std::vector<uint8_t>& image,
+                             const char* compression = MqttProtocol::OtaFields::CompressionValues::HEATSHRINK) {
+        DynamicJsonDocument doc(256);
+        doc[MqttProtocol::OtaFields::VERSION] = "test-1.1.0";
+        doc[MqttProtocol::OtaFields::SIZE] = packed.size();
+        doc[MqttProtocol::OtaFields::CRC32] = Crc32::update(0, image.data(), image.size());
+        doc[MqttProtocol::OtaFields::COMPRESSION] = compression;
+        doc[MqttProtocol::OtaFields::IMAGE_SIZE] = image.size();
+        doc[MqttProtocol::OtaFields::WINDOW_BITS] = 11;
+        doc[MqttProtocol::OtaFields::LOOKAHEAD_BITS] = 4;
+        return sendStartDocument(ota, doc);
+    }
+
+    bool sendDeltaStart(OtaManager& ota, const std::vector<uint8_t>& packed, const std::vector<uint8_t>& image,
+                        const std::vector<uint8_t>& base, uint32_t baseCrc32) {
+        DynamicJsonDocument doc(512);
+        doc[MqttProtocol::OtaFields::VERSION] = "test-1.2.0";
+        doc[MqttProtocol::OtaFields::SIZE] = packed.size();
+        doc[MqttProtocol::OtaFields::CRC32] = Crc32::update(0, image.data(), image.size());
+        doc[MqttProtocol::OtaFields::COMPRESSION] = MqttProtocol::OtaFields::CompressionValues::HEATSHRINK;
+        doc[MqttProtocol::OtaFields::IMAGE_SIZE] = image.size();
+        doc[MqttProtocol::OtaFields::WINDOW_BITS] = 11;
+        doc[MqttProtocol::OtaFields::LOOKAHEAD_BITS] = 8;
+        doc[MqttProtocol::OtaFields::PATCH] = MqttProtocol::OtaFields::PatchValues::BSDIFF;
+        doc[MqttProtocol::OtaFields::BASE_VERSION] = "test-1.1.0";
+        doc[MqttProtocol::OtaFields::BASE_SIZE] = base.size();
+        doc[MqttProtocol::OtaFields::BASE_CRC32] = baseCrc32;
+        return sendStartDocument(ota, doc);
+    }
+
+    const uint8_t SIGNING_SEED[Ed25519::SEED_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+                                                       17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32};
+
+    String toHex(const uint8_t* data, size_t length) {
+        String hex;
+        for (size_t i = 0; i < length; i++) {
+            char byte[3];
+            snprintf(byte, sizeof(byte), "%02x", data[i]);
+            hex += byte;
+        }
+        return hex;
+    }
+
+    String signingKeyHex() {
+        uint8_t publicKey[Ed25519::PUBLIC_KEY_SIZE];
+        Ed25519::derivePublicKey(SIGNING_SEED, publicKey);
+        return toHex(publicKey, sizeof(publicKey));
+    }
+
+    String signImage(const std::vector<uint8_t>& image) {
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        uint8_t signature[Ed25519::SIGNATURE_SIZE];
+        Sha256::hash(image.data(), image.size(), digest);
+        Ed25519::sign(SIGNING_SEED, digest, sizeof(digest), signature);
+        return toHex(signature, sizeof(signature));
+    }
+
+    bool sendSignedStart(OtaManager& ota, const std::vector<uint8_t>& image, const String& signature) {
+        DynamicJsonDocument doc(512);
+        doc[MqttProtocol::OtaFields::VERSION] = "test-1.3.0";
+        doc[MqttProtocol::OtaFields::SIZE] = image.size();
+        doc[MqttProtocol::OtaFields::CRC32] = Crc32::update(0, image.data(), image.size());
+        if (signature.length() > 0) {
+            doc[MqttProtocol::OtaFields::SIGNATURE] = signature;
+        }
+        return sendStartDocument(ota, doc);
+    }
+
+    // Ny version af base: ændrede bytes, en indsat blok og en flyttet hale, ligesom mellem to builds
+    std::vector<uint8_t> makeNextVersion(const std::vector<uint8_t>& base) {
+        std::vector<uint8_t> image(base.begin(), base.begin() + base.size() / 2);
+        for (size_t i = 100; i < image.size(); i += 997) {
+            image[i] ^= 0x5A;
+        }
+        for (int i = 0; i < 3000; i++) {
+            image.push_back(static_cast<uint8_t>(i * 13));
+        }
+        image.insert(image.end(), base.begin() + base.size() / 2, base.end());
+        return image;
+    }
+
+    // Et image med gentagelser, så det faktisk kan komprimeres
+    std::vector<uint8_t> makeCompressibleImage(size_t size) {
+        std::vector<uint8_t> image(size);
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = static_cast<uint8_t>((i % 251) < 64 ? i / 251 : (i * 7) % 13);
+        }
+        return image;
+    }
+
+    bool sendChunk(OtaManager& ota, const std::vector<uint8_t>& image, uint32_t index) {
+        uint32_t offset = index * OtaConstants::MAX_CHUNK_SIZE;
+        uint32_t size = std::min<uint32_t>(OtaConstants::MAX_CHUNK_SIZE, image.size() - offset);
+        std::vector<uint8_t> chunk(OtaConstants::CHUNK_HEADER_SIZE + size);
+        memcpy(chunk.data(), &index, 4);
+        memcpy(chunk.data() + 4, &size, 4);
+        memcpy(chunk.data() + OtaConstants::CHUNK_HEADER_SIZE, image.data() + offset, size);
+        return ota.handleOtaMessage(CHUNK_TOPIC, chunk.data(), chunk.size(), START_TOPIC, CHUNK_TOPIC);
+    }
+
+    uint32_t chunkCount(const std::vector<uint8_t>& image) {
+        return (image.size() + OtaConstants::MAX_CHUNK_SIZE - 1) / OtaConstants::MAX_CHUNK_SIZE;
+    }
+
+    std::vector<uint8_t> readPartition(const esp_partition_t* partition, size_t size) {
+        std::vector<uint8_t> data(size);
+        esp_partition_read(partition, 0, data.data(), size);
+        return data;
+    }
+
+    bool restarted = false;
+
+    // Broker på loopback: svarer CONNACK og kasserer alt klienten sender. Testen sender selv PUBLISH pakker til
+    // klienten, så beskederne går gennem PubSubClient's buffer som på enheden
+    class LoopbackBroker {
+      public:
+        LoopbackBroker() {
+            _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(addr);
+            if (bind(_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(_listenFd, 1) != 0 ||
+                getsockname(_listenFd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+                return;
+            }
+            _port = ntohs(addr.sin_port);
+            _worker = std::thread([this]() { serve(); });
+        }
+
+        ~LoopbackBroker() {
+            shutdown(_listenFd, SHUT_RDWR);
+            int client = _clientFd;
+            if (client >= 0) shutdown(client, SHUT_RDWR);
+            if (_worker.joinable()) _worker.join();
+            close(_listenFd);
+        }
+
+        uint16_t port() const { return _port; }
+
+        bool publish(const String& topic, const uint8_t* payload, size_t length) {
+            std::vector<uint8_t> packet = {0x30};
+            size_t remaining = 2 + topic.length() + length;
+            do {
+                uint8_t digit = remaining % 128;
+                remaining /= 128;
+                packet.push_back(remaining > 0 ? digit | 0x80 : digit);
+            } while (remaining > 0);
+            packet.push_back(static_cast<uint8_t>(topic.length() >> 8));
+            packet.push_back(static_cast<uint8_t>(topic.length() & 0xFF));
+            packet.insert(packet.end(), topic.c_str(), topic.c_str() + topic.length());
+            packet.insert(packet.end(), payload, payload + length);
+            return send(_clientFd, packet.data(), packet.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(packet.size());
+        }
+
+      private:
+        int _listenFd = -1;
+        std::atomic<int> _clientFd{-1};
+        uint16_t _port = 0;
+        std::thread _worker;
+
+        void serve() {
+            int client = accept(_listenFd, nullptr, nullptr);
+            if (client < 0) return;
+            _clientFd = client;
+
+            std::vector<uint8_t> buffer(64 * 1024);
+            bool connackSent = false;
+            while (recv(client, buffer.data(), buffer.size(), 0) > 0) {
+                if (!connackSent) {
+                    const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+                    send(client, connack, sizeof(connack), MSG_NOSIGNAL);
+                    connackSent = true;
+                }
+            }
+            close(client);
+        }
+    };
+}
+
+void setUp() {
+    Preferences preferences;
+    preferences.begin(OtaConstants::PREFERENCES_NAMESPACE, false);
+    preferences.clear();
+    preferences.end();
+
+    restarted = false;
+    NativeHal::setRestartHandler([]() { restarted = true; });
+    NativeHal::setFlashWriteDelay(0);
+}
+
+void tearDown() {
+    NativeHal::setRestartHandler(nullptr);
+    NativeHal::setFlashWriteDelay(0);
+}
+
+void test_complete_transfer_writes_image_and_reboots() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(10 * 4096 + 77);
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), Crc32::update(0, image.data(), image.size())));
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+
+    TEST_ASSERT_EQUAL(static_cast<int>(OtaManager::OtaStatus::REBOOTING), static_cast<int>(ota.getStatus()));
+    TEST_ASSERT_TRUE(restarted);
+    TEST_ASSERT_EQUAL_UINT32(image.size(), ota.getWrittenBytes());
+
+    const esp_partition_t* boot = esp_ota_get_boot_partition();
+    TEST_ASSERT_EQUAL_STRING("ota_0", boot->label);
+    std::vector<uint8_t> written = readPartition(boot, image.size());
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), written.data(), image.size());
+}
+
+void test_crc_mismatch_aborts_without_reboot() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(3 * 4096);
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), 0xDEADBEEF));
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        sendChunk(ota, image, i);
+    }
+
+    TEST_ASSERT_EQUAL(static_cast<int>(OtaManager::OtaStatus::ERROR), static_cast<int>(ota.getStatus()));
+    TEST_ASSERT_FALSE(ota.isInProgress());
+    TEST_ASSERT_FALSE(restarted);
+}
+
+void test_slow_flash_reports_backpressure() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(12 * 4096);
+    int activeReports = 0;
+    int clearedReports = 0;
+    ota.setBackpressureCallback([&](bool active, uint8_t queued) {
+        if (active) {
+            activeReports++;
+            // Højst én buffer er hos writeren, resten venter i køen
+            TEST_ASSERT_GREATER_OR_EQUAL(OtaConstants::WRITE_BUFFER_COUNT - 1, queued);
+        } else {
+            clearedReports++;
+        }
+    });
+
+    // 4 KB tager ~8 ms at skrive, chunks ankommer uden pause
+    NativeHal::setFlashWriteDelay(2000);
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), Crc32::update(0, image.data(), image.size())));
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+
+    TEST_ASSERT_TRUE(restarted);
+    TEST_ASSERT_GREATER_THAN(0, activeReports);
+    TEST_ASSERT_EQUAL(activeReports, clearedReports);
+}
+
+// Som på enheden: backpressure publiceres fra MQTT callbacken, og publish genbruger bufferen chunken ligger i
+void test_backpressure_publish_does_not_corrupt_chunk() {
+    LoopbackBroker broker;
+    MqttManager mqtt;
+    TEST_ASSERT_TRUE(mqtt.begin("127.0.0.1", broker.port(), "", "", "test-analyzer"));
+
+    MqttTopics topics("test");
+    MqttMessageRouter router;
+    router.setTopics(&topics);
+    OtaManager ota;
+    router.setOtaHandler([&](const String& topic, const uint8_t* payload, unsigned int length) {
+        ota.handleOtaMessage(topic, payload, length, topics.getOtaStartTopic(), topics.getOtaChunkTopic());
+    });
+    mqtt.setCallback([&](char* topic, byte* payload, unsigned int length) {
+        router.routeMessage(topic, payload, length);
+    });
+
+    int activeReports = 0;
+    ota.setBackpressureCallback([&](bool active, uint8_t queued) {
+        activeReports += active ? 1 : 0;
+        DynamicJsonDocument doc(128);
+        doc[MqttProtocol::OtaFields::STATUS] = MqttProtocol::OtaFields::StatusValues::DOWNLOADING;
+        doc[MqttProtocol::OtaFields::BACKPRESSURE] = active;
+        doc[MqttProtocol::OtaFields::QUEUED] = queued;
+        mqtt.publish(topics.getOtaStatusTopic().c_str(), doc);
+    });
+
+    std::vector<uint8_t> image = makeImage(12 * 4096);
+    DynamicJsonDocument start(256);
+    start[MqttProtocol::OtaFields::VERSION] = "test-1.0.0";
+    start[MqttProtocol::OtaFields::SIZE] = image.size();
+    start[MqttProtocol::OtaFields::CRC32] = Crc32::update(0, image.data(), image.size());
+    String startPayload;
+    serializeJson(start, startPayload);
+
+    NativeHal::setFlashWriteDelay(2000);
+    TEST_ASSERT_TRUE(broker.publish(topics.getOtaStartTopic(), reinterpret_cast<const uint8_t*>(startPayload.c_str()),
+                                    startPayload.length()));
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        uint32_t size = OtaConstants::MAX_CHUNK_SIZE;
+        std::vector<uint8_t> chunk(OtaConstants::CHUNK_HEADER_SIZE + size);
+        memcpy(chunk.data(), &i, 4);
+        memcpy(chunk.data() + 4, &size, 4);
+        memcpy(chunk.data() + OtaConstants::CHUNK_HEADER_SIZE, image.data() + i * size, size);
+        TEST_ASSERT_TRUE(broker.publish(topics.getOtaChunkTopic(), chunk.data(), chunk.size()));
+    }
+
+    for (int i = 0; i < 1000 && !restarted; i++) {
+        mqtt.loop();
+        usleep(1000);
+    }
+
+    // En chunk overskrevet af status beskeden giver en CRC fejl, og så genstartes der ikke
+    TEST_ASSERT_GREATER_THAN(0, activeReports);
+    TEST_ASSERT_TRUE(restarted);
+    std::vector<uint8_t> written = readPartition(esp_ota_get_boot_partition(), image.size());
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), written.data(), image.size());
+}
+
+void test_abort_mid_transfer_stops_writer() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(8 * 4096);
+
+    NativeHal::setFlashWriteDelay(1000);
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), Crc32::update(0, image.data(), image.size())));
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+    ota.abort("test");
+
+    TEST_ASSERT_FALSE(ota.isInProgress());
+    TEST_ASSERT_EQUAL(0, ota.getQueuedChunks());
+
+    // En ny opdatering kan startes bagefter
+    NativeHal::setFlashWriteDelay(0);
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), Crc32::update(0, image.data(), image.size())));
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+    TEST_ASSERT_TRUE(restarted);
+}
+
+void test_resume_after_reboot_continues_from_checkpoint() {
+    std::vector<uint8_t> image = makeImage(24 * 4096 + 100);
+    uint32_t crc = Crc32::update(0, image.data(), image.size());
+    uint32_t interrupted = OtaConstants::CHECKPOINT_INTERVAL_CHUNKS + 3;
+
+    {
+        OtaManager ota;
+        TEST_ASSERT_TRUE(sendStart(ota, image.size(), crc));
+        for (uint32_t i = 0; i < interrupted; i++) {
+            TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+        }
+        ota.abort("connection lost", true);
+        TEST_ASSERT_TRUE(ota.hasCheckpoint());
+    }
+
+    // Ny instans svarer til efter genstart: kun NVS og flash er tilbage
+    OtaManager ota;
+    ota.begin();
+    TEST_ASSERT_TRUE(ota.hasCheckpoint());
+
+    int requests = 0;
+    uint32_t nextChunk = 0;
+    ota.setResumeRequestCallback([&](const String& version, uint32_t chunk, uint32_t offset) {
+        requests++;
+        nextChunk = chunk;
+        TEST_ASSERT_EQUAL_STRING("test-1.0.0", version.c_str());
+        TEST_ASSERT_EQUAL_UINT32(chunk * OtaConstants::MAX_CHUNK_SIZE, offset);
+    });
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), crc));
+    TEST_ASSERT_EQUAL(1, requests);
+    TEST_ASSERT_EQUAL_UINT32(OtaConstants::CHECKPOINT_INTERVAL_CHUNKS, nextChunk);
+    TEST_ASSERT_EQUAL_UINT32(nextChunk * OtaConstants::MAX_CHUNK_SIZE, ota.getReceivedBytes());
+
+    // Afsenderen der ikke har set anmodningen sender forfra; det allerede skrevne springes over
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+
+    TEST_ASSERT_TRUE(restarted);
+    TEST_ASSERT_FALSE(ota.hasCheckpoint());
+    std::vector<uint8_t> written = readPartition(esp_ota_get_boot_partition(), image.size());
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), written.data(), image.size());
+}
+
+void test_resume_discards_checkpoint_when_flash_differs() {
+    std::vector<uint8_t> image = makeImage(20 * 4096);
+    uint32_t crc = Crc32::update(0, image.data(), image.size());
+
+    {
+        OtaManager ota;
+        TEST_ASSERT_TRUE(sendStart(ota, image.size(), crc));
+        for (uint32_t i = 0; i < OtaConstants::CHECKPOINT_INTERVAL_CHUNKS + 1; i++) {
+            TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+        }
+        ota.abort("connection lost", true);
+    }
+
+    esp_partition_erase_range(esp_ota_get_next_update_partition(nullptr), 0, OtaConstants::FLASH_SECTOR_SIZE);
+
+    OtaManager ota;
+    ota.begin();
+    int requests = 0;
+    ota.setResumeRequestCallback([&](const String&, uint32_t, uint32_t) { requests++; });
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), crc));
+    TEST_ASSERT_EQUAL(0, requests);
+    TEST_ASSERT_EQUAL_UINT32(0, ota.getReceivedBytes());
+
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+    TEST_ASSERT_TRUE(restarted);
+}
+
+void test_repeated_start_during_transfer_requests_resume() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(20 * 4096);
+    uint32_t crc = Crc32::update(0, image.data(), image.size());
+    uint32_t nextChunk = 0;
+    ota.setResumeRequestCallback([&](const String&, uint32_t chunk, uint32_t) { nextChunk = chunk; });
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), crc));
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), crc));
+    TEST_ASSERT_EQUAL_UINT32(5, nextChunk);
+
+    // En chunk uden for modtagevinduet gemmes ikke, men beder om at fortsætte fra hullet
+    TEST_ASSERT_TRUE(sendChunk(ota, image, 5 + OtaConstants::RECEIVE_WINDOW_CHUNKS));
+    TEST_ASSERT_EQUAL_UINT32(5 * 4096, ota.getReceivedBytes());
+    TEST_ASSERT_EQUAL_UINT32(0, ota.getBufferedChunks());
+
+    for (uint32_t i = nextChunk; i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+    TEST_ASSERT_TRUE(restarted);
+    std::vector<uint8_t> written = readPartition(esp_ota_get_boot_partition(), image.size());
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), written.data(), image.size());
+}
+
+void test_reordered_and_duplicate_chunks_are_written_in_order() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(12 * 4096 + 300);
+    uint32_t acks = 0;
+    ota.setAckCallback([&](uint32_t, uint32_t, uint32_t) { acks++; });
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), Crc32::update(0, image.data(), image.size())));
+
+    // Nabopar byttet om, en ventende chunk sendt to gange og gamle chunks sendt igen
+    const uint32_t order[] = {1, 1, 0, 3, 2, 0, 5, 7, 4, 6, 5, 9, 8, 11, 10, 12};
+    for (uint32_t index : order) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, index));
+    }
+
+    TEST_ASSERT_TRUE(restarted);
+    TEST_ASSERT_EQUAL_UINT32(3, ota.getDuplicateChunks());
+    TEST_ASSERT_TRUE(acks >= 6);
+    std::vector<uint8_t> written = readPartition(esp_ota_get_boot_partition(), image.size());
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), written.data(), image.size());
+}
+
+void test_sack_reports_buffered_chunks() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(10 * 4096);
+    uint32_t ackChunk = 0, ackMask = 0, ackWindow = 0;
+    ota.setAckCallback([&](uint32_t nextChunk, uint32_t receivedMask, uint32_t window) {
+        ackChunk = nextChunk;
+        ackMask = receivedMask;
+        ackWindow = window;
+    });
+
+    TEST_ASSERT_TRUE(sendStart(ota, image.size(), Crc32::update(0, image.data(), image.size())));
+    TEST_ASSERT_TRUE(sendChunk(ota, image, 0));
+    TEST_ASSERT_TRUE(sendChunk(ota, image, 2));
+    TEST_ASSERT_TRUE(sendChunk(ota, image, 3));
+    TEST_ASSERT_TRUE(sendChunk(ota, image, 5));
+
+    TEST_ASSERT_EQUAL_UINT32(1, ackChunk);
+    TEST_ASSERT_EQUAL_HEX32(0b1011, ackMask);
+    TEST_ASSERT_EQUAL_UINT32(OtaConstants::RECEIVE_WINDOW_CHUNKS, ackWindow);
+    TEST_ASSERT_EQUAL_UINT32(3, ota.getBufferedChunks());
+    TEST_ASSERT_EQUAL_UINT32(4096, ota.getReceivedBytes());
+
+    // Hullet lukkes: de ventende chunks skrives, kun chunk 5 venter stadig
+    TEST_ASSERT_TRUE(sendChunk(ota, image, 1));
+    TEST_ASSERT_EQUAL_UINT32(4 * 4096, ota.getReceivedBytes());
+    TEST_ASSERT_EQUAL_UINT32(1, ota.getBufferedChunks());
+    TEST_ASSERT_EQUAL_UINT32(4, ota.getNextChunkIndex());
+    TEST_ASSERT_EQUAL_HEX32(0b1, ota.getReceivedMask());
+
+    ota.abort("test");
+}
+
+void test_compressed_transfer_writes_unpacked_image() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeCompressibleImage(40 * 4096 + 321);
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(image.data(), image.size(), 11, 4);
+    TEST_ASSERT_LESS_THAN(image.size() / 2, packed.size());
+
+    TEST_ASSERT_TRUE(sendCompressedStart(ota, packed, image));
+    for (uint32_t i = 0; i < chunkCount(packed); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, packed, i));
+    }
+
+    TEST_ASSERT_TRUE(restarted);
+    TEST_ASSERT_EQUAL_UINT32(image.size(), ota.getWrittenBytes());
+    std::vector<uint8_t> written = readPartition(esp_ota_get_boot_partition(), image.size());
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), written.data(), image.size());
+}
+
+void test_compressed_image_size_mismatch_aborts() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeCompressibleImage(6 * 4096);
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(image.data(), image.size(), 11, 4);
+    // Annoncér et image der er én blok kortere end det der pakkes ud
+    std::vector<uint8_t> announced(image.begin(), image.end() - 4096);
+
+    TEST_ASSERT_TRUE(sendCompressedStart(ota, packed, announced));
+    for (uint32_t i = 0; i < chunkCount(packed); i++) {
+        sendChunk(ota, packed, i);
+    }
+
+    TEST_ASSERT_EQUAL(static_cast<int>(OtaManager::OtaStatus::ERROR), static_cast<int>(ota.getStatus()));
+    TEST_ASSERT_FALSE(restarted);
+}
+
+void test_unknown_compression_is_rejected() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(4096);
+
+    TEST_ASSERT_FALSE(sendCompressedStart(ota, image, image, "lzma"));
+    TEST_ASSERT_FALSE(ota.isInProgress());
+}
+
+void test_delta_transfer_patches_running_firmware() {
+    OtaManager ota;
+    std::vector<uint8_t> base = makeImage(30 * 4096 + 512);
+    std::vector<uint8_t> image = makeNextVersion(base);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(esp_ota_get_running_partition(), 0, base.data(), base.size()));
+
+    std::vector<uint8_t> patch = DeltaEncoder::diff(base.data(), base.size(), image.data(), image.size());
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(patch.data(), patch.size(), 11, 8);
+    TEST_ASSERT_LESS_THAN(image.size() / 10, packed.size());
+
+    TEST_ASSERT_TRUE(sendDeltaStart(ota, packed, image, base, Crc32::update(0, base.data(), base.size())));
+    for (uint32_t i = 0; i < chunkCount(packed); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, packed, i));
+    }
+
+    TEST_ASSERT_TRUE(restarted);
+    TEST_ASSERT_EQUAL_UINT32(image.size(), ota.getWrittenBytes());
+    std::vector<uint8_t> written = readPartition(esp_ota_get_boot_partition(), image.size());
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), written.data(), image.size());
+}
+
+void test_delta_against_other_base_is_rejected() {
+    OtaManager ota;
+    std::vector<uint8_t> base = makeImage(8 * 4096);
+    std::vector<uint8_t> image = makeNextVersion(base);
+    std::vector<uint8_t> running = base;
+    running[1234] ^= 0xFF;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(esp_ota_get_running_partition(), 0, running.data(), running.size()));
+
+    std::vector<uint8_t> patch = DeltaEncoder::diff(base.data(), base.size(), image.data(), image.size());
+    std::vector<uint8_t> packed = HeatshrinkEncoder::encode(patch.data(), patch.size(), 11, 8);
+
+    TEST_ASSERT_FALSE(sendDeltaStart(ota, packed, image, base, Crc32::update(0, base.data(), base.size())));
+    TEST_ASSERT_FALSE(ota.isInProgress());
+}
+
+void test_signed_transfer_verifies_signature() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(6 * 4096 + 10);
+    TEST_ASSERT_TRUE(ota.setSigningKey(signingKeyHex().c_str()));
+
+    TEST_ASSERT_TRUE(sendSignedStart(ota, image, signImage(image)));
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+    TEST_ASSERT_TRUE(restarted);
+}
+
+void test_wrong_signature_is_not_booted() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(6 * 4096 + 10);
+    std::vector<uint8_t> other = image;
+    other[100] ^= 1;
+    TEST_ASSERT_TRUE(ota.setSigningKey(signingKeyHex().c_str()));
+    const esp_partition_t* bootBefore = esp_ota_get_boot_partition();
+
+    // CRC'en passer, men signaturen dækker et andet image
+    TEST_ASSERT_TRUE(sendSignedStart(ota, image, signImage(other)));
+    for (uint32_t i = 0; i < chunkCount(image); i++) {
+        sendChunk(ota, image, i);
+    }
+    TEST_ASSERT_FALSE(restarted);
+    TEST_ASSERT_EQUAL(static_cast<int>(OtaManager::OtaStatus::ERROR), static_cast<int>(ota.getStatus()));
+    TEST_ASSERT_EQUAL_PTR(bootBefore, esp_ota_get_boot_partition());
+}
+
+// Hashen over det allerede skrevne genskabes fra flash ved genoptagelse
+void test_signed_transfer_resumes_after_reboot() {
+    std::vector<uint8_t> image = makeImage(20 * 4096);
+    String signature = signImage(image);
+
+    {
+        OtaManager ota;
+        TEST_ASSERT_TRUE(ota.setSigningKey(signingKeyHex().c_str()));
+        TEST_ASSERT_TRUE(sendSignedStart(ota, image, signature));
+        for (uint32_t i = 0; i < OtaConstants::CHECKPOINT_INTERVAL_CHUNKS + 1; i++) {
+            TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+        }
+        ota.abort("connection lost", true);
+    }
+
+    OtaManager ota;
+    TEST_ASSERT_TRUE(ota.setSigningKey(signingKeyHex().c_str()));
+    ota.begin();
+    TEST_ASSERT_TRUE(sendSignedStart(ota, image, signature));
+    TEST_ASSERT_EQUAL_UINT32(OtaConstants::CHECKPOINT_INTERVAL_CHUNKS * 4096, ota.getReceivedBytes());
+    for (uint32_t i = ota.getNextChunkIndex(); i < chunkCount(image); i++) {
+        TEST_ASSERT_TRUE(sendChunk(ota, image, i));
+    }
+    TEST_ASSERT_TRUE(restarted);
+}
+
+void test_unsigned_image_rejected_when_key_is_set() {
+    OtaManager ota;
+    std::vector<uint8_t> image = makeImage(4096);
+    TEST_ASSERT_TRUE(ota.setSigningKey(signingKeyHex().c_str()));
+
+    TEST_ASSERT_FALSE(sendSignedStart(ota, image, ""));
+    TEST_ASSERT_FALSE(ota.isInProgress());
+    TEST_ASSERT_FALSE(ota.setSigningKey("not-a-key"));
+}
+
+int main() {
+    NativeHal::useVirtualClock(true);
+    NativeHal::setSerialEnabled(false);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_complete_transfer_writes_image_and_reboots);
+    RUN_TEST(test_crc_mismatch_aborts_without_reboot);
+    RUN_TEST(test_slow_flash_reports_backpressure);
+    RUN_TEST(test_backpressure_publish_does_not_corrupt_chunk);
+    RUN_TEST(test_abort_mid_transfer_stops_writer);
+    RUN_TEST(test_resume_after_reboot_continues_from_checkpoint);
+    RUN_TEST(test_resume_discards_checkpoint_when_flash_differs);
+    RUN_TEST(test_repeated_start_during_transfer_requests_resume);
+    RUN_TEST(test_reordered_and_duplicate_chunks_are_written_in_order);
+    RUN_TEST(test_sack_reports_buffered_chunks);
+    RUN_TEST(test_compressed_transfer_writes_unpacked_image);
+    RUN_TEST(test_compressed_image_size_mismatch_aborts);
+    RUN_TEST(test_unknown_compression_is_rejected);
+    RUN_TEST(test_delta_transfer_patches_running_firmware);
+    RUN_TEST(test_delta_against_other_base_is_rejected);
+    RUN_TEST(test_signed_transfer_verifies_signature);
+    RUN_TEST(test_wrong_signature_is_not_booted);
+    RUN_TEST(test_signed_transfer_resumes_after_reboot);
+    RUN_TEST(test_unsigned_image_rejected_when_key_is_set);
+    return UNITY_END();
+}
@@ -0,0 +1,245 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <cstring>
+#include <vector>
+
+#include "config/constants.h"
+#include "config/settings.h"
+#include "hardware/epaper_display.h"
+#include "hardware/sensor_manager.h"
+#include "native_hal.h"
+#include "util/retained.h"
+
+namespace {
+    constexpr uint32_t TEST_MAGIC = 0x54455354;
+
+    // En hel måling ved den givne afstand; stigningen i procent af baseline
+    float measureRise(SensorManager& sensors, uint16_t distance) {
+        NativeHal::setDistance(distance);
+        if (!sensors.collectMultipleSamples()) {
+            return -1.0f; // Ingen gyldige prøver; fanges af testens forventede stigning
+        }
+        return sensors.getCurrentData().currentRisePercent;
+    }
+
+    // Kommandoer og opdateringstilstande controlleren modtager
+    std::vector<uint8_t> commands;
+    std::vector<uint8_t> updateModes;
+
+    void recordSpi(const uint8_t* data, size_t length, bool dataMode) {
+        if (!dataMode) {
+            commands.insert(commands.end(), data, data + length);
+        } else if (!commands.empty() && commands.back() == DisplayConstants::CMD_DISPLAY_UPDATE) {
+            updateModes.push_back(data[0]);
+        }
+    }
+
+    bool sent(uint8_t command) {
+        for (uint8_t c : commands) {
+            if (c == command) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void drawFrame(EpaperDisplay& display, int16_t x) {
+        display.clearBuffers();
+        display.fillRect(x, 20, 30, 30, DisplayConstants::COLOR_BLACK);
+        display.fillRect(200, 60, 20, 10, DisplayConstants::COLOR_RED);
+    }
+
+    // Store nok til at ligge uden for stakken
+    EpaperDisplay beforeSleep;
+    EpaperDisplay afterWake;
+}
+
+void setUp() {
+    NativeHal::setEnvironment(24.0f, 70.0f);
+}
+
+void tearDown() {}
+
+void test_retained_rejects_corruption() {
+    Retained<SensorManager::RetainedState, TEST_MAGIC> retained = {};
+    TEST_ASSERT_FALSE(retained.valid());
+
+    retained.value.baselineDistance = 400;
+    retained.seal();
+    TEST_ASSERT_TRUE(retained.valid());
+
+    // En enkelt vendt bit, som efter et brownout midt i en skrivning
+    reinterpret_cast<uint8_t*>(&retained.value)[1] ^= 0x10;
+    TEST_ASSERT_FALSE(retained.valid());
+
+    retained.seal();
+    retained.invalidate();
+    TEST_ASSERT_FALSE(retained.valid());
+}
+
+void test_settings_resume_without_file() {
+    Settings settings;
+    TEST_ASSERT_TRUE(settings.begin());
+    settings.setAnalyzerId("brodbuddy_test");
+    settings.setMqttServer("broker.example.org");
+    settings.setMqttPort(8883);
+    settings.setMqttPassword("${MQTT_PASSWORD}");
+    settings.setSensorInterval(600);
+    settings.setTempOffset(-2.5f);
+    settings.setFeedingNumber(7);
+
+    Settings::RetainedState state;
+    TEST_ASSERT_TRUE(settings.retain(state));
+
+    Settings resumed;
+    TEST_ASSERT_TRUE(resumed.resume(state));
+    TEST_ASSERT_EQUAL_STRING("brodbuddy_test", resumed.getAnalyzerId().c_str());
+    TEST_ASSERT_EQUAL_STRING("broker.example.org", resumed.getMqttServer().c_str());
+    TEST_ASSERT_EQUAL(8883, resumed.getMqttPort());
+    TEST_ASSERT_EQUAL(settings.getMqttPassword().length(), resumed.getMqttPassword().length());
+    TEST_ASSERT_EQUAL(600, resumed.getSensorInterval());
+    TEST_ASSERT_EQUAL_FLOAT(-2.5f, resumed.getTempOffset());
+    TEST_ASSERT_EQUAL(settings.getLowPowerMode(), resumed.getLowPowerMode());
+    TEST_ASSERT_EQUAL(7, resumed.getFeedingNumber());
+}
+
+void test_settings_resume_copies_strings() {
+    Settings settings;
+    TEST_ASSERT_TRUE(settings.begin());
+    settings.setAnalyzerId("brodbuddy_copy");
+    settings.setMqttServer("broker.example.org");
+    settings.setMqttUser("baker");
+    settings.setMqttPassword("secret");
+
+    Settings::RetainedState state;
+    TEST_ASSERT_TRUE(settings.retain(state));
+    Settings resumed;
+    TEST_ASSERT_TRUE(resumed.resume(state));
+
+    // Som før næste deep sleep: den genoptagne tilstand skrives tilbage i samme RTC struct
+    TEST_ASSERT_TRUE(resumed.retain(state));
+    TEST_ASSERT_EQUAL_STRING("brodbuddy_copy", state.analyzerId);
+    TEST_ASSERT_EQUAL_STRING("broker.example.org", state.mqttServer);
+    TEST_ASSERT_EQUAL_STRING("baker", state.mqttUser);
+    TEST_ASSERT_EQUAL_STRING("secret", state.mqttPassword);
+
+    // Ændringer i RTC kopien må ikke slå igennem i de aktive indstillinger
+    strcpy(state.analyzerId, "changed");
+    strcpy(state.mqttServer, "changed");
+    strcpy(state.mqttUser, "changed");
+    strcpy(state.mqttPassword, "changed");
+    TEST_ASSERT_EQUAL_STRING("brodbuddy_copy", resumed.getAnalyzerId().c_str());
+    TEST_ASSERT_EQUAL_STRING("broker.example.org", resumed.getMqttServer().c_str());
+    TEST_ASSERT_EQUAL_STRING("baker", resumed.getMqttUser().c_str());
+    TEST_ASSERT_EQUAL_STRING("secret", resumed.getMqttPassword().c_str());
+}
+
+void test_settings_too_long_to_retain() {
+    Settings settings;
+    TEST_ASSERT_TRUE(settings.begin());
+    char server[100];
+    memset(server, 'a', sizeof(server) - 1);
+    server[sizeof(server) - 1] = '\0';
+    settings.setMqttServer(server);
+
+    Settings::RetainedState state;
+    TEST_ASSERT_FALSE(settings.retain(state));
+}
+
+void test_sensor_resume_keeps_baseline_and_filters() {
+    SensorManager sensors;
+    sensors.setReadInterval(900000);
+    TEST_ASSERT_TRUE(sensors.begin());
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, measureRise(sensors, 400));
+    measureRise(sensors, 380);
+    float filteredTemp = sensors.getCurrentData().inTemp;
+
+    SensorManager::RetainedState state;
+    sensors.retain(state);
+
+    // Ny instans som efter deep sleep; millis() er begyndt forfra, men målingen skal ske med det samme
+    SensorManager resumed;
+    resumed.setReadInterval(900000);
+    TEST_ASSERT_TRUE(resumed.resume(state));
+    TEST_ASSERT_TRUE(resumed.shouldRead());
+
+    // Stigningen regnes stadig fra den oprindelige baseline, og temperaturfiltret fortsætter
+    NativeHal::setEnvironment(34.0f, 70.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 110.0f, measureRise(resumed, 360));
+    TEST_ASSERT_TRUE(resumed.getCurrentData().inTemp < filteredTemp + 2.0f);
+    TEST_ASSERT_FALSE(resumed.shouldRead());
+}
+
+void test_display_resume_keeps_frame_and_controller() {
+    NativeHal::setSpiSink(recordSpi);
+    beforeSleep.begin();
+    drawFrame(beforeSleep, 10);
+    beforeSleep.updateDisplay();
+    drawFrame(beforeSleep, 40);
+    beforeSleep.updateDisplay();
+    TEST_ASSERT_TRUE(beforeSleep.lastRefreshWasPartial());
+
+    EpaperDisplay::RetainedState state;
+    beforeSleep.retain(state);
+    TEST_ASSERT_TRUE(state.frameShown);
+    TEST_ASSERT_EQUAL(1, state.partialRefreshes);
+
+    // Opvågning: ingen reset og init af controlleren
+    commands.clear();
+    updateModes.clear();
+    afterWake.resume(state);
+    TEST_ASSERT_TRUE(commands.empty());
+
+    // Samme frame som før søvnen sendes ikke
+    drawFrame(afterWake, 40);
+    afterWake.updateDisplay();
+    TEST_ASSERT_TRUE(commands.empty());
+    TEST_ASSERT_EQUAL(1, afterWake.getSkippedRefreshCount());
+    TEST_ASSERT_EQUAL(2, afterWake.getRefreshCount());
+
+    // En ny frame sendes hel, da de viste planer ikke er kendt, men fortsætter med partial refresh
+    drawFrame(afterWake, 70);
+    afterWake.updateDisplay();
+    TEST_ASSERT_FALSE(sent(DisplayConstants::CMD_SWRESET));
+    TEST_ASSERT_FALSE(sent(DisplayConstants::CMD_DRIVER_OUTPUT));
+    TEST_ASSERT_EQUAL(1, updateModes.size());
+    TEST_ASSERT_EQUAL_HEX8(DisplayConstants::PARAM_UPDATE_PARTIAL, updateModes[0]);
+    TEST_ASSERT_TRUE(afterWake.lastRefreshWasPartial());
+
+    // Tællingen fortsætter på tværs af søvnen, så fuld refresh kommer med det sædvanlige interval
+    for (int i = 2; i < DisplayConstants::FULL_REFRESH_INTERVAL; i++) {
+        drawFrame(afterWake, 70 + i);
+        afterWake.updateDisplay();
+        TEST_ASSERT_TRUE(afterWake.lastRefreshWasPartial());
+    }
+    drawFrame(afterWake, 10);
+    afterWake.updateDisplay();
+    TEST_ASSERT_FALSE(afterWake.lastRefreshWasPartial());
+    NativeHal::setSpiSink(nullptr);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_retained_rejects_corruption);
+    RUN_TEST(test_settings_resume_without_file);
+    RUN_TEST(test_settings_resume_copies_strings);
+    RUN_TEST(test_settings_too_long_to_retain);
+    RUN_TEST(test_sensor_resume_keeps_baseline_and_filters);
+    RUN_TEST(test_display_resume_keeps_frame_and_controller);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    NativeHal::useVirtualClock(true);
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
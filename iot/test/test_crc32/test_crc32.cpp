@@ -0,0 +1,112 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "network/crc32.h"
+
+namespace {
+    // Deterministisk pseudo-tilfældigt indhold, så fejl kan reproduceres
+    std::vector<uint8_t> makeBuffer(size_t length, uint32_t seed) {
+        std::vector<uint8_t> buffer(length);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1664525 + 1013904223;
+            buffer[i] = static_cast<uint8_t>(seed >> 24);
+        }
+        return buffer;
+    }
+
+    const uint8_t CHECK_INPUT[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    constexpr uint32_t CHECK_VALUE = 0xCBF43926;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_known_check_value() {
+    TEST_ASSERT_EQUAL_HEX32(CHECK_VALUE, Crc32::updateBitwise(0, CHECK_INPUT, sizeof(CHECK_INPUT)));
+    TEST_ASSERT_EQUAL_HEX32(CHECK_VALUE, Crc32::updateSliceBy8(0, CHECK_INPUT, sizeof(CHECK_INPUT)));
+    TEST_ASSERT_EQUAL_HEX32(CHECK_VALUE, Crc32::update(0, CHECK_INPUT, sizeof(CHECK_INPUT)));
+}
+
+void test_empty_input_keeps_crc() {
+    TEST_ASSERT_EQUAL_HEX32(0, Crc32::update(0, nullptr, 0));
+    TEST_ASSERT_EQUAL_HEX32(CHECK_VALUE, Crc32::updateSliceBy8(CHECK_VALUE, nullptr, 0));
+}
+
+void test_slice_by_8_matches_bitwise_for_all_alignments() {
+    std::vector<uint8_t> buffer = makeBuffer(1100, 1);
+
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t length = 0; length <= 1030; length += 17) {
+            uint32_t expected = Crc32::updateBitwise(0, buffer.data() + offset, length);
+            TEST_ASSERT_EQUAL_HEX32(expected, Crc32::updateSliceBy8(0, buffer.data() + offset, length));
+        }
+    }
+}
+
+void test_chained_updates_match_single_pass() {
+    std::vector<uint8_t> buffer = makeBuffer(64, 2);
+    uint32_t expected = Crc32::updateBitwise(0, buffer.data(), buffer.size());
+
+    for (size_t split = 0; split <= buffer.size(); split++) {
+        uint32_t crc = Crc32::update(0, buffer.data(), split);
+        crc = Crc32::update(crc, buffer.data() + split, buffer.size() - split);
+        TEST_ASSERT_EQUAL_HEX32(expected, crc);
+    }
+}
+
+// Som OtaManager bruger den: 4 KB chunks kædet over et helt image
+void test_selected_backend_matches_reference_over_ota_chunks() {
+    std::vector<uint8_t> image = makeBuffer(64 * 1024 + 123, 3);
+    uint32_t expected = Crc32::updateBitwise(0, image.data(), image.size());
+
+    uint32_t crc = 0;
+    for (size_t offset = 0; offset < image.size(); offset += 4096) {
+        size_t length = std::min<size_t>(4096, image.size() - offset);
+        crc = Crc32::update(crc, image.data() + offset, length);
+    }
+    TEST_ASSERT_EQUAL_HEX32(expected, crc);
+}
+
+#if CRC32_ROM_BACKEND
+void test_rom_matches_slice_by_8() {
+    std::vector<uint8_t> buffer = makeBuffer(4096 + 7, 4);
+
+    for (size_t offset = 0; offset < 8; offset++) {
+        size_t length = buffer.size() - offset;
+        TEST_ASSERT_EQUAL_HEX32(Crc32::updateSliceBy8(0, buffer.data() + offset, length),
+                                Crc32::updateRom(0, buffer.data() + offset, length));
+    }
+    TEST_ASSERT_EQUAL_HEX32(Crc32::updateSliceBy8(0x12345678, buffer.data(), 100),
+                            Crc32::updateRom(0x12345678, buffer.data(), 100));
+}
+#endif
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_known_check_value);
+    RUN_TEST(test_empty_input_keeps_crc);
+    RUN_TEST(test_slice_by_8_matches_bitwise_for_all_alignments);
+    RUN_TEST(test_chained_updates_match_single_pass);
+    RUN_TEST(test_selected_backend_matches_reference_over_ota_chunks);
+#if CRC32_ROM_BACKEND
+    RUN_TEST(test_rom_matches_slice_by_8);
+#endif
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
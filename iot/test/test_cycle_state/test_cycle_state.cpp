@@ -0,0 +1,72 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "app/state_machine.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_sampling_comes_first() {
+    CycleProgress cycle = {};
+    TEST_ASSERT_EQUAL(STATE_SENSING, nextCycleState(cycle, false, false));
+    TEST_ASSERT_EQUAL(STATE_SENSING, nextCycleState(cycle, true, false));
+    TEST_ASSERT_EQUAL(STATE_SENSING, nextCycleState(cycle, true, true));
+}
+
+void test_mqtt_ready_before_sampling_ends() {
+    CycleProgress cycle = {true, false, false};
+
+    // Forbindelsen holdt fra forrige cyklus: publicering først, så skærmen kan bruge light sleep
+    TEST_ASSERT_EQUAL(STATE_PUBLISHING_DATA, nextCycleState(cycle, true, true));
+    cycle.published = true;
+    TEST_ASSERT_EQUAL(STATE_UPDATING_DISPLAY, nextCycleState(cycle, true, true));
+    cycle.displayed = true;
+    TEST_ASSERT_EQUAL(STATE_SLEEP, nextCycleState(cycle, true, true));
+}
+
+void test_display_first_then_publish() {
+    CycleProgress cycle = {true, false, false};
+
+    // Skærmen venter ikke på netværket, heller ikke når WiFi er oppe men MQTT mangler
+    TEST_ASSERT_EQUAL(STATE_UPDATING_DISPLAY, nextCycleState(cycle, false, false));
+    TEST_ASSERT_EQUAL(STATE_UPDATING_DISPLAY, nextCycleState(cycle, true, false));
+    cycle.displayed = true;
+
+    // Derefter WiFi, MQTT og publicering fra tilstandsmaskinen
+    TEST_ASSERT_EQUAL(STATE_CONNECTING_WIFI, nextCycleState(cycle, false, false));
+    TEST_ASSERT_EQUAL(STATE_CONNECTING_MQTT, nextCycleState(cycle, true, false));
+    TEST_ASSERT_EQUAL(STATE_PUBLISHING_DATA, nextCycleState(cycle, true, true));
+    cycle.published = true;
+    TEST_ASSERT_EQUAL(STATE_SLEEP, nextCycleState(cycle, true, true));
+}
+
+void test_sleep_without_network_only_after_publish() {
+    CycleProgress cycle = {true, true, false};
+    TEST_ASSERT_EQUAL(STATE_CONNECTING_WIFI, nextCycleState(cycle, false, false));
+
+    // WiFi kan være faldet ud efter publicering; cyklussen er stadig færdig
+    cycle.published = true;
+    TEST_ASSERT_EQUAL(STATE_SLEEP, nextCycleState(cycle, false, false));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sampling_comes_first);
+    RUN_TEST(test_mqtt_ready_before_sampling_ends);
+    RUN_TEST(test_display_first_then_publish);
+    RUN_TEST(test_sleep_without_network_only_after_publish);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
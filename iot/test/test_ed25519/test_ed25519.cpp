@@ -0,0 +1,129 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <cstring>
+#include <vector>
+
+#include "network/ed25519.h"
+#include "network/sha256.h"
+
+namespace {
+    // RFC 8032 afsnit 7.1, TEST 1 (tom besked) og TEST 2 (én byte)
+    const uint8_t SEED_1[] = {0x9d, 0x61, 0xb1, 0x9d, 0xef, 0xfd, 0x5a, 0x60, 0xba, 0x84, 0x4a,
+                              0xf4, 0x92, 0xec, 0x2c, 0xc4, 0x44, 0x49, 0xc5, 0x69, 0x7b, 0x32,
+                              0x69, 0x19, 0x70, 0x3b, 0xac, 0x03, 0x1c, 0xae, 0x7f, 0x60};
+    const uint8_t PUBLIC_KEY_1[] = {0xd7, 0x5a, 0x98, 0x01, 0x82, 0xb1, 0x0a, 0xb7, 0xd5, 0x4b, 0xfe,
+                                    0xd3, 0xc9, 0x64, 0x07, 0x3a, 0x0e, 0xe1, 0x72, 0xf3, 0xda, 0xa6,
+                                    0x23, 0x25, 0xaf, 0x02, 0x1a, 0x68, 0xf7, 0x07, 0x51, 0x1a};
+    const uint8_t SIGNATURE_1[] = {0xe5, 0x56, 0x43, 0x00, 0xc3, 0x60, 0xac, 0x72, 0x90, 0x86, 0xe2, 0xcc, 0x80,
+                                   0x6e, 0x82, 0x8a, 0x84, 0x87, 0x7f, 0x1e, 0xb8, 0xe5, 0xd9, 0x74, 0xd8, 0x73,
+                                   0xe0, 0x65, 0x22, 0x49, 0x01, 0x55, 0x5f, 0xb8, 0x82, 0x15, 0x90, 0xa3, 0x3b,
+                                   0xac, 0xc6, 0x1e, 0x39, 0x70, 0x1c, 0xf9, 0xb4, 0x6b, 0xd2, 0x5b, 0xf5, 0xf0,
+                                   0x59, 0x5b, 0xbe, 0x24, 0x65, 0x51, 0x41, 0x43, 0x8e, 0x7a, 0x10, 0x0b};
+
+    const uint8_t SEED_2[] = {0x4c, 0xcd, 0x08, 0x9b, 0x28, 0xff, 0x96, 0xda, 0x9d, 0xb6, 0xc3,
+                              0x46, 0xec, 0x11, 0x4e, 0x0f, 0x5b, 0x8a, 0x31, 0x9f, 0x35, 0xab,
+                              0xa6, 0x24, 0xda, 0x8c, 0xf6, 0xed, 0x4f, 0xb8, 0xa6, 0xfb};
+    const uint8_t PUBLIC_KEY_2[] = {0x3d, 0x40, 0x17, 0xc3, 0xe8, 0x43, 0x89, 0x5a, 0x92, 0xb7, 0x0a,
+                                    0xa7, 0x4d, 0x1b, 0x7e, 0xbc, 0x9c, 0x98, 0x2c, 0xcf, 0x2e, 0xc4,
+                                    0x96, 0x8c, 0xc0, 0xcd, 0x55, 0xf1, 0x2a, 0xf4, 0x66, 0x0c};
+    const uint8_t MESSAGE_2[] = {0x72};
+    const uint8_t SIGNATURE_2[] = {0x92, 0xa0, 0x09, 0xa9, 0xf0, 0xd4, 0xca, 0xb8, 0x72, 0x0e, 0x82, 0x0b, 0x5f,
+                                   0x64, 0x25, 0x40, 0xa2, 0xb2, 0x7b, 0x54, 0x16, 0x50, 0x3f, 0x8f, 0xb3, 0x76,
+                                   0x22, 0x23, 0xeb, 0xdb, 0x69, 0xda, 0x08, 0x5a, 0xc1, 0xe4, 0x3e, 0x15, 0x99,
+                                   0x6e, 0x45, 0x8f, 0x36, 0x13, 0xd0, 0xf1, 0x1d, 0x8c, 0x38, 0x7b, 0x2e, 0xae,
+                                   0xb4, 0x30, 0x2a, 0xee, 0xb0, 0x0d, 0x29, 0x16, 0x12, 0xbb, 0x0c, 0x00};
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_rfc8032_vectors_sign_and_verify() {
+    uint8_t publicKey[Ed25519::PUBLIC_KEY_SIZE];
+    uint8_t signature[Ed25519::SIGNATURE_SIZE];
+
+    Ed25519::derivePublicKey(SEED_1, publicKey);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(PUBLIC_KEY_1, publicKey, sizeof(publicKey));
+    Ed25519::sign(SEED_1, nullptr, 0, signature);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(SIGNATURE_1, signature, sizeof(signature));
+    TEST_ASSERT_TRUE(Ed25519::verify(SIGNATURE_1, nullptr, 0, PUBLIC_KEY_1));
+
+    Ed25519::derivePublicKey(SEED_2, publicKey);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(PUBLIC_KEY_2, publicKey, sizeof(publicKey));
+    Ed25519::sign(SEED_2, MESSAGE_2, sizeof(MESSAGE_2), signature);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(SIGNATURE_2, signature, sizeof(signature));
+    TEST_ASSERT_TRUE(Ed25519::verify(SIGNATURE_2, MESSAGE_2, sizeof(MESSAGE_2), PUBLIC_KEY_2));
+}
+
+void test_verify_rejects_tampering() {
+    const uint8_t other[] = {0x73};
+    uint8_t signature[Ed25519::SIGNATURE_SIZE];
+
+    TEST_ASSERT_FALSE(Ed25519::verify(SIGNATURE_2, other, sizeof(other), PUBLIC_KEY_2));
+    TEST_ASSERT_FALSE(Ed25519::verify(SIGNATURE_2, MESSAGE_2, sizeof(MESSAGE_2), PUBLIC_KEY_1));
+
+    for (size_t i = 0; i < sizeof(signature); i += 9) {
+        memcpy(signature, SIGNATURE_2, sizeof(signature));
+        signature[i] ^= 0x04;
+        TEST_ASSERT_FALSE(Ed25519::verify(signature, MESSAGE_2, sizeof(MESSAGE_2), PUBLIC_KEY_2));
+    }
+}
+
+// s + L giver samme punkt, men er ikke kanonisk og skal afvises
+void test_verify_rejects_non_canonical_scalar() {
+    const uint8_t order[] = {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7,
+                             0xa2, 0xde, 0xf9, 0xde, 0x14, 0,    0,    0,    0,    0,    0,
+                             0,    0,    0,    0,    0,    0,    0,    0,    0,    0x10};
+    uint8_t signature[Ed25519::SIGNATURE_SIZE];
+    memcpy(signature, SIGNATURE_2, sizeof(signature));
+
+    unsigned carry = 0;
+    for (size_t i = 0; i < 32; i++) {
+        unsigned sum = signature[32 + i] + order[i] + carry;
+        signature[32 + i] = static_cast<uint8_t>(sum);
+        carry = sum >> 8;
+    }
+    TEST_ASSERT_FALSE(Ed25519::verify(signature, MESSAGE_2, sizeof(MESSAGE_2), PUBLIC_KEY_2));
+}
+
+// Som OtaManager bruger den: signaturen dækker imagets SHA-256
+void test_signed_image_digest_round_trip() {
+    std::vector<uint8_t> image(20000);
+    for (size_t i = 0; i < image.size(); i++) {
+        image[i] = static_cast<uint8_t>(i * 7);
+    }
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    Sha256::hash(image.data(), image.size(), digest);
+
+    uint8_t signature[Ed25519::SIGNATURE_SIZE];
+    uint8_t publicKey[Ed25519::PUBLIC_KEY_SIZE];
+    Ed25519::sign(SEED_1, digest, sizeof(digest), signature);
+    Ed25519::derivePublicKey(SEED_1, publicKey);
+    TEST_ASSERT_TRUE(Ed25519::verify(signature, digest, sizeof(digest), publicKey));
+
+    digest[0] ^= 1;
+    TEST_ASSERT_FALSE(Ed25519::verify(signature, digest, sizeof(digest), publicKey));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rfc8032_vectors_sign_and_verify);
+    RUN_TEST(test_verify_rejects_tampering);
+    RUN_TEST(test_verify_rejects_non_canonical_scalar);
+    RUN_TEST(test_signed_image_digest_round_trip);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
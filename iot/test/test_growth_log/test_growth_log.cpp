@@ -0,0 +1,240 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "app/growth_log.h"
+
+namespace {
+    GrowthLog growthLog;
+    std::vector<GrowthSample> appended;
+
+    // Bytes pr. punkt i den ukomprimerede historik på target (int og 32 bit unsigned long)
+    constexpr size_t RAW_SAMPLE_BYTES = 8;
+
+    std::vector<GrowthSample> decode() {
+        std::vector<GrowthSample> samples;
+        GrowthLog::Reader reader(growthLog);
+        GrowthSample sample;
+        while (reader.next(sample)) {
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    void append(unsigned long timestamp, int growth) {
+        size_t before = growthLog.size();
+        size_t dropped = growthLog.append(timestamp, growth);
+        appended.push_back({timestamp, growth});
+        TEST_ASSERT_EQUAL(before + 1 - dropped, growthLog.size());
+    }
+
+    // Loggen skal altid være de nyeste punkter, i rækkefølge og uden huller
+    void assertHoldsNewest() {
+        std::vector<GrowthSample> samples = decode();
+        TEST_ASSERT_EQUAL(growthLog.size(), samples.size());
+        TEST_ASSERT_TRUE(samples.size() <= appended.size());
+        size_t offset = appended.size() - samples.size();
+        for (size_t i = 0; i < samples.size(); i++) {
+            TEST_ASSERT_TRUE(samples[i] == appended[offset + i]);
+        }
+        if (!samples.empty()) {
+            TEST_ASSERT_TRUE(growthLog.oldest() == samples.front());
+            TEST_ASSERT_TRUE(growthLog.newest() == samples.back());
+        }
+    }
+}
+
+void setUp() {
+    growthLog.clear();
+    appended.clear();
+}
+
+void tearDown() {}
+
+void test_empty_log() {
+    GrowthLog fresh = {};
+    GrowthSample sample;
+    TEST_ASSERT_TRUE(fresh.empty());
+    TEST_ASSERT_EQUAL(0, fresh.size());
+    TEST_ASSERT_FALSE(fresh.peak(sample, 0));
+    GrowthLog::Reader reader(fresh);
+    TEST_ASSERT_FALSE(reader.next(sample));
+}
+
+void test_regular_samples_take_one_byte() {
+    // 5 minutter ±1 s og få procents ændring, som fra sensoren
+    unsigned long timestamp = 1700000000UL;
+    int growth = 100;
+    for (int i = 0; i < 200; i++) {
+        timestamp += 300 + (i % 3) - 1;
+        growth += (i % 5) - 1;
+        append(timestamp, growth);
+    }
+    assertHoldsNewest();
+
+    size_t rawBytes = growthLog.size() * RAW_SAMPLE_BYTES;
+    TEST_ASSERT_TRUE(growthLog.size() > 300 / 2);
+    TEST_ASSERT_TRUE(rawBytes >= 4 * growthLog.encodedBytes());
+}
+
+void test_irregular_samples_round_trip() {
+    uint32_t seed = 99;
+    unsigned long timestamp = 1000;
+    int growth = 0;
+
+    // Store spring i tid og vækst, ur der går baglæns og negative værdier
+    for (int i = 0; i < 3000; i++) {
+        seed = seed * 1664525 + 1013904223;
+        switch (seed >> 29) {
+            case 0:
+                timestamp += seed % 100000;
+                break;
+            case 1:
+                timestamp -= seed % 50;
+                break;
+            default:
+                timestamp += 15 + seed % 3;
+                break;
+        }
+        growth += static_cast<int>((seed >> 8) % 21) - 10;
+        if (seed % 97 == 0) {
+            growth = -growth * 1000;
+        }
+        append(timestamp, growth);
+        assertHoldsNewest();
+    }
+}
+
+void test_timestamps_that_wrap() {
+    unsigned long timestamp = static_cast<unsigned long>(-1) - 600;
+    for (int i = 0; i < 10; i++) {
+        append(timestamp, 100 + i);
+        timestamp += 120;
+    }
+    assertHoldsNewest();
+    TEST_ASSERT_TRUE(growthLog.newest().timestamp < growthLog.oldest().timestamp);
+}
+
+void test_full_log_drops_oldest_block() {
+    unsigned long timestamp = 0;
+    size_t dropped = 0;
+    size_t oldestBlockCount = 0;
+    while (dropped == 0) {
+        oldestBlockCount = growthLog.empty() ? 0 : growthLog.block(0).count;
+        timestamp += 60;
+        dropped = growthLog.append(timestamp, 100);
+        appended.push_back({timestamp, 100});
+    }
+    TEST_ASSERT_EQUAL(MonitoringConstants::HISTORY_BLOCKS, growthLog.blockCount());
+    TEST_ASSERT_EQUAL(oldestBlockCount, dropped);
+    // Første punkt efter starten koster et escape; resten ét byte hver
+    TEST_ASSERT_EQUAL(MonitoringConstants::HISTORY_BLOCK_BYTES - 1, dropped);
+    assertHoldsNewest();
+}
+
+void test_peak_is_oldest_maximum_since() {
+    uint32_t seed = 5;
+    unsigned long timestamp = 0;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1664525 + 1013904223;
+        timestamp += 300;
+        append(timestamp, static_cast<int>((seed >> 20) % 40));
+
+        // Hele loggen, vinduer der starter midt i en blok, og et vindue med kun det nyeste punkt
+        const unsigned long windows[] = {timestamp + 1, 12 * 3600UL, 3 * 3600UL + 150, 1};
+        for (unsigned long window : windows) {
+            unsigned long since = timestamp - (window - 1);
+            GrowthSample expected = {0, 0};
+            bool first = true;
+            for (const GrowthSample& sample : decode()) {
+                if (sample.timestamp - since <= timestamp - since && (first || sample.growth > expected.growth)) {
+                    expected = sample;
+                    first = false;
+                }
+            }
+            GrowthSample peak;
+            TEST_ASSERT_TRUE(growthLog.peak(peak, since));
+            TEST_ASSERT_TRUE(expected == peak);
+        }
+    }
+}
+
+void test_bucket_peaks_cover_whole_log() {
+    size_t visited = 0;
+    unsigned long emptyBucket = growthLog.forEachBucketPeak(10, [&](const GrowthSample&) { visited++; });
+    TEST_ASSERT_EQUAL(0, emptyBucket);
+    TEST_ASSERT_EQUAL(0, visited);
+
+    // Fyld loggen med 5 minutters målinger der svinger som en dej, så den dækker mere end displayets 12 timer
+    uint32_t seed = 7;
+    unsigned long timestamp = 1700000000UL;
+    int growth = 100;
+    while (growthLog.blockCount() < MonitoringConstants::HISTORY_BLOCKS) {
+        seed = seed * 1664525 + 1013904223;
+        timestamp += 300;
+        growth += static_cast<int>((seed >> 20) % 15) - 7;
+        append(timestamp, growth);
+    }
+    std::vector<GrowthSample> samples = decode();
+    unsigned long start = samples.front().timestamp;
+    TEST_ASSERT_TRUE(samples.back().timestamp - start >= 48 * 3600UL);
+
+    // Referencen: ældste maksimum i hvert interval, i rækkefølge
+    const size_t buckets = 96;
+    unsigned long bucketSeconds = (samples.back().timestamp - start) / buckets + 1;
+    std::vector<GrowthSample> expected;
+    for (const GrowthSample& sample : samples) {
+        size_t index = (sample.timestamp - start) / bucketSeconds;
+        if (expected.empty() || (expected.back().timestamp - start) / bucketSeconds != index) {
+            expected.push_back(sample);
+        } else if (sample.growth > expected.back().growth) {
+            expected.back() = sample;
+        }
+    }
+
+    std::vector<GrowthSample> points;
+    unsigned long actualSeconds = growthLog.forEachBucketPeak(buckets, [&](const GrowthSample& sample) {
+        points.push_back(sample);
+    });
+    TEST_ASSERT_EQUAL(bucketSeconds, actualSeconds);
+    TEST_ASSERT_EQUAL(buckets, points.size());
+    TEST_ASSERT_EQUAL(expected.size(), points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        TEST_ASSERT_TRUE(expected[i] == points[i]);
+    }
+
+    // Den samlede peak går ikke tabt i nedsamplingen
+    GrowthSample peak;
+    TEST_ASSERT_TRUE(growthLog.peak(peak, start));
+    bool found = false;
+    for (const GrowthSample& sample : points) {
+        found = found || sample == peak;
+    }
+    TEST_ASSERT_TRUE(found);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_log);
+    RUN_TEST(test_regular_samples_take_one_byte);
+    RUN_TEST(test_irregular_samples_round_trip);
+    RUN_TEST(test_timestamps_that_wrap);
+    RUN_TEST(test_full_log_drops_oldest_block);
+    RUN_TEST(test_peak_is_oldest_maximum_since);
+    RUN_TEST(test_bucket_peaks_cover_whole_log);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,136 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <deque>
+#include <vector>
+
+#include "util/ring_buffer.h"
+
+namespace {
+    using Buffer = RingBuffer<int, 8>;
+
+    // Indholdet via segmenterne, som en kopi til flash eller et checksum ville læse det
+    std::vector<int> fromSegments(const Buffer& buffer) {
+        std::vector<int> values;
+        for (int value : buffer.firstSegment()) {
+            values.push_back(value);
+        }
+        for (int value : buffer.secondSegment()) {
+            values.push_back(value);
+        }
+        return values;
+    }
+
+    void assertMatches(const std::deque<int>& expected, const Buffer& buffer) {
+        TEST_ASSERT_EQUAL(expected.size(), buffer.size());
+        TEST_ASSERT_EQUAL(expected.empty(), buffer.empty());
+        TEST_ASSERT_EQUAL(expected.size() == Buffer::capacity(), buffer.full());
+
+        std::vector<int> iterated(buffer.begin(), buffer.end());
+        std::vector<int> segmented = fromSegments(buffer);
+        TEST_ASSERT_TRUE(std::vector<int>(expected.begin(), expected.end()) == iterated);
+        TEST_ASSERT_TRUE(iterated == segmented);
+
+        for (size_t i = 0; i < expected.size(); i++) {
+            TEST_ASSERT_EQUAL(expected[i], buffer[i]);
+        }
+        if (!expected.empty()) {
+            TEST_ASSERT_EQUAL(expected.front(), buffer.front());
+            TEST_ASSERT_EQUAL(expected.back(), buffer.back());
+        }
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_value_initialized_buffer_is_empty() {
+    Buffer buffer = {};
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_EQUAL(0, buffer.size());
+    TEST_ASSERT_TRUE(buffer.begin() == buffer.end());
+    TEST_ASSERT_EQUAL(0, buffer.firstSegment().size);
+    TEST_ASSERT_EQUAL(0, buffer.secondSegment().size);
+}
+
+void test_push_overwrites_oldest_when_full() {
+    Buffer buffer = {};
+    for (int i = 0; i < 11; i++) {
+        buffer.pushBack(i);
+    }
+
+    TEST_ASSERT_TRUE(buffer.full());
+    TEST_ASSERT_EQUAL(3, buffer.front());
+    TEST_ASSERT_EQUAL(10, buffer.back());
+    // Wrappet: 3..7 ligger sidst i lageret, 8..10 først
+    TEST_ASSERT_EQUAL(5, buffer.firstSegment().size);
+    TEST_ASSERT_EQUAL(3, buffer.secondSegment().size);
+}
+
+void test_matches_deque_under_random_operations() {
+    Buffer buffer = {};
+    std::deque<int> expected;
+    uint32_t seed = 7;
+
+    for (int i = 0; i < 5000; i++) {
+        seed = seed * 1664525 + 1013904223;
+        uint32_t operation = (seed >> 24) % 8;
+
+        if (operation < 5) {
+            if (expected.size() == Buffer::capacity()) {
+                expected.pop_front();
+            }
+            expected.push_back(i);
+            buffer.pushBack(i);
+        } else if (operation == 5 && !expected.empty()) {
+            expected.pop_front();
+            buffer.popFront();
+        } else if (operation == 6 && !expected.empty()) {
+            expected.pop_back();
+            buffer.popBack();
+        } else if (operation == 7 && seed % 50 == 0) {
+            expected.clear();
+            buffer.clear();
+        }
+        assertMatches(expected, buffer);
+    }
+}
+
+void test_iterator_writes_through() {
+    Buffer buffer = {};
+    for (int i = 0; i < 10; i++) {
+        buffer.pushBack(i);
+    }
+    for (int& value : buffer) {
+        value *= 10;
+    }
+    TEST_ASSERT_EQUAL(20, buffer.front());
+    TEST_ASSERT_EQUAL(90, buffer.back());
+
+    auto it = buffer.end();
+    --it;
+    TEST_ASSERT_EQUAL(90, *it);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_value_initialized_buffer_is_empty);
+    RUN_TEST(test_push_overwrites_oldest_when_full);
+    RUN_TEST(test_matches_deque_under_random_operations);
+    RUN_TEST(test_iterator_writes_through);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,104 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "network/sha256.h"
+
+namespace {
+    // Deterministisk pseudo-tilfældigt indhold, så fejl kan reproduceres
+    std::vector<uint8_t> makeBuffer(size_t length, uint32_t seed) {
+        std::vector<uint8_t> buffer(length);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1664525 + 1013904223;
+            buffer[i] = static_cast<uint8_t>(seed >> 24);
+        }
+        return buffer;
+    }
+
+    void hashString(const char* text, uint8_t digest[Sha256::DIGEST_SIZE]) {
+        Sha256::hash(reinterpret_cast<const uint8_t*>(text), strlen(text), digest);
+    }
+
+    // FIPS 180-2 eksempler
+    const uint8_t EMPTY_DIGEST[] = {0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4,
+                                    0xc8, 0x99, 0x6f, 0xb9, 0x24, 0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b,
+                                    0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55};
+    const uint8_t ABC_DIGEST[] = {0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40,
+                                  0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17,
+                                  0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad};
+    const uint8_t TWO_BLOCK_DIGEST[] = {0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26,
+                                        0x93, 0x0c, 0x3e, 0x60, 0x39, 0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff,
+                                        0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1};
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_known_digests() {
+    uint8_t digest[Sha256::DIGEST_SIZE];
+
+    hashString("", digest);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(EMPTY_DIGEST, digest, Sha256::DIGEST_SIZE);
+    hashString("abc", digest);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ABC_DIGEST, digest, Sha256::DIGEST_SIZE);
+    // 56 bytes: længden skal i en ekstra blok
+    hashString("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", digest);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(TWO_BLOCK_DIGEST, digest, Sha256::DIGEST_SIZE);
+}
+
+void test_split_updates_match_single_pass() {
+    std::vector<uint8_t> buffer = makeBuffer(300, 1);
+    uint8_t expected[Sha256::DIGEST_SIZE];
+    Sha256::hash(buffer.data(), buffer.size(), expected);
+
+    for (size_t split = 0; split <= buffer.size(); split += 7) {
+        Sha256 sha;
+        sha.update(buffer.data(), split);
+        sha.update(buffer.data() + split, buffer.size() - split);
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        sha.finish(digest);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, digest, Sha256::DIGEST_SIZE);
+    }
+}
+
+// Som OtaManager bruger den: 4 KB chunks og en kort hale, og instansen genbruges efter finish
+void test_reused_instance_over_ota_chunks() {
+    std::vector<uint8_t> image = makeBuffer(64 * 1024 + 123, 2);
+    uint8_t expected[Sha256::DIGEST_SIZE];
+    Sha256::hash(image.data(), image.size(), expected);
+
+    Sha256 sha;
+    for (int round = 0; round < 2; round++) {
+        for (size_t offset = 0; offset < image.size(); offset += 4096) {
+            sha.update(image.data() + offset, std::min<size_t>(4096, image.size() - offset));
+        }
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        sha.finish(digest);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, digest, Sha256::DIGEST_SIZE);
+    }
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_known_digests);
+    RUN_TEST(test_split_updates_match_single_pass);
+    RUN_TEST(test_reused_instance_over_ota_chunks);
+    return UNITY_END();
+}
+
+#ifdef NATIVE_BUILD
+int main() {
+    return runUnityTests();
+}
+#else
+void setup() {
+    delay(2000); // Giv serial monitoren tid til at forbinde
+    runUnityTests();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,177 @@
+#include "delta_encoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "network/crc32.h"
+
+namespace {
+    using Index = int64_t;
+
+    void appendLe32(std::vector<uint8_t>& out, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    // Suffix array med prefix doubling. Indeholder også det tomme suffix (index size), som altid sorteres først.
+    std::vector<Index> suffixArray(const uint8_t* data, Index size) {
+        std::vector<Index> suffixes(size + 1);
+        std::vector<Index> rank(size + 1);
+        std::vector<Index> next(size + 1);
+
+        for (Index i = 0; i <= size; i++) {
+            suffixes[i] = i;
+            rank[i] = i < size ? data[i] : -1;
+        }
+
+        for (Index step = 1;; step <<= 1) {
+            auto key = [&](Index i) { return i + step <= size ? rank[i + step] : -1; };
+            auto less = [&](Index a, Index b) {
+                return rank[a] != rank[b] ? rank[a] < rank[b] : key(a) < key(b);
+            };
+            std::sort(suffixes.begin(), suffixes.end(), less);
+
+            next[suffixes[0]] = 0;
+            for (Index i = 1; i <= size; i++) {
+                next[suffixes[i]] = next[suffixes[i - 1]] + (less(suffixes[i - 1], suffixes[i]) ? 1 : 0);
+            }
+            rank.swap(next);
+            if (rank[suffixes[size]] == size) {
+                break;
+            }
+        }
+        return suffixes;
+    }
+
+    Index matchLength(const uint8_t* a, Index aSize, const uint8_t* b, Index bSize) {
+        Index i = 0;
+        while (i < aSize && i < bSize && a[i] == b[i]) {
+            i++;
+        }
+        return i;
+    }
+
+    // Længste match af image[0..] i basen via binær søgning i suffix arrayet
+    Index search(const std::vector<Index>& suffixes, const uint8_t* base, Index baseSize, const uint8_t* image,
+                 Index imageSize, Index start, Index end, Index& position) {
+        while (end - start >= 2) {
+            Index middle = start + (end - start) / 2;
+            Index length = std::min(baseSize - suffixes[middle], imageSize);
+            if (memcmp(base + suffixes[middle], image, length) < 0) {
+                start = middle;
+            } else {
+                end = middle;
+            }
+        }
+
+        Index x = matchLength(base + suffixes[start], baseSize - suffixes[start], image, imageSize);
+        Index y = matchLength(base + suffixes[end], baseSize - suffixes[end], image, imageSize);
+        position = x > y ? suffixes[start] : suffixes[end];
+        return std::max(x, y);
+    }
+}
+
+namespace DeltaEncoder {
+    std::vector<uint8_t> diff(const uint8_t* base, size_t baseSize, const uint8_t* image, size_t imageSize) {
+        const Index oldSize = static_cast<Index>(baseSize);
+        const Index newSize = static_cast<Index>(imageSize);
+        const uint8_t* old = base;
+        const uint8_t* current = image;
+
+        std::vector<uint8_t> patch;
+        patch.insert(patch.end(), {'B', 'D', 'P', '1'});
+        appendLe32(patch, static_cast<uint32_t>(imageSize));
+        appendLe32(patch, static_cast<uint32_t>(baseSize));
+        appendLe32(patch, Crc32::update(0, base, baseSize));
+
+        std::vector<Index> suffixes = suffixArray(old, oldSize);
+
+        Index scan = 0, length = 0, position = 0;
+        Index lastScan = 0, lastPosition = 0, lastOffset = 0;
+
+        while (scan < newSize) {
+            Index oldScore = 0;
+            Index scoreScan = scan += length;
+
+            for (; scan < newSize; scan++) {
+                length = search(suffixes, old, oldSize, current + scan, newSize - scan, 0, oldSize, position);
+
+                for (; scoreScan < scan + length; scoreScan++) {
+                    if (scoreScan + lastOffset < oldSize && old[scoreScan + lastOffset] == current[scoreScan]) {
+                        oldScore++;
+                    }
+                }
+                if ((length == oldScore && length != 0) || length > oldScore + 8) {
+                    break;
+                }
+                if (scan + lastOffset < oldSize && old[scan + lastOffset] == current[scan]) {
+                    oldScore--;
+                }
+            }
+
+            if (length == oldScore && scan != newSize) {
+                continue;
+            }
+
+            // Udvid det forrige match fremad og det nye bagud så længe over halvdelen af bytes stemmer
+            Index forwardLength = 0;
+            for (Index i = 0, score = 0, best = 0; lastScan + i < scan && lastPosition + i < oldSize;) {
+                if (old[lastPosition + i] == current[lastScan + i]) score++;
+                i++;
+                if (score * 2 - i > best * 2 - forwardLength) {
+                    best = score;
+                    forwardLength = i;
+                }
+            }
+
+            Index backwardLength = 0;
+            if (scan < newSize) {
+                for (Index i = 1, score = 0, best = 0; scan >= lastScan + i && position >= i; i++) {
+                    if (old[position - i] == current[scan - i]) score++;
+                    if (score * 2 - i > best * 2 - backwardLength) {
+                        best = score;
+                        backwardLength = i;
+                    }
+                }
+            }
+
+            if (lastScan + forwardLength > scan - backwardLength) {
+                Index overlap = (lastScan + forwardLength) - (scan - backwardLength);
+                Index score = 0, best = 0, split = 0;
+                for (Index i = 0; i < overlap; i++) {
+                    if (current[lastScan + forwardLength - overlap + i] ==
+                        old[lastPosition + forwardLength - overlap + i]) {
+                        score++;
+                    }
+                    if (current[scan - backwardLength + i] == old[position - backwardLength + i]) {
+                        score--;
+                    }
+                    if (score > best) {
+                        best = score;
+                        split = i + 1;
+                    }
+                }
+                forwardLength += split - overlap;
+                backwardLength -= split;
+            }
+
+            Index extraLength = (scan - backwardLength) - (lastScan + forwardLength);
+            Index seek = (position - backwardLength) - (lastPosition + forwardLength);
+
+            appendLe32(patch, static_cast<uint32_t>(forwardLength));
+            appendLe32(patch, static_cast<uint32_t>(extraLength));
+            appendLe32(patch, static_cast<uint32_t>(static_cast<int32_t>(seek)));
+            for (Index i = 0; i < forwardLength; i++) {
+                patch.push_back(static_cast<uint8_t>(current[lastScan + i] - old[lastPosition + i]));
+            }
+            patch.insert(patch.end(), current + lastScan + forwardLength, current + lastScan + forwardLength + extraLength);
+
+            lastScan = scan - backwardLength;
+            lastPosition = position - backwardLength;
+            lastOffset = position - scan;
+        }
+
+        return patch;
+    }
+}
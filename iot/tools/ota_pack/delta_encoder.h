@@ -0,0 +1,14 @@
+#ifndef DELTA_ENCODER_H
+#define DELTA_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Host-side patch generator til delta OTA. Samme matchning som bsdiff 4.3 (suffix array over basen, tilnærmede
+// matches udvides i begge retninger), men skrevet i DeltaPatcher's streaming format i stedet for bzip2 blokke.
+namespace DeltaEncoder {
+    std::vector<uint8_t> diff(const uint8_t* base, size_t baseSize, const uint8_t* image, size_t imageSize);
+}
+
+#endif
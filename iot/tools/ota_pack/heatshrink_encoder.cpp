@@ -0,0 +1,111 @@
+#include "heatshrink_encoder.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t HASH_BITS = 16;
+    constexpr uint32_t MAX_CHAIN = 256;
+    constexpr int32_t NO_POSITION = -1;
+
+    class BitWriter {
+      public:
+        explicit BitWriter(std::vector<uint8_t>& out) : _out(out) {}
+
+        void write(uint32_t value, uint8_t count) {
+            for (int bit = count - 1; bit >= 0; bit--) {
+                _current = static_cast<uint8_t>((_current << 1) | ((value >> bit) & 1));
+                if (++_bits == 8) {
+                    _out.push_back(_current);
+                    _current = 0;
+                    _bits = 0;
+                }
+            }
+        }
+
+        // Sidste byte fyldes op med nul bits, som dekoderen ignorerer
+        void flush() {
+            if (_bits > 0) {
+                _out.push_back(static_cast<uint8_t>(_current << (8 - _bits)));
+                _current = 0;
+                _bits = 0;
+            }
+        }
+
+      private:
+        std::vector<uint8_t>& _out;
+        uint8_t _current = 0;
+        uint8_t _bits = 0;
+    };
+
+    inline uint32_t hashAt(const uint8_t* data) {
+        return ((data[0] << 8) | data[1]) & ((1u << HASH_BITS) - 1);
+    }
+}
+
+namespace HeatshrinkEncoder {
+    std::vector<uint8_t> encode(const uint8_t* data, size_t length, uint8_t windowBits, uint8_t lookaheadBits) {
+        std::vector<uint8_t> out;
+        out.reserve(length / 2);
+        BitWriter writer(out);
+
+        const size_t windowSize = size_t(1) << windowBits;
+        const size_t maxMatch = size_t(1) << lookaheadBits;
+        // En backref koster 1 + W + L bits mod 9 pr. literal
+        const size_t minMatch = (1 + windowBits + lookaheadBits) / 9 + 1;
+
+        std::vector<int32_t> heads(size_t(1) << HASH_BITS, NO_POSITION);
+        std::vector<int32_t> previous(length, NO_POSITION);
+
+        auto insert = [&](size_t position) {
+            if (position + 1 < length) {
+                uint32_t hash = hashAt(data + position);
+                previous[position] = heads[hash];
+                heads[hash] = static_cast<int32_t>(position);
+            }
+        };
+
+        size_t position = 0;
+        while (position < length) {
+            size_t bestLength = 0;
+            size_t bestOffset = 0;
+            size_t limit = std::min(maxMatch, length - position);
+
+            if (limit >= minMatch && position + 1 < length) {
+                int32_t candidate = heads[hashAt(data + position)];
+                for (uint32_t chain = 0; candidate != NO_POSITION && chain < MAX_CHAIN; chain++) {
+                    size_t offset = position - candidate;
+                    if (offset > windowSize) break;
+
+                    size_t matchLength = 0;
+                    while (matchLength < limit && data[candidate + matchLength] == data[position + matchLength]) {
+                        matchLength++;
+                    }
+                    if (matchLength > bestLength) {
+                        bestLength = matchLength;
+                        bestOffset = offset;
+                        if (matchLength == limit) break;
+                    }
+                    candidate = previous[candidate];
+                }
+            }
+
+            if (bestLength >= minMatch) {
+                writer.write(0, 1);
+                writer.write(static_cast<uint32_t>(bestOffset - 1), windowBits);
+                writer.write(static_cast<uint32_t>(bestLength - 1), lookaheadBits);
+                for (size_t i = 0; i < bestLength; i++) {
+                    insert(position + i);
+                }
+                position += bestLength;
+            } else {
+                writer.write(1, 1);
+                writer.write(data[position], 8);
+                insert(position);
+                position++;
+            }
+        }
+
+        writer.flush();
+        return out;
+    }
+}
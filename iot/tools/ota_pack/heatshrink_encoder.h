@@ -0,0 +1,14 @@
+#ifndef HEATSHRINK_ENCODER_H
+#define HEATSHRINK_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Host-side heatshrink (LZSS) encoder til OTA images. Output er kompatibelt med `heatshrink -e -w -l`
+// og HeatshrinkDecoder i firmwaren. Grådig matchning med hash kæder; hastighed betyder mindre end ratio her.
+namespace HeatshrinkEncoder {
+    std::vector<uint8_t> encode(const uint8_t* data, size_t length, uint8_t windowBits, uint8_t lookaheadBits);
+}
+
+#endif
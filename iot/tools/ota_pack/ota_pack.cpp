@@ -0,0 +1,229 @@
+// Pakker firmware.bin til en komprimeret OTA overførsel og udskriver felterne til ota/start beskeden.
+// Med --base laves i stedet en delta patch mod den firmware enheden kører nu, og med --key signeres imagets
+// SHA-256 med Ed25519.
+//
+// Brug: ota_pack <firmware.bin> <output> [--window=N] [--lookahead=N] [--base=<gammel.bin> --base-version=V]
+//                [--key=<privat.key>]
+//       ota_pack --genkey <privat.key>     Laver et nøglepar og udskriver public key til OTA_SIGNING_PUBLIC_KEY
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "delta_encoder.h"
+#include "heatshrink_encoder.h"
+#include "network/crc32.h"
+#include "network/delta_patcher.h"
+#include "network/ed25519.h"
+#include "network/heatshrink_decoder.h"
+#include "network/mqtt_protocol.h"
+#include "network/sha256.h"
+
+namespace {
+    constexpr uint8_t DEFAULT_WINDOW_BITS = 11;
+    constexpr uint8_t DEFAULT_LOOKAHEAD_BITS = 4;
+    // Diff bytes er mest lange nul-serier; lange backrefs komprimerer dem langt bedre
+    constexpr uint8_t DEFAULT_DELTA_LOOKAHEAD_BITS = 8;
+
+    // DeltaPatcher læser basen gennem esp_partition_read; i værktøjet ligger den i hukommelsen
+    const std::vector<uint8_t>* basePartitionData = nullptr;
+    esp_partition_t basePartition = {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, 0, 0, "base", false};
+
+    bool readFile(const char* path, std::vector<uint8_t>& data) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool writeFile(const char* path, const std::vector<uint8_t>& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+        return static_cast<bool>(out);
+    }
+
+    std::string toHex(const uint8_t* data, size_t length) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        for (size_t i = 0; i < length; i++) {
+            hex += digits[data[i] >> 4];
+            hex += digits[data[i] & 0x0F];
+        }
+        return hex;
+    }
+
+    // Nøglefilen er seedet som 64 hex tegn, så den kan ligge som en CI secret
+    bool readKey(const char* path, uint8_t seed[Ed25519::SEED_SIZE]) {
+        std::vector<uint8_t> text;
+        if (!readFile(path, text)) return false;
+        while (!text.empty() && isspace(text.back())) text.pop_back();
+        if (text.size() != Ed25519::SEED_SIZE * 2) return false;
+        for (size_t i = 0; i < Ed25519::SEED_SIZE; i++) {
+            char byte[3] = {static_cast<char>(text[2 * i]), static_cast<char>(text[2 * i + 1]), 0};
+            char* end;
+            seed[i] = static_cast<uint8_t>(strtoul(byte, &end, 16));
+            if (*end != 0) return false;
+        }
+        return true;
+    }
+
+    int generateKey(const char* path) {
+        uint8_t seed[Ed25519::SEED_SIZE];
+        std::ifstream random("/dev/urandom", std::ios::binary);
+        if (!random.read(reinterpret_cast<char*>(seed), sizeof(seed))) {
+            fprintf(stderr, "cannot read /dev/urandom\n");
+            return 1;
+        }
+        std::string hex = toHex(seed, sizeof(seed)) + "\n";
+        if (!writeFile(path, std::vector<uint8_t>(hex.begin(), hex.end()))) {
+            fprintf(stderr, "cannot write %s\n", path);
+            return 1;
+        }
+
+        uint8_t publicKey[Ed25519::PUBLIC_KEY_SIZE];
+        Ed25519::derivePublicKey(seed, publicKey);
+        printf("OTA_SIGNING_PUBLIC_KEY=%s\n", toHex(publicKey, sizeof(publicKey)).c_str());
+        return 0;
+    }
+
+    // Pakker ud med firmwarens egen dekoder og patcher, så et image der ikke kan installeres aldrig sendes
+    bool roundTrip(const std::vector<uint8_t>& image, const std::vector<uint8_t>& packed, uint8_t windowBits,
+                   uint8_t lookaheadBits, const std::vector<uint8_t>* base) {
+        HeatshrinkDecoder decoder;
+        DeltaPatcher patcher;
+        std::vector<uint8_t> unpacked;
+
+        auto imageSink = [&unpacked](const uint8_t* data, size_t length) {
+            unpacked.insert(unpacked.end(), data, data + length);
+            return true;
+        };
+        auto patchSink = [&](const uint8_t* data, size_t length) {
+            return base ? patcher.write(data, length, imageSink) : imageSink(data, length);
+        };
+
+        if (base) {
+            basePartitionData = base;
+            basePartition.size = base->size();
+            if (!patcher.begin(&basePartition, base->size(), Crc32::update(0, base->data(), base->size()))) {
+                return false;
+            }
+        }
+
+        bool ok = decoder.begin(windowBits, lookaheadBits) && decoder.decode(packed.data(), packed.size(), patchSink) &&
+                  decoder.finish(patchSink) && (!base || patcher.finish(imageSink));
+        return ok && unpacked == image;
+    }
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size) {
+    if (partition != &basePartition || !basePartitionData || srcOffset + size > basePartitionData->size()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, basePartitionData->data() + srcOffset, size);
+    return ESP_OK;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "--genkey") == 0) {
+        return generateKey(argv[2]);
+    }
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <firmware.bin> <output> [--window=N] [--lookahead=N] "
+                        "[--base=<old.bin> --base-version=V] [--key=<private.key>]\n"
+                        "       %s --genkey <private.key>\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    uint8_t windowBits = DEFAULT_WINDOW_BITS;
+    int lookaheadBits = -1;
+    const char* basePath = nullptr;
+    std::string baseVersion;
+    const char* keyPath = nullptr;
+    for (int i = 3; i < argc; i++) {
+        if (strncmp(argv[i], "--window=", 9) == 0) {
+            windowBits = static_cast<uint8_t>(atoi(argv[i] + 9));
+        } else if (strncmp(argv[i], "--lookahead=", 12) == 0) {
+            lookaheadBits = atoi(argv[i] + 12);
+        } else if (strncmp(argv[i], "--base=", 7) == 0) {
+            basePath = argv[i] + 7;
+        } else if (strncmp(argv[i], "--base-version=", 15) == 0) {
+            baseVersion = argv[i] + 15;
+        } else if (strncmp(argv[i], "--key=", 6) == 0) {
+            keyPath = argv[i] + 6;
+        } else {
+            fprintf(stderr, "unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (lookaheadBits < 0) {
+        lookaheadBits = basePath ? DEFAULT_DELTA_LOOKAHEAD_BITS : DEFAULT_LOOKAHEAD_BITS;
+    }
+
+    if (!HeatshrinkDecoder::validParameters(windowBits, static_cast<uint8_t>(lookaheadBits))) {
+        fprintf(stderr, "invalid window/lookahead: %u/%d\n", windowBits, lookaheadBits);
+        return 2;
+    }
+
+    std::vector<uint8_t> image;
+    if (!readFile(argv[1], image) || image.empty()) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    uint8_t seed[Ed25519::SEED_SIZE];
+    if (keyPath && !readKey(keyPath, seed)) {
+        fprintf(stderr, "cannot read key %s\n", keyPath);
+        return 1;
+    }
+
+    std::vector<uint8_t> base;
+    if (basePath && (!readFile(basePath, base) || base.empty())) {
+        fprintf(stderr, "cannot read %s\n", basePath);
+        return 1;
+    }
+
+    std::vector<uint8_t> stream = basePath ? DeltaEncoder::diff(base.data(), base.size(), image.data(), image.size())
+                                           : image;
+    std::vector<uint8_t> packed =
+        HeatshrinkEncoder::encode(stream.data(), stream.size(), windowBits, static_cast<uint8_t>(lookaheadBits));
+    if (!roundTrip(image, packed, windowBits, static_cast<uint8_t>(lookaheadBits), basePath ? &base : nullptr)) {
+        fprintf(stderr, "round trip verification failed\n");
+        return 1;
+    }
+    if (!writeFile(argv[2], packed)) {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(stderr, "%zu -> %zu bytes (%.1f%%)\n", image.size(), packed.size(), 100.0 * packed.size() / image.size());
+
+    using namespace MqttProtocol::OtaFields;
+    auto field = [](const char* name, const std::string& value) { return "\"" + std::string(name) + "\":" + value; };
+    auto quoted = [](const std::string& value) { return "\"" + value + "\""; };
+
+    std::string json = "{" + field(SIZE, std::to_string(packed.size())) + "," +
+                       field(IMAGE_SIZE, std::to_string(image.size())) + "," +
+                       field(CRC32, std::to_string(Crc32::update(0, image.data(), image.size()))) + "," +
+                       field(COMPRESSION, quoted(CompressionValues::HEATSHRINK)) + "," +
+                       field(WINDOW_BITS, std::to_string(windowBits)) + "," +
+                       field(LOOKAHEAD_BITS, std::to_string(lookaheadBits));
+    if (basePath) {
+        json += "," + field(PATCH, quoted(PatchValues::BSDIFF)) + "," + field(BASE_VERSION, quoted(baseVersion)) + "," +
+                field(BASE_SIZE, std::to_string(base.size())) + "," +
+                field(BASE_CRC32, std::to_string(Crc32::update(0, base.data(), base.size())));
+    }
+    if (keyPath) {
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        uint8_t signature[Ed25519::SIGNATURE_SIZE];
+        Sha256::hash(image.data(), image.size(), digest);
+        Ed25519::sign(seed, digest, sizeof(digest), signature);
+        json += "," + field(SIGNATURE, quoted(toHex(signature, sizeof(signature))));
+    }
+    printf("%s}\n", json.c_str());
+    return 0;
+}